@@ -0,0 +1,109 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares hal::unpack_bits and hal::pack_bits against unpacking one sample
+// at a time with hal::bit_extract, for 12-bit and 24-bit samples packed most
+// significant bit first, as they arrive from an SPI ADC.
+
+#include <libhal-util/bit.hpp>
+#include <libhal-util/bit_pack.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <vector>
+
+namespace {
+constexpr size_t sample_count = 4096;
+constexpr int repetitions = 20'000;
+
+/// One sample at a time: gather the bytes it spans, then bit_extract it
+template<size_t Width>
+void scalar_unpack(std::span<const hal::byte> p_packed,
+                   std::span<std::uint32_t> p_values)
+{
+  for (size_t index = 0; index < p_values.size(); index++) {
+    const auto bit = index * Width;
+    const auto first_byte = bit / 8;
+    const auto last_byte = (bit + Width - 1) / 8;
+    std::uint32_t word = 0;
+    for (auto byte_index = first_byte; byte_index <= last_byte; byte_index++) {
+      word = (word << 8) | p_packed[byte_index];
+    }
+    const auto bits_in_word = static_cast<std::uint32_t>(
+      (last_byte - first_byte + 1) * 8);
+    const auto position =
+      static_cast<std::uint32_t>(bits_in_word - bit % 8 - Width);
+    p_values[index] = hal::bit_extract(
+      hal::bit_mask{ .position = position, .width = Width }, word);
+  }
+}
+
+template<typename Function>
+double nanoseconds_per_sample(Function p_function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (int repetition = 0; repetition < repetitions; repetition++) {
+    p_function();
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count() / (static_cast<double>(repetitions) * sample_count);
+}
+
+template<size_t Width>
+bool run()
+{
+  std::vector<hal::byte> packed(hal::packed_size<Width>(sample_count));
+  std::vector<std::uint32_t> values(sample_count);
+  std::vector<std::uint32_t> expected(sample_count);
+  std::uint32_t state = 1;
+  for (auto& byte : packed) {
+    state = state * 1'664'525U + 1'013'904'223U;
+    byte = static_cast<hal::byte>(state >> 24);
+  }
+
+  // Keep the compiler from specializing on the contents of the buffers
+  hal::byte* volatile packed_pointer = packed.data();
+  std::span<const hal::byte> input(packed_pointer, packed.size());
+
+  const auto scalar = nanoseconds_per_sample(
+    [&]() { scalar_unpack<Width>(input, expected); });
+  const auto unpack = nanoseconds_per_sample(
+    [&]() { hal::unpack_bits<Width>(input, std::span(values)); });
+  const auto pack = nanoseconds_per_sample([&]() {
+    hal::pack_bits<Width>(std::span<const std::uint32_t>(values),
+                          std::span(packed_pointer, packed.size()));
+  });
+
+  std::printf("%2zu-bit bit_extract loop: %5.2f ns/sample\n", Width, scalar);
+  std::printf("%2zu-bit unpack_bits:      %5.2f ns/sample (%.1fx)\n",
+              Width,
+              unpack,
+              scalar / unpack);
+  std::printf("%2zu-bit pack_bits:        %5.2f ns/sample\n", Width, pack);
+  return values == expected;
+}
+}  // namespace
+
+int main()
+{
+  const bool matches = run<12>() && run<24>();
+  if (!matches) {
+    std::fprintf(stderr, "unpack_bits does not match bit_extract\n");
+    return 1;
+  }
+  return 0;
+}
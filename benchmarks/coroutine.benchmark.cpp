@@ -0,0 +1,208 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Reports the arena space used by hal::task frames, and compares parsing
+// "$<number>," records with a hal::task against the same protocol written as a
+// hand-written state machine around hal::skip_past and hal::read_uint32.
+// The serial port hands out a few bytes per read so both versions suspend and
+// resume many times.
+
+#include <libhal-util/coroutine.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+
+#include <libhal-util/as_bytes.hpp>
+#include <libhal-util/serial_coroutines.hpp>
+
+namespace {
+using namespace std::literals;
+
+constexpr std::uint32_t record_count = 200'000;
+constexpr std::string_view record = "noise$1234,"sv;
+constexpr size_t bytes_per_read = 3;
+
+class looping_serial : public hal::serial
+{
+public:
+  hal::status driver_configure(const settings&) override
+  {
+    return {};
+  }
+
+  hal::result<write_t> driver_write(std::span<const hal::byte> p_data) override
+  {
+    return write_t{ p_data };
+  }
+
+  hal::result<read_t> driver_read(std::span<hal::byte> p_data) override
+  {
+    // Every other read finds the port empty, so workers return in_progress
+    m_empty = !m_empty;
+    const auto count = m_empty ? 0 : std::min(p_data.size(), bytes_per_read);
+    for (size_t index = 0; index < count; index++) {
+      p_data[index] = static_cast<hal::byte>(record[m_position]);
+      m_position = (m_position + 1) % record.size();
+    }
+    return read_t{ .data = p_data.first(count), .available = 0, .capacity = 0 };
+  }
+
+  hal::result<flush_t> driver_flush() override
+  {
+    return flush_t{};
+  }
+
+private:
+  size_t m_position = 0;
+  bool m_empty = false;
+};
+
+hal::task<std::uint32_t> read_record(hal::serial& p_serial)
+{
+  auto found =
+    co_await hal::until_done(hal::skip_past(p_serial, hal::as_bytes("$"sv)));
+  if (!found) {
+    co_return found.error();
+  }
+  hal::read_uint32 reader(p_serial);
+  auto parsed = co_await hal::until_done(reader);
+  if (!parsed) {
+    co_return parsed.error();
+  }
+  co_return reader.get().value();
+}
+
+hal::task<std::uint64_t> sum_records(hal::coroutine_arena&,
+                                     hal::serial& p_serial,
+                                     std::uint32_t p_count)
+{
+  std::uint64_t sum = 0;
+  for (std::uint32_t index = 0; index < p_count; index++) {
+    auto value = co_await read_record(p_serial);
+    if (!value) {
+      co_return value.error();
+    }
+    sum += value.value();
+  }
+  co_return sum;
+}
+
+/// The same protocol as sum_records(), written without coroutines
+class sum_records_machine
+{
+public:
+  sum_records_machine(hal::serial& p_serial, std::uint32_t p_count)
+    : m_serial(&p_serial)
+    , m_remaining(p_count)
+  {
+  }
+
+  hal::result<hal::work_state> operator()()
+  {
+    while (m_remaining > 0) {
+      if (m_state == state::skip) {
+        auto found = HAL_CHECK(m_skip());
+        if (!hal::finished(found)) {
+          return found;
+        }
+        m_reader = hal::read_uint32(*m_serial);
+        m_state = state::read;
+      }
+
+      auto parsed = HAL_CHECK(m_reader());
+      if (!hal::finished(parsed)) {
+        return parsed;
+      }
+      m_sum += m_reader.get().value();
+      m_skip = hal::skip_past(*m_serial, hal::as_bytes("$"sv));
+      m_state = state::skip;
+      m_remaining--;
+    }
+    return hal::work_state::finished;
+  }
+
+  std::uint64_t sum() const
+  {
+    return m_sum;
+  }
+
+private:
+  enum class state
+  {
+    skip,
+    read,
+  };
+
+  hal::serial* m_serial;
+  hal::skip_past m_skip{ *m_serial, hal::as_bytes("$"sv) };
+  hal::read_uint32 m_reader{ *m_serial };
+  std::uint32_t m_remaining;
+  std::uint64_t m_sum = 0;
+  state m_state = state::skip;
+};
+
+template<typename Function>
+double time_per_record(Function p_function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  p_function();
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count() / record_count;
+}
+}  // namespace
+
+int main()
+{
+  alignas(std::max_align_t) std::array<hal::byte, 1024> memory{};
+  hal::coroutine_arena arena(memory);
+  hal::coroutine_executor executor(arena);
+  looping_serial serial;
+
+  std::uint64_t task_sum = 0;
+  size_t outer_frame = 0;
+  const auto task_time = time_per_record([&]() {
+    auto sum = sum_records(arena, serial, record_count);
+    outer_frame = arena.used();
+    (void)executor.spawn(sum);
+    while (!sum.done()) {
+      executor.run_once();
+    }
+    task_sum = sum.get().value();
+  });
+
+  std::uint64_t machine_sum = 0;
+  const auto machine_time = time_per_record([&]() {
+    sum_records_machine machine(serial, record_count);
+    while (!hal::terminated(machine().value())) {
+    }
+    machine_sum = machine.sum();
+  });
+
+  std::printf("sum_records frame:          %4zu bytes\n", outer_frame);
+  std::printf("with read_record awaited:   %4zu bytes\n", arena.peak());
+  std::printf("hand written state machine: %4zu bytes\n",
+              sizeof(sum_records_machine));
+  std::printf("task:          %6.1f ns/record (sum %llu)\n",
+              task_time,
+              static_cast<unsigned long long>(task_sum));
+  std::printf("state machine: %6.1f ns/record (sum %llu)\n",
+              machine_time,
+              static_cast<unsigned long long>(machine_sum));
+  return task_sum == machine_sum ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput of hal::byteswap_copy and hal::load_be for 16, 32 and 64-bit
+// elements, against assembling each element from its bytes one at a time as
+// drivers do by hand.
+
+#include <libhal-util/endian.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <vector>
+
+namespace {
+constexpr size_t buffer_bytes = 16 * 1024;
+constexpr int repetitions = 50'000;
+
+template<typename T>
+void manual_load_be(std::span<const hal::byte> p_bytes, std::span<T> p_values)
+{
+  for (size_t index = 0; index < p_values.size(); index++) {
+    T value = 0;
+    for (size_t byte = 0; byte < sizeof(T); byte++) {
+      value = static_cast<T>((value << 8) | p_bytes[index * sizeof(T) + byte]);
+    }
+    p_values[index] = value;
+  }
+}
+
+template<typename Function>
+double gigabytes_per_second(Function p_function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (int repetition = 0; repetition < repetitions; repetition++) {
+    p_function();
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return (static_cast<double>(buffer_bytes) * repetitions) / elapsed.count();
+}
+
+template<typename T>
+bool run()
+{
+  constexpr size_t count = buffer_bytes / sizeof(T);
+  std::vector<hal::byte> bytes(buffer_bytes);
+  std::vector<T> values(count);
+  std::vector<T> swapped(count);
+  std::vector<T> expected(count);
+  for (size_t index = 0; index < bytes.size(); index++) {
+    bytes[index] = static_cast<hal::byte>(index * 7);
+  }
+
+  // Keep the compiler from specializing on the contents of the buffers
+  hal::byte* volatile bytes_pointer = bytes.data();
+  std::span<const hal::byte> input(bytes_pointer, bytes.size());
+
+  const auto manual = gigabytes_per_second(
+    [&]() { manual_load_be<T>(input, std::span(expected)); });
+  const auto load = gigabytes_per_second(
+    [&]() { hal::load_be<T>(input, std::span(values)); });
+  const auto swap = gigabytes_per_second(
+    [&]() { hal::byteswap_copy<T>(values, std::span(swapped)); });
+
+  std::printf("%2zu-bit manual shifts:  %6.2f GB/s\n", sizeof(T) * 8, manual);
+  std::printf("%2zu-bit load_be:        %6.2f GB/s\n", sizeof(T) * 8, load);
+  std::printf("%2zu-bit byteswap_copy:  %6.2f GB/s\n", sizeof(T) * 8, swap);
+  return values == expected;
+}
+}  // namespace
+
+int main()
+{
+  const bool matches =
+    run<std::uint16_t>() && run<std::uint32_t>() && run<std::uint64_t>();
+  if (!matches) {
+    std::fprintf(stderr, "load_be does not match manual conversion\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,199 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// End to end benchmarks of the serial utilities over a Linux pseudo-terminal:
+//
+// - throughput of hal::write from one end of the pair to the other
+// - latency of receiving a line with hal::read_upto and hal::read_upto_chunked
+// - latency of extracting fields from a line as it arrives, with a
+//   hal::stream_pipeline of hal::stream_find and hal::stream_parse_number
+//
+// Build with LIBHAL_UTIL_BUILD_HOST and LIBHAL_UTIL_BUILD_BENCHMARKS enabled.
+
+#include <libhal-util/host/pty_serial.hpp>
+#include <libhal-util/host/steady_clock.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <libhal-util/as_bytes.hpp>
+#include <libhal-util/profile.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/serial_coroutines.hpp>
+#include <libhal-util/streams.hpp>
+#include <libhal-util/timeout.hpp>
+
+namespace {
+using namespace std::literals;
+
+constexpr size_t throughput_bytes = 64 * 1024 * 1024;
+constexpr size_t write_size = 4096;
+constexpr int line_count = 20'000;
+constexpr std::string_view line = "$GPGGA,123519,4807.038,N,01131.000,E*47\n"sv;
+
+hal::status measure_throughput(hal::pty_serial& p_writer,
+                               hal::pty_serial& p_reader,
+                               hal::steady_clock& p_clock)
+{
+  std::vector<hal::byte> chunk(write_size, 0x55);
+  hal::status writer_status;
+  hal::stopwatch watch(p_clock);
+
+  std::thread writer([&]() {
+    writer_status = [&]() -> hal::status {
+      for (size_t sent = 0; sent < throughput_bytes; sent += chunk.size()) {
+        HAL_CHECK(hal::write(p_writer, chunk));
+      }
+      return hal::success();
+    }();
+  });
+
+  std::array<hal::byte, write_size> buffer{};
+  size_t received = 0;
+  auto reader_status = [&]() -> hal::status {
+    while (received < throughput_bytes) {
+      if (!HAL_CHECK(p_reader.wait_readable(1s))) {
+        break;
+      }
+      received += HAL_CHECK(p_reader.read(buffer)).data.size();
+    }
+    return hal::success();
+  }();
+  const auto elapsed = watch.elapsed();
+
+  // Join before returning any error, as destroying a joinable thread calls
+  // std::terminate. The writer gives up within a second once nothing reads.
+  writer.join();
+  HAL_CHECK(std::move(reader_status));
+  HAL_CHECK(std::move(writer_status));
+
+  const auto seconds = static_cast<double>(elapsed) / 1e9;
+  std::printf("hal::write:          %7.1f MiB/s (%zu MiB)\n",
+              static_cast<double>(received) / (1024 * 1024) / seconds,
+              received / (1024 * 1024));
+  return hal::success();
+}
+
+template<typename Reader>
+hal::status measure_line_latency(const char* p_name,
+                                 hal::pty_serial& p_writer,
+                                 hal::pty_serial& p_reader,
+                                 hal::steady_clock& p_clock)
+{
+  hal::latency_histogram<> latency;
+  std::array<hal::byte, 128> buffer{};
+
+  for (int index = 0; index < line_count; index++) {
+    hal::stopwatch watch(p_clock);
+    HAL_CHECK(hal::write(p_writer, line));
+
+    Reader reader(p_reader, hal::as_bytes("\n"sv), buffer);
+    while (true) {
+      const auto state = HAL_CHECK(reader());
+      if (hal::terminated(state)) {
+        break;
+      }
+      HAL_CHECK(p_reader.wait_readable(1s));
+    }
+    latency.record(watch.elapsed());
+  }
+
+  std::printf("%-20s p50 %6llu ns, p99 %6llu ns, max %7llu ns\n",
+              p_name,
+              static_cast<unsigned long long>(latency.percentile(500)),
+              static_cast<unsigned long long>(latency.percentile(990)),
+              static_cast<unsigned long long>(latency.max()));
+  return hal::success();
+}
+
+hal::status measure_stream_latency(hal::pty_serial& p_writer,
+                                   hal::pty_serial& p_reader,
+                                   hal::steady_clock& p_clock)
+{
+  hal::latency_histogram<> latency;
+  std::array<hal::byte, 128> buffer{};
+
+  for (int index = 0; index < line_count; index++) {
+    hal::stream_find find_sentence(hal::as_bytes("$GPGGA,"sv));
+    hal::stream_parse_number<std::uint32_t> parse_time;
+    hal::stream_parse_number<float> parse_latitude;
+    hal::stream_pipeline fields(find_sentence, parse_time, parse_latitude);
+
+    hal::stopwatch watch(p_clock);
+    HAL_CHECK(hal::write(p_writer, line));
+
+    while (fields.state() == hal::work_state::in_progress) {
+      const auto received = HAL_CHECK(p_reader.read(buffer)).data;
+      if (received.empty()) {
+        HAL_CHECK(p_reader.wait_readable(1s));
+        continue;
+      }
+      std::span<const hal::byte>(received) | fields;
+    }
+    latency.record(watch.elapsed());
+
+    // Discard the rest of the line so the next measurement starts with an
+    // empty buffer. Anything that arrives later is skipped by the next find.
+    while (HAL_CHECK(p_reader.read(buffer)).data.size() != 0) {
+      continue;
+    }
+
+    if (!hal::finished(fields.state()) || parse_time.value() != 123'519 ||
+        parse_latitude.value() < 4807.0f || parse_latitude.value() > 4807.1f) {
+      return hal::new_error(std::errc::bad_message);
+    }
+  }
+
+  std::printf("%-20s p50 %6llu ns, p99 %6llu ns, max %7llu ns\n",
+              "stream_pipeline:",
+              static_cast<unsigned long long>(latency.percentile(500)),
+              static_cast<unsigned long long>(latency.percentile(990)),
+              static_cast<unsigned long long>(latency.max()));
+  return hal::success();
+}
+
+hal::status run()
+{
+  hal::host_steady_clock clock;
+  auto controller = HAL_CHECK(hal::pty_serial::create());
+  auto device = HAL_CHECK(controller.open_peer());
+  std::printf("pseudo-terminal: %.*s\n",
+              static_cast<int>(controller.peer_path().size()),
+              controller.peer_path().data());
+
+  HAL_CHECK(measure_throughput(device, controller, clock));
+  HAL_CHECK(measure_line_latency<hal::read_upto>(
+    "hal::read_upto:", controller, device, clock));
+  HAL_CHECK(measure_line_latency<hal::read_upto_chunked>(
+    "read_upto_chunked:", controller, device, clock));
+  HAL_CHECK(measure_stream_latency(controller, device, clock));
+  return hal::success();
+}
+}  // namespace
+
+int main()
+{
+  auto status = run();
+  if (!status) {
+    std::fprintf(stderr, "benchmark failed\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,128 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Time per free and allocate pair of a CAN frame sized object, with a working
+// set of live objects freed in pseudo random order, for hal::object_pool,
+// hal::atomic_object_pool, malloc/free and
+// std::pmr::unsynchronized_pool_resource.
+
+#include <libhal-util/object_pool.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <new>
+
+namespace {
+constexpr size_t capacity = 64;
+constexpr size_t live_objects = 48;
+constexpr int iterations = 20'000'000;
+
+struct frame
+{
+  std::uint32_t id = 0;
+  std::uint8_t length = 0;
+  bool is_remote_request = false;
+  std::array<std::uint8_t, 8> payload{};
+};
+
+volatile std::uint32_t sink = 0;
+
+template<typename Owner, typename Make, typename Drop>
+double nanoseconds_per_pair(Make p_make, Drop p_drop)
+{
+  std::array<Owner, live_objects> owners{};
+  for (size_t index = 0; index < owners.size(); index++) {
+    owners[index] = p_make(static_cast<std::uint32_t>(index));
+  }
+
+  std::uint32_t state = 0x1234'5678;
+  std::uint32_t checksum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    state = state * 1'664'525U + 1'013'904'223U;
+    auto& owner = owners[(state >> 16) % live_objects];
+    p_drop(owner);
+    owner = p_make(state);
+    checksum += owner->id;
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  for (auto& owner : owners) {
+    p_drop(owner);
+  }
+  sink = checksum;
+  return elapsed.count() / iterations;
+}
+
+template<typename Pool>
+double pool_nanoseconds()
+{
+  static Pool pool;
+  using handle = typename Pool::handle;
+  return nanoseconds_per_pair<handle>(
+    [](std::uint32_t p_id) { return pool.emplace(frame{ .id = p_id }); },
+    [](handle& p_handle) { p_handle.reset(); });
+}
+
+double malloc_nanoseconds()
+{
+  return nanoseconds_per_pair<frame*>(
+    [](std::uint32_t p_id) {
+      void* memory = std::malloc(sizeof(frame));
+      if (memory == nullptr) {
+        std::abort();
+      }
+      return ::new (memory) frame{ .id = p_id };
+    },
+    [](frame*& p_frame) {
+      std::destroy_at(p_frame);
+      std::free(p_frame);
+      p_frame = nullptr;
+    });
+}
+
+double pmr_nanoseconds()
+{
+  std::pmr::unsynchronized_pool_resource resource;
+  return nanoseconds_per_pair<frame*>(
+    [&resource](std::uint32_t p_id) {
+      void* memory = resource.allocate(sizeof(frame), alignof(frame));
+      return ::new (memory) frame{ .id = p_id };
+    },
+    [&resource](frame*& p_frame) {
+      std::destroy_at(p_frame);
+      resource.deallocate(p_frame, sizeof(frame), alignof(frame));
+      p_frame = nullptr;
+    });
+}
+}  // namespace
+
+int main()
+{
+  std::printf("hal::object_pool:                  %6.2f ns\n",
+              pool_nanoseconds<hal::object_pool<frame, capacity>>());
+  std::printf("hal::atomic_object_pool:           %6.2f ns\n",
+              pool_nanoseconds<hal::atomic_object_pool<frame, capacity>>());
+  std::printf("malloc/free:                       %6.2f ns\n",
+              malloc_nanoseconds());
+  std::printf("pmr::unsynchronized_pool_resource: %6.2f ns\n",
+              pmr_nanoseconds());
+  return 0;
+}
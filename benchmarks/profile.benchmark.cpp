@@ -0,0 +1,103 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cost of HAL_PROBE on top of the work it wraps, split into the
+// cost of recording into the histogram and the cost of the two clock reads.
+// The clock is a free running counter so that its reads are as cheap as a
+// cycle counter register read on a microcontroller.
+
+#include <libhal-util/profile.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+constexpr std::uint32_t iterations = 10'000'000;
+
+class counter_clock : public hal::steady_clock
+{
+private:
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    m_ticks += 7;
+    return uptime_t{ .ticks = m_ticks };
+  }
+
+  std::uint64_t m_ticks = 0;
+};
+
+volatile std::uint32_t sink = 0;
+
+void work(std::uint32_t p_value)
+{
+  sink = sink + p_value;
+}
+
+template<typename Function>
+double nanoseconds_per_iteration(Function p_function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (std::uint32_t index = 0; index < iterations; index++) {
+    p_function(index);
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+}  // namespace
+
+int main()
+{
+  counter_clock concrete_clock;
+  // Hide the concrete type so that uptime() stays a virtual call, as it is
+  // when a driver is handed a hal::steady_clock&
+  hal::steady_clock* volatile clock_pointer = &concrete_clock;
+  hal::steady_clock& clock = *clock_pointer;
+  hal::latency_histogram<> histogram;
+
+  const auto bare = nanoseconds_per_iteration([](std::uint32_t p_index) {
+    work(p_index);
+  });
+
+  const auto record_only =
+    nanoseconds_per_iteration([&histogram](std::uint32_t p_index) {
+      histogram.record(p_index & 0xFFF);
+      work(p_index);
+    });
+
+  histogram.reset();
+  const auto probed =
+    nanoseconds_per_iteration([&histogram, &clock](std::uint32_t p_index) {
+      HAL_PROBE(histogram, clock);
+      work(p_index);
+    });
+
+  std::printf("bare work:         %5.2f ns\n", bare);
+  std::printf("record() only:     %5.2f ns (+%.2f ns)\n",
+              record_only,
+              record_only - bare);
+  std::printf(
+    "HAL_PROBE:         %5.2f ns (+%.2f ns)\n", probed, probed - bare);
+  std::printf("histogram size:    %5zu bytes\n", sizeof(histogram));
+  std::printf("probe p50/p99:     %llu/%llu ticks\n",
+              static_cast<unsigned long long>(histogram.percentile(500)),
+              static_cast<unsigned long long>(histogram.percentile(990)));
+  return 0;
+}
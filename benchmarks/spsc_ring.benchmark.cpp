@@ -0,0 +1,93 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures hal::spsc_ring byte throughput between two threads for several
+// batch sizes. A batch size of 1 uses the single element push().
+// Both sides yield when the ring is full or empty so the benchmark also makes
+// progress on machines with a single core.
+
+#include <libhal-util/spsc_ring.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+namespace {
+constexpr size_t cache_line = 64;
+constexpr size_t mebibyte = 1024 * 1024;
+
+using ring_t = hal::spsc_ring<std::uint8_t, 4096, cache_line>;
+
+template<size_t BatchSize>
+void run()
+{
+  static constexpr size_t total_bytes =
+    (BatchSize == 1 ? 16 : 256) * mebibyte;
+  static ring_t ring;
+  const auto start = std::chrono::steady_clock::now();
+
+  std::thread producer([]() {
+    std::array<std::uint8_t, BatchSize> batch{};
+    size_t sent = 0;
+    while (sent < total_bytes) {
+      size_t pushed = 0;
+      if constexpr (BatchSize == 1) {
+        pushed = ring.push(static_cast<std::uint8_t>(sent)) ? 1 : 0;
+      } else {
+        for (size_t index = 0; index < batch.size(); index++) {
+          batch[index] = static_cast<std::uint8_t>(sent + index);
+        }
+        pushed = ring.push(batch);
+      }
+      if (pushed == 0) {
+        std::this_thread::yield();
+      }
+      sent += pushed;
+    }
+  });
+
+  std::array<std::uint8_t, BatchSize> output{};
+  size_t received = 0;
+  std::uint8_t checksum = 0;
+  while (received < total_bytes) {
+    const auto popped = ring.pop(output);
+    if (popped == 0) {
+      std::this_thread::yield();
+    }
+    for (size_t index = 0; index < popped; index++) {
+      checksum ^= output[index];
+    }
+    received += popped;
+  }
+  producer.join();
+
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  std::printf("batch %5zu: %8.1f MiB/s (checksum %02X)\n",
+              BatchSize,
+              (static_cast<double>(total_bytes) / mebibyte) / elapsed.count(),
+              checksum);
+}
+}  // namespace
+
+int main()
+{
+  run<1>();
+  run<16>();
+  run<256>();
+  run<1024>();
+  return 0;
+}
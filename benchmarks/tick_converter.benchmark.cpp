@@ -0,0 +1,91 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Time per duration to ticks conversion for the paths taken by the steady
+// clock utilities: the original division by hal::wavelength, a
+// hal::tick_converter built for every call (what the overloads without a
+// converter did before), the static hal::tick_converter::to_ticks those
+// overloads use now, and a converter built once and reused.
+
+#include <libhal-util/steady_clock.hpp>
+#include <libhal-util/units.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+constexpr int iterations = 5'000'000;
+
+constexpr std::array<hal::hertz, 4> frequencies{
+  32'768.0f, 12'000'000.0f, 48'000'000.0f, 1e9f
+};
+
+volatile std::uint64_t sink = 0;
+
+template<typename Convert>
+double nanoseconds_per_conversion(hal::hertz p_frequency, Convert p_convert)
+{
+  // Keep the compiler from folding the frequency into the conversion
+  volatile hal::hertz frequency = p_frequency;
+  std::uint64_t checksum = 0;
+  std::uint64_t state = 0x1234'5678;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    state = state * 6'364'136'223'846'793'005ULL + 1'442'695'040'888'963'407ULL;
+    // Durations up to about 18 minutes
+    const auto duration = static_cast<std::int64_t>(state >> 24);
+    checksum += p_convert(frequency, hal::time_duration(duration));
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  sink = checksum;
+  return elapsed.count() / iterations;
+}
+}  // namespace
+
+int main()
+{
+  for (const auto frequency : frequencies) {
+    const auto wavelength = nanoseconds_per_conversion(
+      frequency, [](hal::hertz p_frequency, hal::time_duration p_duration) {
+        using period = hal::time_duration::period;
+        const auto ticks = p_duration / hal::wavelength<period>(p_frequency);
+        return static_cast<std::uint64_t>(ticks);
+      });
+    const auto per_call = nanoseconds_per_conversion(
+      frequency, [](hal::hertz p_frequency, hal::time_duration p_duration) {
+        return hal::tick_converter(p_frequency).to_ticks(p_duration);
+      });
+    const auto uncached = nanoseconds_per_conversion(
+      frequency, [](hal::hertz p_frequency, hal::time_duration p_duration) {
+        return hal::tick_converter::to_ticks(p_frequency, p_duration);
+      });
+    const hal::tick_converter converter(frequency);
+    const auto cached = nanoseconds_per_conversion(
+      frequency, [&converter](hal::hertz, hal::time_duration p_duration) {
+        return converter.to_ticks(p_duration);
+      });
+
+    std::printf("%12.0f Hz\n", static_cast<double>(frequency));
+    std::printf("  duration / wavelength:     %6.2f ns\n", wavelength);
+    std::printf("  converter per call:        %6.2f ns\n", per_call);
+    std::printf("  tick_converter::to_ticks:  %6.2f ns\n", uncached);
+    std::printf("  cached converter:          %6.2f ns\n", cached);
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cost of one millisecond tick for 10 to 100k periodic timers on
+// a hal::timer_wheel against scanning a list of timers every tick. Each
+// timer reschedules itself from its handler with a random period of up to one
+// second, like a retransmit or sensor poll timer. A manual clock is used so
+// only the bookkeeping is measured.
+
+#include <libhal-util/timer_wheel.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <libhal/functional.hpp>
+
+namespace {
+constexpr std::uint64_t tick_count = 10'000;
+constexpr std::uint32_t max_period = 1'000;
+
+using wheel_t = hal::timer_wheel<4, 64>;
+
+struct manual_clock : public hal::steady_clock
+{
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = m_uptime };
+  }
+
+  std::uint64_t m_uptime = 0;
+};
+
+std::vector<std::uint32_t> make_periods(size_t p_count)
+{
+  std::mt19937 random(static_cast<std::mt19937::result_type>(p_count));
+  std::uniform_int_distribution<std::uint32_t> distribution(1, max_period);
+  std::vector<std::uint32_t> periods(p_count);
+  for (auto& period : periods) {
+    period = distribution(random);
+  }
+  return periods;
+}
+
+double run_wheel(const std::vector<std::uint32_t>& p_periods,
+                 std::uint64_t& p_expired)
+{
+  manual_clock clock;
+  wheel_t wheel(clock, std::chrono::milliseconds(1));
+  std::vector<std::unique_ptr<wheel_t::timer>> timers;
+  timers.reserve(p_periods.size());
+
+  for (size_t index = 0; index < p_periods.size(); index++) {
+    const auto interval = std::chrono::milliseconds(p_periods[index]);
+    timers.push_back(std::make_unique<wheel_t::timer>(
+      [&wheel, &timers, index, interval]() {
+        wheel.schedule(*timers[index], interval);
+      }));
+    wheel.schedule(*timers[index], interval);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (std::uint64_t tick = 1; tick <= tick_count; tick++) {
+    clock.m_uptime = tick;
+    p_expired += wheel.poll();
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count() / tick_count;
+}
+
+/// Baseline: every timer is visited on every tick
+struct list_timer
+{
+  hal::callback<void()> handler;
+  std::uint64_t deadline = 0;
+};
+
+double run_list(const std::vector<std::uint32_t>& p_periods,
+                std::uint64_t& p_expired)
+{
+  std::uint64_t now = 0;
+  std::vector<std::unique_ptr<list_timer>> timers;
+  timers.reserve(p_periods.size());
+
+  for (size_t index = 0; index < p_periods.size(); index++) {
+    const auto period = p_periods[index];
+    timers.push_back(std::make_unique<list_timer>());
+    timers.back()->handler = [&now, &timers, index, period]() {
+      timers[index]->deadline = now + period;
+    };
+    timers.back()->deadline = period;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (now = 1; now <= tick_count; now++) {
+    for (auto& timer : timers) {
+      if (timer->deadline <= now) {
+        p_expired++;
+        timer->handler();
+      }
+    }
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count() / tick_count;
+}
+}  // namespace
+
+int main()
+{
+  std::printf("%8s %14s %14s %10s\n",
+              "timers",
+              "wheel ns/tick",
+              "list ns/tick",
+              "expiries");
+  for (const size_t count : { 10, 100, 1'000, 10'000, 100'000 }) {
+    const auto periods = make_periods(count);
+    std::uint64_t wheel_expired = 0;
+    std::uint64_t list_expired = 0;
+    const auto wheel_time = run_wheel(periods, wheel_expired);
+    const auto list_time = run_list(periods, list_expired);
+    if (wheel_expired != list_expired) {
+      std::printf("mismatch: wheel %llu, list %llu expiries\n",
+                  static_cast<unsigned long long>(wheel_expired),
+                  static_cast<unsigned long long>(list_expired));
+      return 1;
+    }
+    std::printf("%8zu %14.1f %14.1f %10llu\n",
+                count,
+                wheel_time,
+                list_time,
+                static_cast<unsigned long long>(wheel_expired));
+  }
+  return 0;
+}
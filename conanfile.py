@@ -35,7 +35,8 @@ class libhal_util_conan(ConanFile):
     topics = ("peripherals", "hardware", "abstraction", "devices", "hal")
     settings = "compiler", "build_type", "os", "arch"
     exports_sources = ("include/*", "tests/*", "LICENSE",
-                       "CMakeLists.txt", "src/*")
+                       "CMakeLists.txt", "src/*", "tools/*",
+                       "benchmarks/*")
     generators = "CMakeToolchain", "CMakeDeps"
 
     @property
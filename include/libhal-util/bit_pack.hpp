@@ -0,0 +1,332 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include <libhal/units.hpp>
+
+/**
+ * @defgroup BitPack Bit Packing
+ * Conversion between arrays of integers and streams of fixed width bit fields
+ * packed back to back, such as 12-bit or 24-bit ADC samples read over SPI.
+ */
+
+namespace hal {
+/**
+ * @ingroup BitPack
+ * @brief Order in which the bits of packed values fill each byte
+ *
+ */
+enum class bit_order : std::uint8_t
+{
+  /// The first value starts at bit 7 of the first byte, most significant bit
+  /// first. This is how SPI and I2C devices send samples.
+  msb_first,
+  /// The first value starts at bit 0 of the first byte, least significant bit
+  /// first. This is how values packed in little endian memory are laid out.
+  lsb_first,
+};
+
+/**
+ * @ingroup BitPack
+ * @brief Number of bytes needed to pack a number of values
+ *
+ * @tparam Width - bit width of each value
+ * @param p_count - number of values
+ * @return constexpr size_t - bytes holding p_count values, with the last byte
+ * padded with zeros
+ */
+template<size_t Width>
+constexpr size_t packed_size(size_t p_count)
+{
+  return (p_count * Width + 7) / 8;
+}
+
+/**
+ * @ingroup BitPack
+ * @brief How many values of a bit width fit in a 64-bit word without any value
+ * crossing into the next word
+ *
+ * The word holds a whole number of values and a whole number of bytes, so
+ * consecutive words start on byte boundaries. For example 12-bit values pack 4
+ * to a 6 byte word. Widths such as 9 or 11 have no such word and `values` is 0.
+ *
+ * @tparam Width - bit width of each value
+ */
+template<size_t Width>
+struct packed_word_layout
+{
+  /// Smallest run of bits holding a whole number of values and bytes
+  static constexpr size_t group_bits = std::lcm(Width, size_t{ 8 });
+  /// Bits of the word used, a multiple of group_bits
+  static constexpr size_t bits = group_bits <= 64 ? 64 - 64 % group_bits : 0;
+  /// Values per word
+  static constexpr size_t values = bits / Width;
+  /// Bytes per word
+  static constexpr size_t bytes = bits / 8;
+};
+
+/**
+ * @ingroup BitPack
+ * @brief Load 8 bytes as a 64-bit word in the given bit order
+ *
+ * Compilers turn this into a single unaligned load, plus a byte swap for
+ * msb_first on little endian cores.
+ *
+ * @tparam Order - bit order of the stream
+ * @param p_bytes - bytes to load
+ * @return constexpr std::uint64_t - word whose first bit in stream order is
+ * bit 63 for msb_first and bit 0 for lsb_first
+ */
+template<bit_order Order>
+constexpr std::uint64_t load_packed_word(std::span<const hal::byte, 8> p_bytes)
+{
+  std::array<hal::byte, 8> bytes{};
+  for (size_t index = 0; index < bytes.size(); index++) {
+    bytes[index] = p_bytes[index];
+  }
+  auto word = std::bit_cast<std::uint64_t>(bytes);
+
+  constexpr bool native_order = (Order == bit_order::lsb_first) ==
+                               (std::endian::native == std::endian::little);
+  if constexpr (!native_order) {
+    // Reverse the bytes, which compilers recognize as a byte swap instruction
+    constexpr std::uint64_t even_bytes = 0x00FF'00FF'00FF'00FF;
+    constexpr std::uint64_t even_halves = 0x0000'FFFF'0000'FFFF;
+    word = ((word & even_bytes) << 8) | ((word >> 8) & even_bytes);
+    word = ((word & even_halves) << 16) | ((word >> 16) & even_halves);
+    word = (word << 32) | (word >> 32);
+  }
+  return word;
+}
+
+/**
+ * @ingroup BitPack
+ * @brief Load up to 8 bytes as a 64-bit word in the given bit order
+ *
+ * @tparam Order - bit order of the stream
+ * @param p_bytes - bytes to load. Bytes beyond the end of the span read as
+ * zero.
+ * @return constexpr std::uint64_t - word whose first bit in stream order is
+ * bit 63 for msb_first and bit 0 for lsb_first
+ */
+template<bit_order Order>
+constexpr std::uint64_t load_packed_word(std::span<const hal::byte> p_bytes)
+{
+  if (p_bytes.size() >= 8) {
+    return load_packed_word<Order>(p_bytes.first<8>());
+  }
+
+  std::uint64_t word = 0;
+  for (size_t index = 0; index < p_bytes.size(); index++) {
+    if constexpr (Order == bit_order::msb_first) {
+      word |= static_cast<std::uint64_t>(p_bytes[index]) << (56 - index * 8);
+    } else {
+      word |= static_cast<std::uint64_t>(p_bytes[index]) << (index * 8);
+    }
+  }
+  return word;
+}
+
+/**
+ * @ingroup BitPack
+ * @brief Unpack values of a fixed bit width from a packed byte stream
+ *
+ * The bulk of the stream is decoded a 64-bit word at a time: when a whole
+ * number of values fits in a whole number of bytes within 64 bits, as it does
+ * for 12-bit (4 values per 6 bytes) and 24-bit (2 values per 6 bytes) samples,
+ * each load is split into those values with constant shifts. Other widths
+ * take one unaligned 64-bit load per value. Neither loop branches on the
+ * data.
+ *
+ *     std::array<hal::byte, 6> packed{ 0xAB, 0xCD, 0xEF, 0x01, 0x23, 0x45 };
+ *     std::array<std::uint16_t, 4> samples{};
+ *     hal::unpack_bits<12>(packed, std::span(samples));
+ *     // samples = { 0xABC, 0xDEF, 0x012, 0x345 }
+ *
+ * @tparam Width - bit width of each value, 1 to 32
+ * @tparam Order - bit order of the stream
+ * @param p_packed - packed stream
+ * @param p_values - destination of the unpacked values
+ * @return constexpr size_t - number of values unpacked, the smaller of the
+ * size of p_values and the number of whole values in p_packed
+ */
+template<size_t Width,
+         bit_order Order = bit_order::msb_first,
+         std::unsigned_integral T,
+         size_t Extent>
+constexpr size_t unpack_bits(std::span<const hal::byte> p_packed,
+                             std::span<T, Extent> p_values)
+{
+  static_assert(Width >= 1 && Width <= 32, "Width must be 1 to 32 bits");
+  static_assert(Width <= sizeof(T) * 8, "Width does not fit in T");
+
+  constexpr std::uint64_t mask = (std::uint64_t{ 1 } << Width) - 1;
+  constexpr size_t values_per_word = packed_word_layout<Width>::values;
+  constexpr size_t bytes_per_word = packed_word_layout<Width>::bytes;
+
+  const size_t count = std::min(p_values.size(), p_packed.size() * 8 / Width);
+  size_t index = 0;
+
+  if constexpr (values_per_word != 0) {
+    // Whole words that can be loaded without reading past the end
+    const size_t loadable =
+      p_packed.size() < 8 ? 0 : (p_packed.size() - 8) / bytes_per_word + 1;
+    const size_t words = std::min(count / values_per_word, loadable);
+
+    for (size_t word_index = 0; word_index < words; word_index++) {
+      const auto word = load_packed_word<Order>(
+        p_packed.subspan(word_index * bytes_per_word).template first<8>());
+      auto* values = p_values.data() + word_index * values_per_word;
+      // Unrolled so that every shift is a constant
+      [&]<size_t... Value>(std::index_sequence<Value...>) {
+        if constexpr (Order == bit_order::msb_first) {
+          ((values[Value] =
+              static_cast<T>((word >> (64 - Width * (Value + 1))) & mask)),
+           ...);
+        } else {
+          ((values[Value] = static_cast<T>((word >> (Width * Value)) & mask)),
+           ...);
+        }
+      }(std::make_index_sequence<values_per_word>());
+    }
+    index = words * values_per_word;
+  }
+
+  for (; index < count; index++) {
+    const auto bit = index * Width;
+    const auto word = load_packed_word<Order>(p_packed.subspan(bit / 8));
+    const auto shift = bit % 8;
+    if constexpr (Order == bit_order::msb_first) {
+      p_values[index] = static_cast<T>((word >> (64 - Width - shift)) & mask);
+    } else {
+      p_values[index] = static_cast<T>((word >> shift) & mask);
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @ingroup BitPack
+ * @brief Pack values into a stream of fixed width bit fields
+ *
+ * Like unpack_bits(), the bulk of the values are combined a 64-bit word at a
+ * time with constant shifts when the width allows it. The remaining values
+ * are accumulated in a 64-bit register and written out as bytes fill. Bits of
+ * each value above Width are dropped and the final byte is padded with zeros.
+ *
+ * @tparam Width - bit width of each value, 1 to 32
+ * @tparam Order - bit order of the stream
+ * @tparam T - unsigned integral type of the values, may be const
+ * @param p_values - values to pack
+ * @param p_packed - destination of the packed stream
+ * @return constexpr size_t - number of bytes written. The number of values
+ * packed is the smaller of the size of p_values and the number of whole values
+ * that fit in p_packed.
+ */
+template<size_t Width,
+         bit_order Order = bit_order::msb_first,
+         typename T,
+         size_t Extent>
+constexpr size_t pack_bits(std::span<T, Extent> p_values,
+                           std::span<hal::byte> p_packed)
+  requires std::unsigned_integral<std::remove_const_t<T>>
+{
+  static_assert(Width >= 1 && Width <= 32, "Width must be 1 to 32 bits");
+
+  constexpr std::uint64_t mask = (std::uint64_t{ 1 } << Width) - 1;
+  constexpr size_t values_per_word = packed_word_layout<Width>::values;
+  constexpr size_t bytes_per_word = packed_word_layout<Width>::bytes;
+
+  const size_t count = std::min(p_values.size(), p_packed.size() * 8 / Width);
+  size_t index = 0;
+  size_t written = 0;
+
+  if constexpr (values_per_word != 0) {
+    const size_t words = count / values_per_word;
+    for (size_t word_index = 0; word_index < words; word_index++) {
+      const auto* values = p_values.data() + word_index * values_per_word;
+      auto* bytes = p_packed.data() + word_index * bytes_per_word;
+      // Unrolled so that every shift is a constant
+      [&]<size_t... Value, size_t... Byte>(std::index_sequence<Value...>,
+                                           std::index_sequence<Byte...>) {
+        if constexpr (Order == bit_order::msb_first) {
+          const auto word =
+            ((((values[Value] & mask) << (64 - Width * (Value + 1)))) | ...);
+          ((bytes[Byte] = static_cast<hal::byte>(word >> (56 - 8 * Byte))),
+           ...);
+        } else {
+          const auto word = (((values[Value] & mask) << (Width * Value)) | ...);
+          ((bytes[Byte] = static_cast<hal::byte>(word >> (8 * Byte))), ...);
+        }
+      }(std::make_index_sequence<values_per_word>(),
+        std::make_index_sequence<bytes_per_word>());
+    }
+    index = words * values_per_word;
+    written = words * bytes_per_word;
+  }
+
+  std::uint64_t pending = 0;
+  size_t pending_bits = 0;
+
+  auto emit = [&](size_t p_bytes) {
+    for (size_t emitted = 0; emitted < p_bytes; emitted++) {
+      if constexpr (Order == bit_order::msb_first) {
+        pending_bits -= 8;
+        p_packed[written++] = static_cast<hal::byte>(pending >> pending_bits);
+      } else {
+        p_packed[written++] = static_cast<hal::byte>(pending);
+        pending >>= 8;
+        pending_bits -= 8;
+      }
+    }
+  };
+
+  for (; index < count; index++) {
+    const auto value = static_cast<std::uint64_t>(p_values[index]) & mask;
+    if constexpr (Order == bit_order::msb_first) {
+      pending = (pending << Width) | value;
+    } else {
+      pending |= value << pending_bits;
+    }
+    pending_bits += Width;
+    // At most 31 bits remain pending, leaving room for the next value
+    if (pending_bits >= 32) {
+      emit(4);
+    }
+  }
+
+  emit(pending_bits / 8);
+  if (pending_bits != 0) {
+    if constexpr (Order == bit_order::msb_first) {
+      pending <<= 8 - pending_bits;
+    }
+    p_packed[written++] = static_cast<hal::byte>(pending);
+  }
+
+  return written;
+}
+}  // namespace hal
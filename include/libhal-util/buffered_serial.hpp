@@ -0,0 +1,284 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <libhal/error.hpp>
+#include <libhal/serial.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "serial.hpp"
+#include "units.hpp"
+
+namespace hal {
+/**
+ * @ingroup Serial
+ * @brief Serial decorator that coalesces small writes into larger ones
+ *
+ * Writes are collected in a fixed size buffer and passed to the wrapped serial
+ * port as a single write when:
+ *
+ * 1. The next write would not fit in the buffer
+ * 2. The number of buffered bytes reaches the flush threshold
+ * 3. The oldest buffered byte is older than the maximum latency (only when
+ *    constructed with a steady clock)
+ * 4. `flush_writes()` is called
+ *
+ * Writes at least as large as the buffer skip the buffer and are passed
+ * directly to the wrapped serial port, after any buffered bytes.
+ *
+ * The maximum latency can only be checked when this object is called. Call
+ * `poll()` periodically to bound the latency of the last write in a burst.
+ *
+ * NOTE: `hal::serial::flush()` discards received data and is forwarded to the
+ * wrapped serial port as is. Use `flush_writes()` to send buffered data.
+ *
+ * @tparam BufferSize - number of bytes that can be buffered
+ */
+template<size_t BufferSize>
+class buffered_serial : public hal::serial
+{
+public:
+  static_assert(BufferSize > 0, "BufferSize must be greater than zero");
+
+  /// Counters for tuning the buffer size and thresholds
+  struct statistics
+  {
+    /// Number of write calls received
+    std::uint32_t write_calls = 0;
+    /// Number of bytes received across all write calls
+    std::uint64_t bytes_written = 0;
+    /// Number of times the buffer was flushed because it was full
+    std::uint32_t full_flushes = 0;
+    /// Number of times the buffer was flushed due to the flush threshold
+    std::uint32_t threshold_flushes = 0;
+    /// Number of times the buffer was flushed due to the maximum latency
+    std::uint32_t latency_flushes = 0;
+    /// Number of times the buffer was flushed by `flush_writes()`
+    std::uint32_t explicit_flushes = 0;
+    /// Number of writes too large to buffer that were passed through
+    std::uint32_t passthrough_writes = 0;
+    /// Largest number of bytes held in the buffer at once
+    size_t high_water_mark = 0;
+  };
+
+  /**
+   * @brief Construct a buffered_serial with a byte threshold only
+   *
+   * @param p_serial - serial port to write to. Must outlive this object.
+   * @param p_flush_threshold - flush once this many bytes are buffered. Values
+   * of zero or above BufferSize are treated as BufferSize.
+   */
+  explicit buffered_serial(hal::serial& p_serial,
+                           size_t p_flush_threshold = BufferSize)
+    : m_serial(&p_serial)
+    , m_flush_threshold(clamp_threshold(p_flush_threshold))
+  {
+  }
+
+  /**
+   * @brief Construct a buffered_serial with a maximum latency
+   *
+   * @param p_serial - serial port to write to. Must outlive this object.
+   * @param p_steady_clock - clock used to measure the age of buffered data.
+   * Must outlive this object.
+   * @param p_max_latency - flush once the oldest buffered byte is older than
+   * this
+   * @param p_flush_threshold - flush once this many bytes are buffered. Values
+   * of zero or above BufferSize are treated as BufferSize.
+   */
+  buffered_serial(hal::serial& p_serial,
+                  hal::steady_clock& p_steady_clock,
+                  hal::time_duration p_max_latency,
+                  size_t p_flush_threshold = BufferSize)
+    : m_serial(&p_serial)
+    , m_steady_clock(&p_steady_clock)
+    , m_flush_threshold(clamp_threshold(p_flush_threshold))
+  {
+    using period = hal::time_duration::period;
+    const auto frequency = p_steady_clock.frequency().operating_frequency;
+    const auto tick_period = wavelength<period>(frequency);
+    const auto ticks = p_max_latency / tick_period;
+    m_max_latency_ticks = (ticks <= 1) ? 1 : static_cast<std::uint64_t>(ticks);
+  }
+
+  buffered_serial(const buffered_serial&) = delete;
+  buffered_serial& operator=(const buffered_serial&) = delete;
+  buffered_serial(buffered_serial&&) = delete;
+  buffered_serial& operator=(buffered_serial&&) = delete;
+
+  /**
+   * @brief Send any buffered bytes before destruction, ignoring errors
+   *
+   */
+  ~buffered_serial() override
+  {
+    (void)send();
+  }
+
+  /**
+   * @brief Send all buffered bytes to the wrapped serial port
+   *
+   * @return status - success or an error from the wrapped serial port. The
+   * buffered bytes are discarded on error.
+   */
+  [[nodiscard]] status flush_writes()
+  {
+    if (m_size != 0) {
+      m_stats.explicit_flushes++;
+    }
+    return send();
+  }
+
+  /**
+   * @brief Send buffered bytes if the maximum latency has been exceeded
+   *
+   * Does nothing if this object was not constructed with a steady clock.
+   *
+   * @return status - success or an error from the wrapped serial port
+   */
+  [[nodiscard]] status poll()
+  {
+    if (latency_exceeded()) {
+      m_stats.latency_flushes++;
+      return send();
+    }
+    return success();
+  }
+
+  /**
+   * @brief Get the number of bytes waiting in the buffer
+   *
+   * @return size_t - number of buffered bytes
+   */
+  [[nodiscard]] size_t pending() const
+  {
+    return m_size;
+  }
+
+  /**
+   * @brief Get the statistics collected since construction or the last reset
+   *
+   * @return const statistics& - collected statistics
+   */
+  [[nodiscard]] const statistics& stats() const
+  {
+    return m_stats;
+  }
+
+  /**
+   * @brief Reset all statistics to zero
+   *
+   */
+  void reset_stats()
+  {
+    m_stats = statistics{};
+  }
+
+private:
+  static constexpr size_t clamp_threshold(size_t p_threshold)
+  {
+    if (p_threshold == 0 || p_threshold > BufferSize) {
+      return BufferSize;
+    }
+    return p_threshold;
+  }
+
+  bool latency_exceeded()
+  {
+    if (m_steady_clock == nullptr || m_size == 0) {
+      return false;
+    }
+    return m_steady_clock->uptime().ticks - m_first_byte_ticks >=
+           m_max_latency_ticks;
+  }
+
+  status send()
+  {
+    if (m_size == 0) {
+      return success();
+    }
+    const auto buffered = std::span<const hal::byte>(m_buffer.data(), m_size);
+    m_size = 0;
+    return hal::write(*m_serial, buffered);
+  }
+
+  status driver_configure(const settings& p_settings) override
+  {
+    HAL_CHECK(send());
+    return m_serial->configure(p_settings);
+  }
+
+  result<write_t> driver_write(std::span<const hal::byte> p_data) override
+  {
+    m_stats.write_calls++;
+    m_stats.bytes_written += p_data.size();
+
+    if (m_size + p_data.size() > BufferSize) {
+      if (m_size != 0) {
+        m_stats.full_flushes++;
+      }
+      HAL_CHECK(send());
+    }
+
+    if (p_data.size() >= BufferSize) {
+      m_stats.passthrough_writes++;
+      HAL_CHECK(hal::write(*m_serial, p_data));
+      return write_t{ .data = p_data };
+    }
+
+    if (m_size == 0 && m_steady_clock != nullptr) {
+      m_first_byte_ticks = m_steady_clock->uptime().ticks;
+    }
+
+    std::copy(p_data.begin(), p_data.end(), m_buffer.begin() + m_size);
+    m_size += p_data.size();
+    m_stats.high_water_mark = std::max(m_stats.high_water_mark, m_size);
+
+    if (m_size >= m_flush_threshold) {
+      m_stats.threshold_flushes++;
+      HAL_CHECK(send());
+    } else {
+      HAL_CHECK(poll());
+    }
+
+    return write_t{ .data = p_data };
+  }
+
+  result<read_t> driver_read(std::span<hal::byte> p_data) override
+  {
+    return m_serial->read(p_data);
+  }
+
+  result<flush_t> driver_flush() override
+  {
+    return m_serial->flush();
+  }
+
+  hal::serial* m_serial;
+  hal::steady_clock* m_steady_clock = nullptr;
+  std::uint64_t m_max_latency_ticks = 0;
+  std::uint64_t m_first_byte_ticks = 0;
+  size_t m_flush_threshold;
+  size_t m_size = 0;
+  statistics m_stats{};
+  std::array<hal::byte, BufferSize> m_buffer{};
+};
+}  // namespace hal
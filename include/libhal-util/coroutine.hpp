@@ -0,0 +1,772 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <libhal/error.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/timeout.hpp>
+#include <libhal/units.hpp>
+
+#include "steady_clock.hpp"
+#include "timeout.hpp"
+
+/**
+ * @defgroup Coroutine Coroutine
+ * C++20 coroutines whose frames are allocated from a fixed arena, along with
+ * awaitables for workers and timeouts, and an executor to drive them.
+ *
+ * The workers in `serial_coroutines.hpp` are hand written state machines.
+ * Composing them requires yet another state machine. With `hal::task` the
+ * protocol can be written as straight line code:
+ *
+ *     hal::task<std::uint32_t> read_reading(hal::coroutine_arena& p_arena,
+ *                                           hal::serial& p_serial)
+ *     {
+ *       auto found = co_await hal::until_done(
+ *         hal::skip_past(p_serial, hal::as_bytes(start_of_frame)));
+ *       if (!found) {
+ *         co_return found.error();
+ *       }
+ *       hal::read_uint32 reader(p_serial);
+ *       auto parsed = co_await hal::until_done(reader);
+ *       if (!parsed) {
+ *         co_return parsed.error();
+ *       }
+ *       co_return reader.get().value();
+ *     }
+ *
+ *     std::array<hal::byte, 512> memory;
+ *     hal::coroutine_arena arena(memory);
+ *     hal::coroutine_executor executor(arena);
+ *     auto reading = read_reading(arena, serial);
+ *     HAL_CHECK(executor.spawn(reading));
+ *     while (!reading.done()) {
+ *       executor.run_once();
+ *     }
+ *
+ * Errors are values: `co_await` on a task or worker gives a `hal::result`,
+ * and a task finishes with `co_return value;` or `co_return error;`. Because
+ * `HAL_CHECK` uses `return`, it cannot be used within a coroutine.
+ */
+
+namespace hal {
+/**
+ * @ingroup Coroutine
+ * @brief Fixed memory region for coroutine frames
+ *
+ * Frames are allocated like a stack, which matches how awaited tasks nest. A
+ * frame that is freed out of order is reclaimed once every frame allocated
+ * after it has also been freed.
+ *
+ * A coroutine takes its frame from the first `hal::coroutine_arena&`
+ * parameter it has. Coroutines without an arena parameter take their frame
+ * from the arena of the executor that is running them, which covers tasks
+ * created and awaited within another task. If no arena is available or the
+ * arena is full, the task is invalid and awaiting or spawning it gives
+ * `std::errc::not_enough_memory`.
+ */
+class coroutine_arena
+{
+public:
+  /**
+   * @ingroup Coroutine
+   * @brief Construct a new coroutine arena
+   *
+   * @param p_memory - memory for frames. Must outlive the arena and every
+   * task allocated from it.
+   */
+  explicit coroutine_arena(std::span<hal::byte> p_memory);
+
+  coroutine_arena(const coroutine_arena&) = delete;
+  coroutine_arena& operator=(const coroutine_arena&) = delete;
+  coroutine_arena(coroutine_arena&&) = delete;
+  coroutine_arena& operator=(coroutine_arena&&) = delete;
+
+  /**
+   * @ingroup Coroutine
+   * @brief Allocate memory for a frame
+   *
+   * @param p_size - size of the frame in bytes
+   * @return void* - frame memory or nullptr if the arena is full
+   */
+  [[nodiscard]] void* allocate(size_t p_size) noexcept;
+
+  /**
+   * @ingroup Coroutine
+   * @brief Free a frame allocated from any arena
+   *
+   * @param p_frame - frame returned by `allocate()`
+   */
+  static void deallocate(void* p_frame) noexcept;
+
+  /**
+   * @ingroup Coroutine
+   * @brief Get the arena used by coroutines without an arena parameter
+   *
+   * @return coroutine_arena* - the arena of the executor that is running or
+   * nullptr outside of an executor
+   */
+  [[nodiscard]] static coroutine_arena* active() noexcept;
+
+  /**
+   * @ingroup Coroutine
+   * @brief Set the arena used by coroutines without an arena parameter
+   *
+   * @param p_arena - arena to use or nullptr
+   * @return coroutine_arena* - the previously active arena
+   */
+  static coroutine_arena* make_active(coroutine_arena* p_arena) noexcept;
+
+  /**
+   * @return size_t - bytes in use, including per frame bookkeeping
+   */
+  [[nodiscard]] size_t used() const
+  {
+    return m_used;
+  }
+
+  /**
+   * @return size_t - the most bytes that were in use at once
+   */
+  [[nodiscard]] size_t peak() const
+  {
+    return m_peak;
+  }
+
+  /**
+   * @return size_t - usable size of the arena in bytes
+   */
+  [[nodiscard]] size_t capacity() const
+  {
+    return m_memory.size();
+  }
+
+private:
+  struct alignas(std::max_align_t) header
+  {
+    coroutine_arena* arena;
+    header* previous;
+    bool free;
+  };
+
+  std::span<hal::byte> m_memory;
+  header* m_top = nullptr;
+  size_t m_used = 0;
+  size_t m_peak = 0;
+};
+
+class coroutine_executor;
+
+/**
+ * @ingroup Coroutine
+ * @brief State shared by every task promise
+ *
+ * Used by awaitables and the executor, not intended to be used directly.
+ */
+class task_promise_base
+{
+public:
+  friend class coroutine_executor;
+
+  template<typename... Args>
+  static void* operator new(size_t p_size, Args&... p_args) noexcept
+  {
+    // Use the first arena parameter, otherwise the active arena
+    coroutine_arena* arena = nullptr;
+    ((arena = (arena != nullptr) ? arena : arena_of(p_args)), ...);
+    if (arena == nullptr) {
+      arena = coroutine_arena::active();
+    }
+    if (arena == nullptr) {
+      return nullptr;
+    }
+    return arena->allocate(p_size);
+  }
+
+  static void operator delete(void* p_frame) noexcept
+  {
+    coroutine_arena::deallocate(p_frame);
+  }
+
+  task_promise_base() = default;
+  task_promise_base(const task_promise_base&) = delete;
+  task_promise_base& operator=(const task_promise_base&) = delete;
+  ~task_promise_base();
+
+  /// Tasks do not start until they are awaited or spawned
+  std::suspend_always initial_suspend() noexcept
+  {
+    return {};
+  }
+
+  /// Resumes the awaiting task, if there is one
+  struct final_awaiter
+  {
+    bool await_ready() noexcept
+    {
+      return false;
+    }
+
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<Promise> p_handle) noexcept
+    {
+      auto continuation = p_handle.promise().m_continuation;
+      if (continuation) {
+        return continuation;
+      }
+      return std::noop_coroutine();
+    }
+
+    void await_resume() noexcept
+    {
+    }
+  };
+
+  final_awaiter final_suspend() noexcept
+  {
+    return {};
+  }
+
+  void unhandled_exception() noexcept
+  {
+    std::terminate();
+  }
+
+  /**
+   * @ingroup Coroutine
+   * @brief Suspend a task until an awaitable reports that it is complete
+   *
+   * The executor calls `p_awaitable.poll()` once per round and resumes
+   * p_handle when it returns true.
+   *
+   * @param p_handle - suspended task
+   * @param p_awaitable - awaitable with a `bool poll()` member function
+   */
+  template<typename Awaitable>
+  void wait_on(std::coroutine_handle<> p_handle, Awaitable& p_awaitable)
+  {
+    m_root->m_waiting = p_handle;
+    m_root->m_poll_context = &p_awaitable;
+    m_root->m_poll = [](void* p_context) -> bool {
+      return static_cast<Awaitable*>(p_context)->poll();
+    };
+  }
+
+  /**
+   * @ingroup Coroutine
+   * @brief Start an awaited task from the awaiting task
+   *
+   * @param p_parent - the awaiting task
+   * @param p_continuation - handle to resume once this task finishes
+   */
+  void start_from(task_promise_base& p_parent,
+                  std::coroutine_handle<> p_continuation)
+  {
+    m_root = p_parent.m_root;
+    m_continuation = p_continuation;
+  }
+
+private:
+  static coroutine_arena* arena_of(coroutine_arena& p_arena)
+  {
+    return &p_arena;
+  }
+
+  template<typename T>
+  static coroutine_arena* arena_of(T&)
+  {
+    return nullptr;
+  }
+
+  std::coroutine_handle<> m_continuation{};
+  // The task at the bottom of the await chain, which is the one the executor
+  // knows about. Only the fields below are used in the root task.
+  task_promise_base* m_root = this;
+  std::coroutine_handle<> m_handle{};
+  std::coroutine_handle<> m_waiting{};
+  void* m_poll_context = nullptr;
+  bool (*m_poll)(void*) = nullptr;
+  coroutine_executor* m_executor = nullptr;
+  task_promise_base* m_next = nullptr;
+  task_promise_base** m_link = nullptr;
+  bool m_started = false;
+
+protected:
+  void set_handle(std::coroutine_handle<> p_handle)
+  {
+    m_handle = p_handle;
+  }
+};
+
+template<typename T>
+class task;
+
+/**
+ * @ingroup Coroutine
+ * @brief Promise type of `hal::task<T>`
+ *
+ * @tparam T - type of the value the task produces
+ */
+template<typename T>
+class task_promise : public task_promise_base
+{
+public:
+  task<T> get_return_object() noexcept;
+
+  static task<T> get_return_object_on_allocation_failure() noexcept;
+
+  /// Accepts a value, or an error for the task to fail with
+  void return_value(result<T> p_result)
+  {
+    m_result.emplace(std::move(p_result));
+  }
+
+  [[nodiscard]] result<T> take_result()
+  {
+    return std::move(*m_result);
+  }
+
+private:
+  std::optional<result<T>> m_result;
+};
+
+/**
+ * @ingroup Coroutine
+ * @brief Coroutine that produces a `hal::result<T>`
+ *
+ * A task does not run until it is awaited by another task or spawned on a
+ * `hal::coroutine_executor`. The task object owns the coroutine frame and
+ * destroys it when destroyed, which also destroys any task it is awaiting.
+ *
+ * Finish a task with `co_return value;` or `co_return hal::new_error(...);`.
+ * A `task<void>` finishes with `co_return {};`. Flowing off the end of a task
+ * is undefined behavior.
+ *
+ * @tparam T - type of the value the task produces
+ */
+template<typename T = void>
+class [[nodiscard]] task
+{
+public:
+  using promise_type = task_promise<T>;
+
+  task() = default;
+  task(const task&) = delete;
+  task& operator=(const task&) = delete;
+
+  task(task&& p_other) noexcept
+    : m_handle(std::exchange(p_other.m_handle, nullptr))
+  {
+  }
+
+  task& operator=(task&& p_other) noexcept
+  {
+    if (this != &p_other) {
+      destroy();
+      m_handle = std::exchange(p_other.m_handle, nullptr);
+    }
+    return *this;
+  }
+
+  ~task()
+  {
+    destroy();
+  }
+
+  /**
+   * @ingroup Coroutine
+   * @brief Determine if a frame was allocated for the task
+   *
+   * @return true - the task can be awaited or spawned
+   */
+  [[nodiscard]] bool valid() const
+  {
+    return static_cast<bool>(m_handle);
+  }
+
+  /**
+   * @ingroup Coroutine
+   * @brief Determine if the task has finished
+   *
+   * @return true - the task has produced its result
+   */
+  [[nodiscard]] bool done() const
+  {
+    return m_handle && m_handle.done();
+  }
+
+  /**
+   * @ingroup Coroutine
+   * @brief Take the result of a finished task
+   *
+   * @return result<T> - result of the task. Gives
+   * `std::errc::resource_unavailable_try_again` if the task has not finished
+   * and `std::errc::not_enough_memory` if the task is not valid.
+   */
+  [[nodiscard]] result<T> get()
+  {
+    if (!m_handle) {
+      return new_error(std::errc::not_enough_memory);
+    }
+    if (!m_handle.done()) {
+      return new_error(std::errc::resource_unavailable_try_again);
+    }
+    return m_handle.promise().take_result();
+  }
+
+  /// Awaits the task from another task
+  class awaiter
+  {
+  public:
+    explicit awaiter(std::coroutine_handle<promise_type> p_handle)
+      : m_handle(p_handle)
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+      return !m_handle || m_handle.done();
+    }
+
+    template<std::derived_from<task_promise_base> Promise>
+    std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<Promise> p_parent) noexcept
+    {
+      m_handle.promise().start_from(p_parent.promise(), p_parent);
+      return m_handle;
+    }
+
+    result<T> await_resume()
+    {
+      if (!m_handle) {
+        return new_error(std::errc::not_enough_memory);
+      }
+      return m_handle.promise().take_result();
+    }
+
+  private:
+    std::coroutine_handle<promise_type> m_handle;
+  };
+
+  awaiter operator co_await() const& noexcept
+  {
+    return awaiter(m_handle);
+  }
+
+  awaiter operator co_await() const&& noexcept
+  {
+    return awaiter(m_handle);
+  }
+
+private:
+  friend class task_promise<T>;
+  friend class coroutine_executor;
+
+  explicit task(std::coroutine_handle<promise_type> p_handle)
+    : m_handle(p_handle)
+  {
+  }
+
+  void destroy()
+  {
+    if (m_handle) {
+      m_handle.destroy();
+      m_handle = nullptr;
+    }
+  }
+
+  std::coroutine_handle<promise_type> m_handle{};
+};
+
+template<typename T>
+task<T> task_promise<T>::get_return_object() noexcept
+{
+  auto handle = std::coroutine_handle<task_promise<T>>::from_promise(*this);
+  set_handle(handle);
+  return task<T>(handle);
+}
+
+template<typename T>
+task<T> task_promise<T>::get_return_object_on_allocation_failure() noexcept
+{
+  return task<T>();
+}
+
+/**
+ * @ingroup Coroutine
+ * @brief Single threaded executor that drives spawned tasks
+ *
+ * Each call to `run_once()` starts tasks that have not started yet and polls
+ * the awaitable each waiting task is suspended on, resuming the task if the
+ * awaitable has completed. Tasks never block, so any number of them share one
+ * main loop.
+ */
+class coroutine_executor
+{
+public:
+  /**
+   * @ingroup Coroutine
+   * @brief Construct a new coroutine executor
+   *
+   * @param p_arena - arena for frames of tasks created while the executor is
+   * running a task. Must outlive the executor.
+   */
+  explicit coroutine_executor(coroutine_arena& p_arena)
+    : m_arena(&p_arena)
+  {
+  }
+
+  coroutine_executor(const coroutine_executor&) = delete;
+  coroutine_executor& operator=(const coroutine_executor&) = delete;
+  coroutine_executor(coroutine_executor&&) = delete;
+  coroutine_executor& operator=(coroutine_executor&&) = delete;
+
+  /**
+   * @ingroup Coroutine
+   * @brief Remove all remaining tasks without destroying them
+   *
+   */
+  ~coroutine_executor();
+
+  /**
+   * @ingroup Coroutine
+   * @brief Add a task to the executor
+   *
+   * The task starts on the next call to `run_once()`. It is removed from the
+   * executor when it finishes or is destroyed.
+   *
+   * @param p_task - task to run. Must not have been awaited or spawned
+   * before.
+   * @return status - success or failure
+   * @throws std::errc::not_enough_memory - the task is not valid
+   * @throws std::errc::invalid_argument - the task has already started
+   */
+  template<typename T>
+  status spawn(task<T>& p_task)
+  {
+    if (!p_task.valid()) {
+      return new_error(std::errc::not_enough_memory);
+    }
+    return add(p_task.m_handle.promise());
+  }
+
+  /**
+   * @ingroup Coroutine
+   * @brief Run each spawned task until it suspends
+   *
+   * Must not be called from within a task.
+   *
+   * @return size_t - number of tasks that finished
+   */
+  size_t run_once();
+
+  /**
+   * @ingroup Coroutine
+   * @brief Get the number of tasks that have not finished
+   *
+   * @return size_t - number of tasks
+   */
+  [[nodiscard]] size_t size() const
+  {
+    return m_size;
+  }
+
+private:
+  friend class task_promise_base;
+
+  status add(task_promise_base& p_root);
+  void remove(task_promise_base& p_root);
+
+  coroutine_arena* m_arena;
+  task_promise_base* m_head = nullptr;
+  task_promise_base* m_cursor = nullptr;
+  size_t m_size = 0;
+};
+
+/**
+ * @ingroup Coroutine
+ * @brief Awaitable that calls a worker once per executor round until the
+ * worker reaches a terminal state or the timeout expires
+ *
+ * Create with `hal::until_done()`.
+ *
+ * @tparam Worker - worker type, or reference to a worker
+ * @tparam Timeout - timeout type
+ */
+template<typename Worker, typename Timeout>
+class work_awaitable
+{
+public:
+  work_awaitable(Worker&& p_worker, Timeout p_timeout)
+    : m_worker(std::forward<Worker>(p_worker))
+    , m_timeout(std::move(p_timeout))
+  {
+  }
+
+  bool await_ready()
+  {
+    return poll();
+  }
+
+  template<std::derived_from<task_promise_base> Promise>
+  void await_suspend(std::coroutine_handle<Promise> p_handle)
+  {
+    p_handle.promise().wait_on(p_handle, *this);
+  }
+
+  result<work_state> await_resume()
+  {
+    return std::move(*m_state);
+  }
+
+  bool poll()
+  {
+    auto state = m_worker();
+    if (!state || hal::terminated(state.value())) {
+      m_state.emplace(std::move(state));
+      return true;
+    }
+    auto timeout_status = m_timeout();
+    if (!timeout_status) {
+      m_state.emplace(timeout_status.error());
+      return true;
+    }
+    return false;
+  }
+
+private:
+  Worker m_worker;
+  Timeout m_timeout;
+  std::optional<result<work_state>> m_state;
+};
+
+/**
+ * @ingroup Coroutine
+ * @brief Await a worker such as `hal::skip_past`, `hal::read_into` or
+ * `hal::read_upto`
+ *
+ *     auto state = co_await hal::until_done(hal::read_into(serial, buffer));
+ *
+ * @param p_worker - worker to call until it terminates. An lvalue is used in
+ * place, a temporary is moved into the awaitable.
+ * @param p_timeout - timeout checked after each call that leaves the worker
+ * in progress
+ * @return work_awaitable - awaitable that gives the terminal state of the
+ * worker, its error, or the timeout error
+ */
+template<typename Worker, timeout Timeout>
+[[nodiscard]] auto until_done(Worker&& p_worker, Timeout p_timeout)
+{
+  return work_awaitable<Worker, Timeout>(std::forward<Worker>(p_worker),
+                                         std::move(p_timeout));
+}
+
+/**
+ * @ingroup Coroutine
+ * @brief Await a worker without a timeout
+ *
+ * @param p_worker - worker to call until it terminates
+ * @return work_awaitable - awaitable that gives the terminal state of the
+ * worker or its error
+ */
+template<typename Worker>
+[[nodiscard]] auto until_done(Worker&& p_worker)
+{
+  return until_done(std::forward<Worker>(p_worker), never_timeout());
+}
+
+/**
+ * @ingroup Coroutine
+ * @brief Awaitable that completes once a timeout expires
+ *
+ * Create with `hal::until_timeout()` or `hal::async_delay()`.
+ *
+ * @tparam Timeout - timeout type
+ */
+template<typename Timeout>
+class timeout_awaitable
+{
+public:
+  explicit timeout_awaitable(Timeout p_timeout)
+    : m_timeout(std::move(p_timeout))
+  {
+  }
+
+  bool await_ready()
+  {
+    return poll();
+  }
+
+  template<std::derived_from<task_promise_base> Promise>
+  void await_suspend(std::coroutine_handle<Promise> p_handle)
+  {
+    p_handle.promise().wait_on(p_handle, *this);
+  }
+
+  void await_resume()
+  {
+  }
+
+  bool poll()
+  {
+    return !m_timeout();
+  }
+
+private:
+  Timeout m_timeout;
+};
+
+/**
+ * @ingroup Coroutine
+ * @brief Suspend the task until a timeout such as a `steady_clock_timeout`
+ * returns an error
+ *
+ * @param p_timeout - timeout to wait for
+ * @return timeout_awaitable - awaitable that completes once p_timeout expires
+ */
+template<timeout Timeout>
+[[nodiscard]] auto until_timeout(Timeout p_timeout)
+{
+  return timeout_awaitable<Timeout>(std::move(p_timeout));
+}
+
+/**
+ * @ingroup Coroutine
+ * @brief Suspend the task for a duration of time
+ *
+ * The non-blocking counterpart to `hal::delay()`.
+ *
+ * @param p_steady_clock - steady_clock driver
+ * @param p_duration - the amount of time to suspend for
+ * @return timeout_awaitable - awaitable that completes once p_duration has
+ * elapsed
+ */
+[[nodiscard]] inline auto async_delay(hal::steady_clock& p_steady_clock,
+                                      hal::time_duration p_duration)
+{
+  return until_timeout(create_timeout(p_steady_clock, p_duration));
+}
+}  // namespace hal
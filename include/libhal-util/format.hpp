@@ -0,0 +1,636 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @defgroup Format Format
+ * Type safe string formatting with format strings that are parsed and checked
+ * at compile time.
+ *
+ * Format strings use `{}` as a placeholder for each argument. A placeholder
+ * may contain a format spec after a colon:
+ *
+ *     {:[0][width][.precision][type]}
+ *
+ * - `0` pads with zeros instead of spaces
+ * - `width` is the minimum number of characters to emit, up to 255
+ * - `precision` is the number of digits after the decimal point for floating
+ *   point types, up to 18. Defaults to 6.
+ * - `type` is one of `d` (decimal), `x`/`X` (hex), `o` (octal), `b` (binary)
+ *   or `c` (character) for integral types, `f` (fixed) or `e` (scientific) for
+ *   floating point types and `s` for strings.
+ *
+ * Use `{{` and `}}` to emit literal braces.
+ *
+ * Mismatches between the number of placeholders and the number of arguments,
+ * and format specs that are not valid for an argument's type, are reported as
+ * compile errors.
+ */
+
+namespace hal {
+/**
+ * @ingroup Format
+ * @brief Parsed contents of a placeholder's format spec
+ *
+ */
+struct format_spec
+{
+  /// Character used for padding, ' ' or '0'
+  char fill = ' ';
+  /// Type character or 0 if no type was given
+  char type = 0;
+  /// Minimum number of characters to emit
+  std::uint8_t width = 0;
+  /// Number of digits after the decimal point or -1 if none was given
+  std::int8_t precision = -1;
+};
+
+/**
+ * @ingroup Format
+ * @brief Formats values of type T
+ *
+ * Specialize this template to make additional types formattable. A
+ * specialization must provide:
+ *
+ *     static constexpr bool valid(const format_spec& p_spec);
+ *     static void format(auto& p_sink, const T& p_value,
+ *                        const format_spec& p_spec);
+ *
+ * `valid` is evaluated at compile time for each placeholder and `format` must
+ * pass `std::string_view` chunks to the sink.
+ *
+ * @tparam T - type to format
+ */
+template<typename T>
+struct formatter;
+
+/**
+ * @ingroup Format
+ * @brief Emit p_text to a sink padded to the width of the format spec
+ *
+ * When zero padding, a leading sign stays in front of the padding.
+ *
+ * @param p_sink - callable accepting std::string_view
+ * @param p_text - text to emit
+ * @param p_spec - format spec with the width and fill
+ */
+inline void format_padded(auto& p_sink,
+                          std::string_view p_text,
+                          const format_spec& p_spec)
+{
+  if (p_text.size() >= p_spec.width) {
+    p_sink(p_text);
+    return;
+  }
+
+  size_t padding = p_spec.width - p_text.size();
+
+  if (p_spec.fill == '0' && !p_text.empty() &&
+      (p_text[0] == '-' || p_text[0] == '+')) {
+    p_sink(p_text.substr(0, 1));
+    p_text.remove_prefix(1);
+  }
+
+  static constexpr std::string_view spaces = "                ";
+  static constexpr std::string_view zeros = "0000000000000000";
+  const auto fill = (p_spec.fill == '0') ? zeros : spaces;
+
+  while (padding > 0) {
+    const auto amount = std::min(padding, fill.size());
+    p_sink(fill.substr(0, amount));
+    padding -= amount;
+  }
+
+  p_sink(p_text);
+}
+
+/**
+ * @ingroup Format
+ * @brief Formatter for integral types
+ *
+ */
+template<std::integral T>
+struct formatter<T>
+{
+  static constexpr bool valid(const format_spec& p_spec)
+  {
+    constexpr std::string_view types = "dxXobc";
+    return p_spec.precision < 0 &&
+           (p_spec.type == 0 || types.find(p_spec.type) != types.npos);
+  }
+
+  static void format(auto& p_sink, T p_value, const format_spec& p_spec)
+  {
+    if (p_spec.type == 'c') {
+      const auto character = static_cast<char>(p_value);
+      format_padded(p_sink, std::string_view(&character, 1), p_spec);
+      return;
+    }
+
+    // Large enough for a 64-bit binary number and its sign
+    std::array<char, 66> buffer{};
+    int base = 10;
+    switch (p_spec.type) {
+      case 'x':
+      case 'X':
+        base = 16;
+        break;
+      case 'o':
+        base = 8;
+        break;
+      case 'b':
+        base = 2;
+        break;
+      default:
+        break;
+    }
+
+    auto* const end =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), p_value, base)
+        .ptr;
+
+    if (p_spec.type == 'X') {
+      std::transform(buffer.data(), end, buffer.data(), [](char p_char) {
+        constexpr char to_upper = 'a' - 'A';
+        return (p_char >= 'a' && p_char <= 'f')
+                 ? static_cast<char>(p_char - to_upper)
+                 : p_char;
+      });
+    }
+
+    format_padded(p_sink,
+                  std::string_view(buffer.data(),
+                                   static_cast<size_t>(end - buffer.data())),
+                  p_spec);
+  }
+};
+
+/**
+ * @ingroup Format
+ * @brief Formatter for bool, emitted as "true" or "false"
+ *
+ */
+template<>
+struct formatter<bool>
+{
+  static constexpr bool valid(const format_spec& p_spec)
+  {
+    return p_spec.precision < 0 && (p_spec.type == 0 || p_spec.type == 's');
+  }
+
+  static void format(auto& p_sink, bool p_value, const format_spec& p_spec)
+  {
+    format_padded(p_sink, p_value ? "true" : "false", p_spec);
+  }
+};
+
+/**
+ * @ingroup Format
+ * @brief Formatter for char, emitted as a character unless an integer type is
+ * given
+ *
+ */
+template<>
+struct formatter<char>
+{
+  static constexpr bool valid(const format_spec& p_spec)
+  {
+    return formatter<int>::valid(p_spec);
+  }
+
+  static void format(auto& p_sink, char p_value, const format_spec& p_spec)
+  {
+    if (p_spec.type == 0 || p_spec.type == 'c') {
+      format_padded(p_sink, std::string_view(&p_value, 1), p_spec);
+      return;
+    }
+    formatter<int>::format(
+      p_sink, static_cast<int>(static_cast<unsigned char>(p_value)), p_spec);
+  }
+};
+
+/**
+ * @ingroup Format
+ * @brief Formatter for floating point types
+ *
+ * Values are converted using integer arithmetic on the integer and fractional
+ * parts and do not require the printf family of functions. The last digit may
+ * differ from a correctly rounded conversion.
+ */
+template<std::floating_point T>
+struct formatter<T>
+{
+  static constexpr bool valid(const format_spec& p_spec)
+  {
+    return p_spec.precision <= 18 &&
+           (p_spec.type == 0 || p_spec.type == 'f' || p_spec.type == 'e');
+  }
+
+  static void format(auto& p_sink, T p_value, const format_spec& p_spec)
+  {
+    // Large enough for a sign, 20 integer digits, a decimal point, 18
+    // fractional digits and an exponent.
+    std::array<char, 48> buffer{};
+    auto* cursor = buffer.data();
+    auto* const end = buffer.data() + buffer.size();
+
+    auto value = static_cast<double>(p_value);
+    if (value < 0) {
+      *cursor++ = '-';
+      value = -value;
+    }
+
+    if (value != value) {
+      format_padded(p_sink, "nan", p_spec);
+      return;
+    }
+    if (value > std::numeric_limits<double>::max()) {
+      format_padded(
+        p_sink, (cursor != buffer.data()) ? "-inf" : "inf", p_spec);
+      return;
+    }
+
+    const int precision = (p_spec.precision < 0) ? 6 : p_spec.precision;
+    std::uint64_t scale = 1;
+    for (int i = 0; i < precision; i++) {
+      scale *= 10;
+    }
+
+    // Values beyond the range of a 64-bit integer part are emitted in
+    // scientific notation regardless of the type.
+    constexpr double integer_limit = 1e19;
+    const bool scientific = (p_spec.type == 'e') || value >= integer_limit;
+
+    int exponent = 0;
+    if (scientific && value != 0.0) {
+      while (value >= 10.0) {
+        value /= 10.0;
+        exponent++;
+      }
+      while (value < 1.0) {
+        value *= 10.0;
+        exponent--;
+      }
+    }
+
+    auto integer_part = static_cast<std::uint64_t>(value);
+    const double fraction = value - static_cast<double>(integer_part);
+    auto fraction_part =
+      static_cast<std::uint64_t>((fraction * static_cast<double>(scale)) + 0.5);
+
+    // Rounding the fraction up can carry into the integer part
+    if (fraction_part >= scale) {
+      fraction_part -= scale;
+      integer_part++;
+      if (scientific && integer_part == 10) {
+        integer_part = 1;
+        exponent++;
+      }
+    }
+
+    cursor = std::to_chars(cursor, end, integer_part).ptr;
+
+    if (precision > 0) {
+      *cursor++ = '.';
+      auto* const fraction_end = cursor + precision;
+      auto* const digits_end = std::to_chars(cursor, end, fraction_part).ptr;
+      // Right align the fraction digits and fill with leading zeros
+      const auto digit_count = digits_end - cursor;
+      std::copy_backward(cursor, digits_end, fraction_end);
+      std::fill(cursor, fraction_end - digit_count, '0');
+      cursor = fraction_end;
+    }
+
+    if (scientific) {
+      *cursor++ = 'e';
+      *cursor++ = (exponent < 0) ? '-' : '+';
+      const auto exponent_magnitude = (exponent < 0) ? -exponent : exponent;
+      if (exponent_magnitude < 10) {
+        *cursor++ = '0';
+      }
+      cursor = std::to_chars(cursor, end, exponent_magnitude).ptr;
+    }
+
+    format_padded(
+      p_sink,
+      std::string_view(buffer.data(),
+                       static_cast<size_t>(cursor - buffer.data())),
+      p_spec);
+  }
+};
+
+/**
+ * @ingroup Format
+ * @brief Formatter for strings and anything convertible to std::string_view
+ *
+ */
+template<typename T>
+  requires std::convertible_to<T, std::string_view>
+struct formatter<T>
+{
+  static constexpr bool valid(const format_spec& p_spec)
+  {
+    return p_spec.precision < 0 && (p_spec.type == 0 || p_spec.type == 's');
+  }
+
+  static void format(auto& p_sink,
+                     std::string_view p_value,
+                     const format_spec& p_spec)
+  {
+    format_padded(p_sink, p_value, p_spec);
+  }
+};
+
+/**
+ * @ingroup Format
+ * @brief Called when a format string is invalid
+ *
+ * This function is intentionally not constexpr. Calling it while parsing a
+ * format string at compile time produces a compile error that includes the
+ * message.
+ *
+ * @param p_message - description of the problem with the format string
+ */
+inline void format_string_error(const char* p_message)
+{
+  (void)p_message;
+}
+
+/**
+ * @ingroup Format
+ * @brief Parse the format spec of a placeholder
+ *
+ * @param p_format - format string
+ * @param p_index - index just after the placeholder's opening '{'
+ * @param p_spec - receives the parsed format spec
+ * @return constexpr size_t - index of the '}' ending the placeholder. If the
+ * placeholder is not terminated, `format_string_error()` is called and the
+ * size of p_format is returned.
+ */
+constexpr size_t parse_format_spec(std::string_view p_format,
+                                   size_t p_index,
+                                   format_spec& p_spec)
+{
+  if (p_index < p_format.size() && p_format[p_index] == ':') {
+    p_index++;
+
+    if (p_index < p_format.size() && p_format[p_index] == '0') {
+      p_spec.fill = '0';
+      p_index++;
+    }
+
+    unsigned width = 0;
+    while (p_index < p_format.size() && p_format[p_index] >= '0' &&
+           p_format[p_index] <= '9') {
+      width = (width * 10) + static_cast<unsigned>(p_format[p_index] - '0');
+      p_index++;
+    }
+    if (width > std::numeric_limits<std::uint8_t>::max()) {
+      format_string_error("Width cannot exceed 255");
+    }
+    p_spec.width = static_cast<std::uint8_t>(width);
+
+    if (p_index < p_format.size() && p_format[p_index] == '.') {
+      p_index++;
+      unsigned precision = 0;
+      while (p_index < p_format.size() && p_format[p_index] >= '0' &&
+             p_format[p_index] <= '9') {
+        precision =
+          (precision * 10) + static_cast<unsigned>(p_format[p_index] - '0');
+        p_index++;
+      }
+      if (precision > std::numeric_limits<std::int8_t>::max()) {
+        format_string_error("Precision is too large");
+      }
+      p_spec.precision = static_cast<std::int8_t>(precision);
+    }
+
+    if (p_index < p_format.size() && p_format[p_index] != '}') {
+      p_spec.type = p_format[p_index];
+      p_index++;
+    }
+  }
+
+  if (p_index >= p_format.size() || p_format[p_index] != '}') {
+    format_string_error("Placeholder is missing a closing '}'");
+    return p_format.size();
+  }
+
+  return p_index;
+}
+
+/**
+ * @ingroup Format
+ * @brief Format string that is parsed and checked at compile time
+ *
+ * Do not use this class directly, use `hal::format_string<Args...>`.
+ *
+ * @tparam Args - types of the arguments to be formatted
+ */
+template<typename... Args>
+class basic_format_string
+{
+public:
+  /// Literal text followed by a placeholder
+  struct field
+  {
+    /// Literal text before the placeholder
+    std::string_view text;
+    /// True if text contains escaped braces that must be collapsed
+    bool escaped = false;
+    /// Format spec of the placeholder
+    format_spec spec{};
+  };
+
+  /**
+   * @ingroup Format
+   * @brief Parse and check a format string
+   *
+   * @param p_format - format string literal
+   */
+  template<typename String>
+    requires std::convertible_to<const String&, std::string_view>
+  consteval basic_format_string(const String& p_format)  // NOLINT
+  {
+    constexpr std::array<bool (*)(const format_spec&), sizeof...(Args)>
+      validators{ &formatter<std::decay_t<Args>>::valid... };
+
+    std::string_view format = p_format;
+    size_t field_index = 0;
+    size_t text_start = 0;
+    bool escaped = false;
+
+    for (size_t index = 0; index < format.size(); index++) {
+      const char character = format[index];
+
+      if (character == '}') {
+        if (index + 1 < format.size() && format[index + 1] == '}') {
+          escaped = true;
+          index++;
+          continue;
+        }
+        format_string_error("Unmatched '}' in format string, use '}}'");
+      }
+
+      if (character != '{') {
+        continue;
+      }
+
+      if (index + 1 < format.size() && format[index + 1] == '{') {
+        escaped = true;
+        index++;
+        continue;
+      }
+
+      if (field_index >= sizeof...(Args)) {
+        format_string_error("More placeholders than arguments");
+        return;
+      }
+
+      auto& current = m_fields[field_index];
+      current.text = format.substr(text_start, index - text_start);
+      current.escaped = escaped;
+      index = parse_format_spec(format, index + 1, current.spec);
+
+      if (!validators[field_index](current.spec)) {
+        format_string_error("Format spec is not valid for the argument type");
+      }
+
+      field_index++;
+      text_start = index + 1;
+      escaped = false;
+    }
+
+    if (field_index != sizeof...(Args)) {
+      format_string_error("Fewer placeholders than arguments");
+    }
+
+    m_suffix = format.substr(text_start);
+    m_suffix_escaped = escaped;
+  }
+
+  /**
+   * @return const auto& - the text and format spec for each argument
+   */
+  constexpr const auto& fields() const
+  {
+    return m_fields;
+  }
+
+  /**
+   * @return constexpr std::string_view - the text after the last placeholder
+   */
+  constexpr std::string_view suffix() const
+  {
+    return m_suffix;
+  }
+
+  /**
+   * @return true - the suffix contains escaped braces
+   */
+  constexpr bool suffix_escaped() const
+  {
+    return m_suffix_escaped;
+  }
+
+private:
+  std::array<field, sizeof...(Args)> m_fields{};
+  std::string_view m_suffix{};
+  bool m_suffix_escaped = false;
+};
+
+/**
+ * @ingroup Format
+ * @brief Format string type for a set of argument types
+ *
+ * The argument types are not deduced from the format string, which allows the
+ * format string to be checked against the arguments passed alongside it.
+ *
+ * @tparam Args - types of the arguments to be formatted
+ */
+template<typename... Args>
+using format_string = basic_format_string<std::type_identity_t<Args>...>;
+
+/**
+ * @ingroup Format
+ * @brief Emit literal format string text, collapsing escaped braces
+ *
+ * @param p_sink - callable accepting std::string_view
+ * @param p_text - literal text from a format string
+ * @param p_escaped - true if the text contains "{{" or "}}"
+ */
+inline void format_text(auto& p_sink, std::string_view p_text, bool p_escaped)
+{
+  if (!p_escaped) {
+    if (!p_text.empty()) {
+      p_sink(p_text);
+    }
+    return;
+  }
+
+  while (!p_text.empty()) {
+    const auto brace = p_text.find_first_of("{}");
+    if (brace == p_text.npos) {
+      p_sink(p_text);
+      return;
+    }
+    // Emit up to and including the first brace of the pair, then skip the
+    // second.
+    p_sink(p_text.substr(0, brace + 1));
+    p_text.remove_prefix(brace + 2);
+  }
+}
+
+/**
+ * @ingroup Format
+ * @brief Format arguments and pass the resulting text to a sink in chunks
+ *
+ * The text is never assembled into a single buffer. Literal text is passed
+ * directly from the format string and each argument is converted in a small
+ * local buffer.
+ *
+ * @tparam Sink - callable accepting std::string_view
+ * @tparam Args - types of the arguments to be formatted
+ * @param p_sink - receives each chunk of text in order
+ * @param p_format - format string, checked at compile time
+ * @param p_args - arguments to be formatted
+ */
+template<typename Sink, typename... Args>
+void format_to(Sink&& p_sink,
+               format_string<Args...> p_format,
+               const Args&... p_args)
+{
+  const auto& fields = p_format.fields();
+
+  [&]<size_t... Index>(std::index_sequence<Index...>) {
+    ((format_text(p_sink, fields[Index].text, fields[Index].escaped),
+      formatter<std::decay_t<Args>>::format(
+        p_sink, p_args, fields[Index].spec)),
+     ...);
+  }(std::index_sequence_for<Args...>{});
+
+  format_text(p_sink, p_format.suffix(), p_format.suffix_escaped());
+}
+}  // namespace hal
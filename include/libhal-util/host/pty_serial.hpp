@@ -0,0 +1,119 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include <libhal/error.hpp>
+#include <libhal/serial.hpp>
+#include <libhal/units.hpp>
+
+namespace hal {
+/**
+ * @ingroup Host
+ * @brief serial port backed by one end of a Linux pseudo-terminal pair
+ *
+ * A pseudo-terminal (PTY) is a pair of connected character devices. Bytes
+ * written to one end are read from the other, through the same kernel tty
+ * layer a USB serial adapter uses. Create the controlling end with create()
+ * and either open the other end in the same process with open_peer(), or hand
+ * peer_path() to another program:
+ *
+ *     auto controller = HAL_CHECK(hal::pty_serial::create());
+ *     auto device = HAL_CHECK(controller.open_peer());
+ *     HAL_CHECK(hal::write(device, "hello"));
+ *
+ * Both ends are put in raw mode and use non-blocking file descriptors, so
+ * read() returns whatever has arrived, as on a microcontroller. write() waits
+ * with epoll when the kernel buffer is full. wait_readable() blocks until data
+ * arrives, which keeps benchmarks from spinning.
+ */
+class pty_serial : public hal::serial
+{
+public:
+  /**
+   * @ingroup Host
+   * @brief Open a new pseudo-terminal pair and return its controlling end
+   *
+   * @return result<pty_serial> - the controlling end of the pair
+   * @throws std::errc - the errno of the system call that failed
+   */
+  static result<pty_serial> create();
+
+  /**
+   * @ingroup Host
+   * @brief Open the other end of the pair in this process
+   *
+   * @return result<pty_serial> - the device end of the pair
+   * @throws std::errc::invalid_argument - if this is not a controlling end
+   * @throws std::errc - the errno of the system call that failed
+   */
+  result<pty_serial> open_peer();
+
+  /**
+   * @ingroup Host
+   * @brief Get the path of the device end of the pair
+   *
+   * @return std::string_view - path such as "/dev/pts/3", or an empty string
+   * for a device end
+   */
+  [[nodiscard]] std::string_view peer_path() const;
+
+  /**
+   * @ingroup Host
+   * @brief Wait until data can be read
+   *
+   * @param p_timeout - maximum time to wait, rounded down to milliseconds
+   * @return result<bool> - true if data can be read, false on timeout
+   * @throws std::errc - the errno of epoll_wait
+   */
+  result<bool> wait_readable(hal::time_duration p_timeout);
+
+  /**
+   * @ingroup Host
+   * @brief Get the file descriptor of this end
+   *
+   * @return int - file descriptor, valid for the lifetime of this object
+   */
+  [[nodiscard]] int native_handle() const
+  {
+    return m_fd;
+  }
+
+  pty_serial(const pty_serial&) = delete;
+  pty_serial& operator=(const pty_serial&) = delete;
+  pty_serial(pty_serial&& p_other) noexcept;
+  pty_serial& operator=(pty_serial&& p_other) noexcept;
+  ~pty_serial() override;
+
+private:
+  pty_serial(int p_fd, int p_epoll_fd);
+
+  status driver_configure(const settings& p_settings) override;
+  result<write_t> driver_write(std::span<const hal::byte> p_data) override;
+  result<read_t> driver_read(std::span<hal::byte> p_data) override;
+  result<flush_t> driver_flush() override;
+
+  result<bool> wait_for(std::uint32_t p_events, int p_timeout_ms);
+  void close();
+
+  int m_fd = -1;
+  int m_epoll_fd = -1;
+  std::array<char, 64> m_peer_path{};
+};
+}  // namespace hal
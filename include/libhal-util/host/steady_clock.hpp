@@ -0,0 +1,44 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <libhal/steady_clock.hpp>
+
+/**
+ * @defgroup Host Host
+ * Implementations of libhal interfaces for Linux hosts, for running and
+ * benchmarking the utilities against real OS timing and I/O on a workstation.
+ *
+ * These are built into the separate `libhal-util-host` library when the
+ * `LIBHAL_UTIL_BUILD_HOST` CMake option is enabled, and are never part of
+ * firmware builds.
+ */
+
+namespace hal {
+/**
+ * @ingroup Host
+ * @brief steady_clock backed by the Linux CLOCK_MONOTONIC_RAW clock
+ *
+ * Ticks are nanoseconds. CLOCK_MONOTONIC_RAW is not slewed by NTP, so
+ * intervals measured with it match the hardware counter, like a steady_clock
+ * on a microcontroller.
+ */
+class host_steady_clock : public hal::steady_clock
+{
+private:
+  frequency_t driver_frequency() override;
+  uptime_t driver_uptime() override;
+};
+}  // namespace hal
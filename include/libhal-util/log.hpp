@@ -0,0 +1,458 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include <libhal/serial.hpp>
+#include <libhal/units.hpp>
+
+#include "as_bytes.hpp"
+#include "format.hpp"
+#include "serial.hpp"
+
+/**
+ * @defgroup Log Log
+ * Deferred binary logging over a serial port.
+ *
+ * Rather than formatting text on the device, `hal::log` writes a 32-bit id
+ * for the format string followed by the raw argument values. Integers are
+ * varint encoded so small values only take a single byte. A host side decoder
+ * (see `hal::log_decoder` and the `hal_log_decoder` tool) looks the id up in
+ * the firmware image and produces the formatted text.
+ *
+ * Each call site stores a record in the firmware image containing a magic
+ * marker, the id, the argument signature and the format string. The decoder
+ * finds these records by scanning the image for the marker, so no linker
+ * script changes are needed.
+ *
+ * Wire format of each message:
+ *
+ *     [varint payload length][id: 4 bytes little endian][arguments...]
+ *
+ * Argument encodings:
+ *
+ * | signature | types              | encoding                              |
+ * |-----------|--------------------|---------------------------------------|
+ * | u         | unsigned integers  | LEB128 varint                         |
+ * | i         | signed integers    | zigzag LEB128 varint                  |
+ * | b         | bool               | 1 byte                                |
+ * | c         | char               | 1 byte                                |
+ * | f         | float              | 4 bytes little endian                 |
+ * | d         | double             | 8 bytes little endian                 |
+ * | s         | strings            | varint length followed by the bytes   |
+ */
+
+namespace hal {
+/**
+ * @ingroup Log
+ * @brief String literal that can be used as a template argument
+ *
+ * @tparam N - size of the string literal including the null terminator
+ */
+template<size_t N>
+struct fixed_string
+{
+  /**
+   * @ingroup Log
+   * @brief Construct from a string literal
+   *
+   * @param p_string - string literal
+   */
+  constexpr fixed_string(const char (&p_string)[N])  // NOLINT
+  {
+    std::copy_n(p_string, N, characters.begin());
+  }
+
+  /**
+   * @return constexpr std::string_view - the string without the null
+   * terminator
+   */
+  constexpr std::string_view view() const
+  {
+    return { characters.data(), N - 1 };
+  }
+
+  /// Storage for the string and its null terminator
+  std::array<char, N> characters{};
+};
+
+/**
+ * @ingroup Log
+ * @brief Marker placed at the start of each log record in a firmware image
+ *
+ */
+inline constexpr std::array<char, 8> log_record_marker = {
+  '\x7F', 'H', 'A', 'L', 'L', 'O', 'G', '\x01'
+};
+
+/**
+ * @ingroup Log
+ * @brief Compute the 32-bit FNV-1a hash of a string
+ *
+ * @param p_string - string to hash
+ * @param p_hash - hash to continue from
+ * @return constexpr std::uint32_t - hash of the string
+ */
+constexpr std::uint32_t log_hash(std::string_view p_string,
+                                 std::uint32_t p_hash = 2166136261U)
+{
+  for (const auto character : p_string) {
+    p_hash ^= static_cast<std::uint8_t>(character);
+    p_hash *= 16777619U;
+  }
+  return p_hash;
+}
+
+/**
+ * @ingroup Log
+ * @brief Number of bytes required to varint encode a value
+ *
+ * @param p_value - value to encode
+ * @return constexpr size_t - number of bytes
+ */
+constexpr size_t log_varint_size(std::uint64_t p_value)
+{
+  size_t size = 1;
+  while (p_value >= 0x80) {
+    p_value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+/**
+ * @ingroup Log
+ * @brief Varint encode a value
+ *
+ * @param p_value - value to encode
+ * @param p_output - buffer with at least `log_varint_size(p_value)` bytes
+ * @return constexpr hal::byte* - pointer after the last byte written
+ */
+constexpr hal::byte* log_varint_encode(std::uint64_t p_value,
+                                       hal::byte* p_output)
+{
+  while (p_value >= 0x80) {
+    *p_output++ = static_cast<hal::byte>(p_value | 0x80);
+    p_value >>= 7;
+  }
+  *p_output++ = static_cast<hal::byte>(p_value);
+  return p_output;
+}
+
+/**
+ * @ingroup Log
+ * @brief Encodes values of type T for binary logging
+ *
+ * Each specialization provides the signature character used by the decoder,
+ * the maximum number of bytes a value can take in the fixed part of a
+ * message, and functions to size and encode a value.
+ *
+ * @tparam T - type of the argument
+ */
+template<typename T>
+struct log_argument;
+
+/**
+ * @ingroup Log
+ * @brief Unsigned integers are varint encoded
+ *
+ */
+template<std::unsigned_integral T>
+struct log_argument<T>
+{
+  static constexpr char signature = 'u';
+  static constexpr size_t max_size = (sizeof(T) * 8 + 6) / 7;
+
+  static constexpr size_t size(T p_value)
+  {
+    return log_varint_size(p_value);
+  }
+
+  static constexpr hal::byte* encode(T p_value, hal::byte* p_output)
+  {
+    return log_varint_encode(p_value, p_output);
+  }
+};
+
+/**
+ * @ingroup Log
+ * @brief Signed integers are zigzag and varint encoded so that small negative
+ * values are also small
+ *
+ */
+template<std::signed_integral T>
+struct log_argument<T>
+{
+  static constexpr char signature = 'i';
+  static constexpr size_t max_size = (sizeof(T) * 8 + 6) / 7;
+
+  static constexpr std::uint64_t zigzag(T p_value)
+  {
+    const auto value = static_cast<std::int64_t>(p_value);
+    return (static_cast<std::uint64_t>(value) << 1) ^
+           static_cast<std::uint64_t>(value >> 63);
+  }
+
+  static constexpr size_t size(T p_value)
+  {
+    return log_varint_size(zigzag(p_value));
+  }
+
+  static constexpr hal::byte* encode(T p_value, hal::byte* p_output)
+  {
+    return log_varint_encode(zigzag(p_value), p_output);
+  }
+};
+
+/**
+ * @ingroup Log
+ * @brief bool is encoded as a single byte
+ *
+ */
+template<>
+struct log_argument<bool>
+{
+  static constexpr char signature = 'b';
+  static constexpr size_t max_size = 1;
+
+  static constexpr size_t size(bool)
+  {
+    return max_size;
+  }
+
+  static constexpr hal::byte* encode(bool p_value, hal::byte* p_output)
+  {
+    *p_output++ = p_value ? 1 : 0;
+    return p_output;
+  }
+};
+
+/**
+ * @ingroup Log
+ * @brief char is encoded as a single byte
+ *
+ */
+template<>
+struct log_argument<char>
+{
+  static constexpr char signature = 'c';
+  static constexpr size_t max_size = 1;
+
+  static constexpr size_t size(char)
+  {
+    return max_size;
+  }
+
+  static constexpr hal::byte* encode(char p_value, hal::byte* p_output)
+  {
+    *p_output++ = static_cast<hal::byte>(p_value);
+    return p_output;
+  }
+};
+
+/**
+ * @ingroup Log
+ * @brief float and double are written as their IEEE-754 bits in little endian
+ * byte order
+ *
+ */
+template<std::floating_point T>
+  requires(sizeof(T) == 4 || sizeof(T) == 8)
+struct log_argument<T>
+{
+  using bits_t =
+    std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+  static constexpr char signature = (sizeof(T) == 4) ? 'f' : 'd';
+  static constexpr size_t max_size = sizeof(T);
+
+  static constexpr size_t size(T)
+  {
+    return max_size;
+  }
+
+  static constexpr hal::byte* encode(T p_value, hal::byte* p_output)
+  {
+    auto bits = std::bit_cast<bits_t>(p_value);
+    for (size_t index = 0; index < sizeof(T); index++) {
+      *p_output++ = static_cast<hal::byte>(bits);
+      bits >>= 8;
+    }
+    return p_output;
+  }
+};
+
+/**
+ * @ingroup Log
+ * @brief Strings are encoded as a varint length followed by the characters
+ *
+ * Only the length is part of the fixed portion of the message. The characters
+ * are written directly from the string.
+ */
+template<typename T>
+  requires std::convertible_to<T, std::string_view>
+struct log_argument<T>
+{
+  static constexpr char signature = 's';
+  static constexpr size_t max_size = 10;
+
+  static constexpr size_t size(std::string_view p_value)
+  {
+    return log_varint_size(p_value.size()) + p_value.size();
+  }
+
+  static constexpr hal::byte* encode(std::string_view p_value,
+                                     hal::byte* p_output)
+  {
+    return log_varint_encode(p_value.size(), p_output);
+  }
+};
+
+/**
+ * @ingroup Log
+ * @brief Signature string for a set of log argument types
+ *
+ * @tparam Args - types of the arguments
+ */
+template<typename... Args>
+inline constexpr std::array<char, sizeof...(Args) + 1> log_signature{
+  log_argument<std::decay_t<Args>>::signature...,
+  '\0'
+};
+
+/**
+ * @ingroup Log
+ * @brief Id written at the start of each message for a log call
+ *
+ * The id is the hash of the null terminated signature followed by the format
+ * string, so the same format string used with different argument types gets
+ * a different id.
+ *
+ * @tparam Format - format string
+ * @tparam Args - types of the arguments
+ */
+template<fixed_string Format, typename... Args>
+inline constexpr std::uint32_t log_id =
+  log_hash(Format.view(),
+           log_hash({ log_signature<Args...>.data(),
+                      log_signature<Args...>.size() }));
+
+/**
+ * @ingroup Log
+ * @brief Generate the record stored in the firmware image for a log call
+ *
+ * The record holds `log_record_marker`, the 32-bit id in little endian byte
+ * order, the null terminated argument signature and the null terminated
+ * format string.
+ *
+ * @tparam Format - format string
+ * @tparam Args - types of the arguments
+ * @return constexpr auto - std::array<char, N> holding the record
+ */
+template<fixed_string Format, typename... Args>
+constexpr auto make_log_record()
+{
+  constexpr auto& signature = log_signature<Args...>;
+  constexpr auto format = Format.view();
+  constexpr auto id = log_id<Format, Args...>;
+
+  std::array<char,
+             log_record_marker.size() + sizeof(id) + signature.size() +
+               format.size() + 1>
+    record{};
+
+  auto* cursor = std::copy(
+    log_record_marker.begin(), log_record_marker.end(), record.begin());
+  for (size_t index = 0; index < sizeof(id); index++) {
+    *cursor++ = static_cast<char>((id >> (index * 8)) & 0xFF);
+  }
+  cursor = std::copy(signature.begin(), signature.end(), cursor);
+  std::copy(format.begin(), format.end(), cursor);
+
+  return record;
+}
+
+/**
+ * @ingroup Log
+ * @brief Write a binary log message to a serial port and drop the return
+ * value
+ *
+ * The format string uses the same syntax as `hal::format_to` and is checked
+ * against the arguments at compile time. Formatting happens on the host.
+ *
+ *     hal::log<"temperature = {:.2f}C, status = 0x{:02X}">(
+ *       serial, temperature, status);
+ *
+ * @tparam Format - format string
+ * @tparam Args - types of the arguments
+ * @param p_serial - serial port to write the message to
+ * @param p_args - arguments to be logged
+ */
+template<fixed_string Format, typename... Args>
+void log(serial& p_serial, const Args&... p_args)
+{
+  [[maybe_unused]] constexpr format_string<Args...> checked_format(
+    Format.view());
+
+  // The record is never read by the device, it only needs to be present in
+  // the image for the decoder to find. `retain` keeps it through
+  // --gc-sections.
+  [[gnu::used, gnu::retain]] static constexpr auto record =
+    make_log_record<Format, Args...>();
+
+  constexpr auto id = log_id<Format, Args...>;
+
+  const size_t payload_size =
+    sizeof(id) + (log_argument<std::decay_t<Args>>::size(p_args) + ... + 0);
+
+  constexpr size_t max_header_size = 10 + sizeof(id);
+  std::array<hal::byte,
+             max_header_size +
+               (log_argument<std::decay_t<Args>>::max_size + ... + 0)>
+    buffer{};
+
+  auto* cursor = log_varint_encode(payload_size, buffer.data());
+  for (size_t index = 0; index < sizeof(id); index++) {
+    *cursor++ = static_cast<hal::byte>(id >> (index * 8));
+  }
+
+  auto flush = [&p_serial, &buffer, &cursor]() {
+    const auto length = static_cast<size_t>(cursor - buffer.data());
+    (void)hal::write(p_serial, std::span(buffer.data(), length));
+    cursor = buffer.data();
+  };
+
+  auto encode = [&cursor, &flush, &p_serial]<typename T>(const T& p_arg) {
+    using argument = log_argument<std::decay_t<T>>;
+    cursor = argument::encode(p_arg, cursor);
+    if constexpr (argument::signature == 's') {
+      flush();
+      (void)hal::write(p_serial, std::string_view(p_arg));
+    }
+  };
+
+  (encode(p_args), ...);
+  flush();
+}
+}  // namespace hal
@@ -0,0 +1,379 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <libhal/units.hpp>
+
+#include "format.hpp"
+#include "log.hpp"
+
+namespace hal {
+/**
+ * @ingroup Log
+ * @brief Host side decoder for messages written by `hal::log`
+ *
+ * Records are loaded from a firmware image, then the bytes received from the
+ * device are fed in and decoded into text one message at a time. This class
+ * allocates and is intended for host tools and tests, not for devices.
+ *
+ */
+class log_decoder
+{
+public:
+  /// Information about a log call site loaded from a firmware image
+  struct record
+  {
+    /// One signature character per argument, see `hal::log_argument`
+    std::string signature;
+    /// Format string of the call site
+    std::string format;
+  };
+
+  /// Messages larger than this are treated as corrupt
+  static constexpr size_t max_message_size = 64 * 1024;
+
+  /**
+   * @brief Find and load all log records within a firmware image
+   *
+   * The image can be an ELF file or a raw binary. Candidates whose id does
+   * not match their contents are ignored.
+   *
+   * @param p_image - contents of the firmware image
+   * @return size_t - number of records loaded
+   */
+  size_t load_records(std::span<const hal::byte> p_image)
+  {
+    const std::boyer_moore_horspool_searcher searcher(
+      log_record_marker.begin(), log_record_marker.end());
+    const auto marker = std::string_view(log_record_marker.data(),
+                                         log_record_marker.size());
+    const auto image = std::string_view(
+      reinterpret_cast<const char*>(p_image.data()), p_image.size());
+
+    size_t loaded = 0;
+    auto position = image.begin();
+    while (true) {
+      position = std::search(position, image.end(), searcher);
+      if (position == image.end()) {
+        break;
+      }
+      auto remaining = image.substr(
+        static_cast<size_t>(position - image.begin()) + marker.size());
+      position++;
+
+      if (remaining.size() < sizeof(std::uint32_t)) {
+        continue;
+      }
+      std::uint32_t id = 0;
+      for (size_t index = 0; index < sizeof(id); index++) {
+        id |= static_cast<std::uint32_t>(
+                static_cast<std::uint8_t>(remaining[index]))
+              << (index * 8);
+      }
+      remaining.remove_prefix(sizeof(id));
+
+      const auto signature_end = remaining.find('\0');
+      if (signature_end == remaining.npos) {
+        continue;
+      }
+      const auto signature = remaining.substr(0, signature_end);
+      remaining.remove_prefix(signature_end + 1);
+
+      const auto format_end = remaining.find('\0');
+      if (format_end == remaining.npos) {
+        continue;
+      }
+      const auto format = remaining.substr(0, format_end);
+
+      // The signature hash includes its null terminator
+      const auto signature_with_null =
+        std::string_view(signature.data(), signature.size() + 1);
+      const auto expected_id =
+        log_hash(format, log_hash(signature_with_null));
+      if (id != expected_id) {
+        continue;
+      }
+
+      m_records[id] = record{
+        .signature = std::string(signature),
+        .format = std::string(format),
+      };
+      loaded++;
+    }
+
+    return loaded;
+  }
+
+  /**
+   * @brief Get the records that have been loaded, keyed by id
+   *
+   * @return const std::map<std::uint32_t, record>& - loaded records
+   */
+  const std::map<std::uint32_t, record>& records() const
+  {
+    return m_records;
+  }
+
+  /**
+   * @brief Append bytes received from the device
+   *
+   * @param p_data - received bytes, which may contain partial messages
+   */
+  void feed(std::span<const hal::byte> p_data)
+  {
+    m_pending.insert(m_pending.end(), p_data.begin(), p_data.end());
+  }
+
+  /**
+   * @brief Decode the next complete message
+   *
+   * Messages with an unknown id or malformed arguments are returned as a
+   * diagnostic describing the problem.
+   *
+   * @return std::optional<std::string> - decoded text or std::nullopt if a
+   * complete message has not been received yet
+   */
+  std::optional<std::string> next()
+  {
+    auto pending = std::span<const hal::byte>(m_pending).subspan(m_offset);
+
+    std::uint64_t size = 0;
+    size_t header_size = 0;
+    if (!read_varint(pending, header_size, size)) {
+      if (header_size >= max_varint_size) {
+        m_offset++;
+        return "<log stream out of sync>";
+      }
+      return std::nullopt;
+    }
+
+    if (size < sizeof(std::uint32_t) || size > max_message_size) {
+      m_offset++;
+      return "<log stream out of sync>";
+    }
+
+    if (pending.size() - header_size < size) {
+      return std::nullopt;
+    }
+
+    auto text = decode(pending.subspan(header_size, size));
+    m_offset += header_size + size;
+
+    // Drop consumed bytes once they make up the bulk of the buffer
+    if (m_offset > m_pending.size() / 2) {
+      const auto consumed = static_cast<std::ptrdiff_t>(m_offset);
+      m_pending.erase(m_pending.begin(), m_pending.begin() + consumed);
+      m_offset = 0;
+    }
+
+    return text;
+  }
+
+private:
+  static constexpr size_t max_varint_size = 10;
+
+  struct string_sink
+  {
+    void operator()(std::string_view p_text)
+    {
+      output->append(p_text);
+    }
+    std::string* output;
+  };
+
+  static bool read_varint(std::span<const hal::byte> p_data,
+                          size_t& p_length,
+                          std::uint64_t& p_value)
+  {
+    p_value = 0;
+    p_length = 0;
+    while (p_length < p_data.size() && p_length < max_varint_size) {
+      const auto current = p_data[p_length];
+      p_value |= static_cast<std::uint64_t>(current & 0x7F) << (p_length * 7);
+      p_length++;
+      if ((current & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template<typename T>
+  static bool read_little_endian(std::span<const hal::byte>& p_data, T& p_value)
+  {
+    if (p_data.size() < sizeof(T)) {
+      return false;
+    }
+    std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> bits = 0;
+    for (size_t index = 0; index < sizeof(T); index++) {
+      bits |= static_cast<decltype(bits)>(p_data[index]) << (index * 8);
+    }
+    p_value = std::bit_cast<T>(bits);
+    p_data = p_data.subspan(sizeof(T));
+    return true;
+  }
+
+  static bool format_argument(string_sink& p_sink,
+                              char p_signature,
+                              std::span<const hal::byte>& p_data,
+                              const format_spec& p_spec)
+  {
+    std::uint64_t value = 0;
+    size_t length = 0;
+
+    switch (p_signature) {
+      case 'u':
+      case 'i':
+      case 's': {
+        if (!read_varint(p_data, length, value)) {
+          return false;
+        }
+        p_data = p_data.subspan(length);
+        break;
+      }
+      case 'b':
+      case 'c': {
+        if (p_data.empty()) {
+          return false;
+        }
+        value = p_data[0];
+        p_data = p_data.subspan(1);
+        break;
+      }
+      default:
+        break;
+    }
+
+    switch (p_signature) {
+      case 'u':
+        formatter<std::uint64_t>::format(p_sink, value, p_spec);
+        return true;
+      case 'i': {
+        const auto signed_value = static_cast<std::int64_t>(value >> 1) ^
+                                  -static_cast<std::int64_t>(value & 1);
+        formatter<std::int64_t>::format(p_sink, signed_value, p_spec);
+        return true;
+      }
+      case 'b':
+        formatter<bool>::format(p_sink, value != 0, p_spec);
+        return true;
+      case 'c':
+        formatter<char>::format(p_sink, static_cast<char>(value), p_spec);
+        return true;
+      case 'f': {
+        float float_value = 0;
+        if (!read_little_endian(p_data, float_value)) {
+          return false;
+        }
+        formatter<float>::format(p_sink, float_value, p_spec);
+        return true;
+      }
+      case 'd': {
+        double double_value = 0;
+        if (!read_little_endian(p_data, double_value)) {
+          return false;
+        }
+        formatter<double>::format(p_sink, double_value, p_spec);
+        return true;
+      }
+      case 's': {
+        if (p_data.size() < value) {
+          return false;
+        }
+        const auto text = std::string_view(
+          reinterpret_cast<const char*>(p_data.data()), value);
+        formatter<std::string_view>::format(p_sink, text, p_spec);
+        p_data = p_data.subspan(value);
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  std::string decode(std::span<const hal::byte> p_message) const
+  {
+    std::uint32_t id = 0;
+    for (size_t index = 0; index < sizeof(id); index++) {
+      id |= static_cast<std::uint32_t>(p_message[index]) << (index * 8);
+    }
+    auto arguments = p_message.subspan(sizeof(id));
+
+    const auto found = m_records.find(id);
+    if (found == m_records.end()) {
+      std::array<char, 32> text{};
+      std::snprintf(text.data(), text.size(), "<unknown log id 0x%08X>", id);
+      return text.data();
+    }
+
+    const auto& [signature, format] = found->second;
+    std::string output;
+    string_sink sink{ &output };
+    size_t argument = 0;
+    size_t text_start = 0;
+
+    for (size_t index = 0; index < format.size(); index++) {
+      const char character = format[index];
+      const bool escaped = index + 1 < format.size() &&
+                           (character == '{' || character == '}') &&
+                           format[index + 1] == character;
+      if (escaped) {
+        output.append(format, text_start, index + 1 - text_start);
+        index++;
+        text_start = index + 1;
+        continue;
+      }
+      if (character != '{') {
+        continue;
+      }
+
+      output.append(format, text_start, index - text_start);
+      format_spec spec{};
+      index = parse_format_spec(format, index + 1, spec);
+      text_start = index + 1;
+
+      if (argument >= signature.size() ||
+          !format_argument(sink, signature[argument], arguments, spec)) {
+        return output + "<malformed log message>";
+      }
+      argument++;
+    }
+
+    if (text_start < format.size()) {
+      output.append(format, text_start);
+    }
+
+    return output;
+  }
+
+  std::map<std::uint32_t, record> m_records;
+  std::vector<hal::byte> m_pending;
+  size_t m_offset = 0;
+};
+}  // namespace hal
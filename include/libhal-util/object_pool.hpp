@@ -0,0 +1,460 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * @defgroup ObjectPool Object Pool
+ * Fixed capacity storage for objects of one type, such as CAN frames or
+ * message buffers, allocated and freed in constant time without the heap.
+ *
+ *     hal::object_pool<hal::can::message_t, 16> frames;
+ *
+ *     auto frame = frames.emplace();
+ *     if (frame) {
+ *       frame->id = 0x111;
+ *       // ...
+ *     }  // frame is destroyed and its slot freed here
+ */
+
+namespace hal {
+/**
+ * @ingroup ObjectPool
+ * @brief Set of free slot indices stored one bit per slot
+ *
+ * A set bit marks a free slot. A summary word has a set bit for each 32-bit
+ * word of the bitmap with a free slot, so take() finds the lowest free slot
+ * with two count trailing zeros, which are single instructions on most cores
+ * (RBIT + CLZ on ARMv7-M), and no search loop.
+ *
+ * Not safe to use from more than one context at a time.
+ *
+ * @tparam Count - number of slots, at most 1024
+ */
+template<size_t Count>
+class slot_bitmap
+{
+public:
+  using word_t = std::uint32_t;
+  static constexpr size_t word_bits = sizeof(word_t) * 8;
+  static constexpr size_t word_count = (Count + word_bits - 1) / word_bits;
+  static_assert(word_count <= word_bits,
+                "slot_bitmap supports at most 1024 slots");
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Create a bitmap with every slot free
+   *
+   */
+  constexpr slot_bitmap()
+  {
+    for (size_t index = 0; index < word_count; index++) {
+      m_words[index] = initial_word(index);
+      m_summary |= word_t{ 1 } << index;
+    }
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Mark the lowest free slot as used
+   *
+   * @return size_t - index of the slot, or Count if every slot is used
+   */
+  constexpr size_t take()
+  {
+    if (m_summary == 0) {
+      return Count;
+    }
+    const auto index = static_cast<size_t>(std::countr_zero(m_summary));
+    const auto word = m_words[index];
+    const auto remaining = static_cast<word_t>(word & (word - 1));
+    m_words[index] = remaining;
+    m_summary &= ~(static_cast<word_t>(remaining == 0) << index);
+    return index * word_bits + std::countr_zero(word);
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Mark a slot as free
+   *
+   * @param p_slot - index of a slot returned by take()
+   */
+  constexpr void put(size_t p_slot)
+  {
+    const auto index = p_slot / word_bits;
+    m_words[index] |= word_t{ 1 } << (p_slot % word_bits);
+    m_summary |= word_t{ 1 } << index;
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Count the free slots
+   *
+   * @return size_t - number of free slots
+   */
+  [[nodiscard]] constexpr size_t available() const
+  {
+    size_t count = 0;
+    for (const auto word : m_words) {
+      count += std::popcount(word);
+    }
+    return count;
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Get the initial contents of a word of a bitmap
+   *
+   * @param p_index - index of the word
+   * @return word_t - a set bit for each slot covered by the word
+   */
+  static constexpr word_t initial_word(size_t p_index)
+  {
+    const auto slots = Count - p_index * word_bits;
+    if (slots >= word_bits) {
+      return ~word_t{ 0 };
+    }
+    return static_cast<word_t>((word_t{ 1 } << slots) - 1);
+  }
+
+private:
+  std::array<word_t, word_count> m_words{};
+  word_t m_summary = 0;
+};
+
+/**
+ * @ingroup ObjectPool
+ * @brief Set of free slot indices safe to use from interrupts and threads
+ *
+ * Same bitmap as slot_bitmap, but each word is an atomic. take() checks one
+ * word at a time instead of using a summary word, which could not be updated
+ * atomically together with the word it describes. A slot is claimed with a
+ * compare and exchange, retried only if another context changed the same word
+ * in between. put() is a single atomic OR. Neither disables interrupts or
+ * blocks.
+ *
+ * The words are 32-bit so the operations are lock-free on 32-bit cores with
+ * exclusive access instructions (LDREX/STREX on ARMv7-M). Cores without them,
+ * such as the Cortex-M0, fall back to the toolchain's atomic library.
+ *
+ * @tparam Count - number of slots
+ */
+template<size_t Count>
+class atomic_slot_bitmap
+{
+public:
+  using word_t = std::uint32_t;
+  static constexpr size_t word_bits = sizeof(word_t) * 8;
+  static constexpr size_t word_count = (Count + word_bits - 1) / word_bits;
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Create a bitmap with every slot free
+   *
+   */
+  atomic_slot_bitmap()
+  {
+    for (size_t index = 0; index < word_count; index++) {
+      m_words[index].store(slot_bitmap<Count>::initial_word(index),
+                           std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Mark the lowest free slot as used
+   *
+   * Acquires the writes made to the slot by the context that freed it.
+   *
+   * @return size_t - index of the slot, or Count if every slot is used
+   */
+  size_t take()
+  {
+    for (size_t index = 0; index < word_count; index++) {
+      auto& word = m_words[index];
+      auto current = word.load(std::memory_order_relaxed);
+      while (current != 0) {
+        if (word.compare_exchange_weak(current,
+                                       current & (current - 1),
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+          return index * word_bits + std::countr_zero(current);
+        }
+      }
+    }
+    return Count;
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Mark a slot as free
+   *
+   * Releases the writes made to the slot to the context that takes it next.
+   *
+   * @param p_slot - index of a slot returned by take()
+   */
+  void put(size_t p_slot)
+  {
+    m_words[p_slot / word_bits].fetch_or(word_t{ 1 } << (p_slot % word_bits),
+                                         std::memory_order_release);
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Count the free slots
+   *
+   * The result may be out of date by the time it is used.
+   *
+   * @return size_t - number of free slots
+   */
+  [[nodiscard]] size_t available() const
+  {
+    size_t count = 0;
+    for (const auto& word : m_words) {
+      count += std::popcount(word.load(std::memory_order_relaxed));
+    }
+    return count;
+  }
+
+private:
+  std::array<std::atomic<word_t>, word_count> m_words;
+};
+
+/**
+ * @ingroup ObjectPool
+ * @brief Owning handle to an object in a pool
+ *
+ * Like std::unique_ptr, but returns the object to its pool when destroyed. A
+ * default constructed or moved from handle is empty.
+ *
+ * @tparam T - type of the object
+ * @tparam Pool - type of the pool the object belongs to
+ */
+template<typename T, typename Pool>
+class pool_ptr
+{
+public:
+  constexpr pool_ptr() = default;
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Take ownership of an object in a pool
+   *
+   * @param p_pool - pool the object was created in
+   * @param p_object - the object
+   */
+  constexpr pool_ptr(Pool* p_pool, T* p_object)
+    : m_pool(p_pool)
+    , m_object(p_object)
+  {
+  }
+
+  pool_ptr(const pool_ptr&) = delete;
+  pool_ptr& operator=(const pool_ptr&) = delete;
+
+  constexpr pool_ptr(pool_ptr&& p_other) noexcept
+    : m_pool(std::exchange(p_other.m_pool, nullptr))
+    , m_object(std::exchange(p_other.m_object, nullptr))
+  {
+  }
+
+  constexpr pool_ptr& operator=(pool_ptr&& p_other) noexcept
+  {
+    if (this != &p_other) {
+      reset();
+      m_pool = std::exchange(p_other.m_pool, nullptr);
+      m_object = std::exchange(p_other.m_object, nullptr);
+    }
+    return *this;
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Destroy the object and free its slot, leaving the handle empty
+   *
+   */
+  constexpr void reset()
+  {
+    if (m_object != nullptr) {
+      m_pool->destroy(std::exchange(m_object, nullptr));
+    }
+  }
+
+  [[nodiscard]] constexpr T* get() const
+  {
+    return m_object;
+  }
+
+  constexpr T& operator*() const
+  {
+    return *m_object;
+  }
+
+  constexpr T* operator->() const
+  {
+    return m_object;
+  }
+
+  /**
+   * @return true - the handle owns an object
+   */
+  constexpr explicit operator bool() const
+  {
+    return m_object != nullptr;
+  }
+
+  ~pool_ptr()
+  {
+    reset();
+  }
+
+private:
+  Pool* m_pool = nullptr;
+  T* m_object = nullptr;
+};
+
+/**
+ * @ingroup ObjectPool
+ * @brief Fixed capacity pool of objects with constant time allocate and free
+ *
+ * Storage for Capacity objects is part of the pool, so a pool declared as a
+ * global or static variable never touches the heap. Free slots are tracked in
+ * a Bitmap, one bit per slot, and emplace() constructs the object in the
+ * lowest free slot.
+ *
+ * The pool must outlive every handle created from it, and cannot be copied or
+ * moved as handles point into it.
+ *
+ * @tparam T - type of the objects
+ * @tparam Capacity - maximum number of live objects
+ * @tparam Bitmap - slot_bitmap or atomic_slot_bitmap
+ */
+template<typename T, size_t Capacity, typename Bitmap>
+class basic_object_pool
+{
+public:
+  static_assert(Capacity > 0, "Pool capacity must be at least 1");
+
+  using handle = pool_ptr<T, basic_object_pool>;
+
+  basic_object_pool() = default;
+  basic_object_pool(const basic_object_pool&) = delete;
+  basic_object_pool& operator=(const basic_object_pool&) = delete;
+  basic_object_pool(basic_object_pool&&) = delete;
+  basic_object_pool& operator=(basic_object_pool&&) = delete;
+
+  /**
+   * @return constexpr size_t - the maximum number of live objects
+   */
+  [[nodiscard]] static constexpr size_t capacity()
+  {
+    return Capacity;
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Construct an object in a free slot
+   *
+   * @param p_args - arguments forwarded to the constructor of T
+   * @return handle - owner of the new object, or an empty handle if every
+   * slot is in use
+   */
+  template<typename... Args>
+  [[nodiscard]] handle emplace(Args&&... p_args)
+  {
+    const auto slot = m_free.take();
+    if (slot == Capacity) {
+      return handle{};
+    }
+    T* object =
+      std::construct_at(&m_slots[slot].object, std::forward<Args>(p_args)...);
+    return handle(this, object);
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Count the free slots
+   *
+   * @return size_t - number of objects that can still be created
+   */
+  [[nodiscard]] size_t available() const
+  {
+    return m_free.available();
+  }
+
+  /**
+   * @ingroup ObjectPool
+   * @brief Destroy an object and free its slot
+   *
+   * Called by handle. Only call this directly for an object released from its
+   * handle.
+   *
+   * @param p_object - object created by this pool
+   */
+  void destroy(T* p_object)
+  {
+    std::destroy_at(p_object);
+    // The object is the only member of its slot, so the two share an address
+    const auto* slot = reinterpret_cast<const slot_t*>(p_object);
+    m_free.put(static_cast<size_t>(slot - m_slots.data()));
+  }
+
+private:
+  union slot_t
+  {
+    slot_t()
+    {
+    }
+    ~slot_t()
+    {
+    }
+    T object;
+  };
+
+  std::array<slot_t, Capacity> m_slots;
+  Bitmap m_free;
+};
+
+/**
+ * @ingroup ObjectPool
+ * @brief Object pool for use from a single context
+ *
+ * @tparam T - type of the objects
+ * @tparam Capacity - maximum number of live objects
+ */
+template<typename T, size_t Capacity>
+using object_pool = basic_object_pool<T, Capacity, slot_bitmap<Capacity>>;
+
+/**
+ * @ingroup ObjectPool
+ * @brief Object pool shared between interrupts and threads
+ *
+ * Objects may be created in one context and destroyed in another, such as a
+ * CAN frame filled in by a receive interrupt and released by the main loop.
+ *
+ * @tparam T - type of the objects
+ * @tparam Capacity - maximum number of live objects
+ */
+template<typename T, size_t Capacity>
+using atomic_object_pool =
+  basic_object_pool<T, Capacity, atomic_slot_bitmap<Capacity>>;
+}  // namespace hal
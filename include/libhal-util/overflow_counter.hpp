@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
 #include "bit_limits.hpp"
@@ -95,4 +96,156 @@ private:
   uint32_t m_previous_count = 0;
   uint32_t m_overflow_count = 0;
 };
+
+/**
+ * @ingroup OverflowCounter
+ * @brief overflow_counter that may be updated from an interrupt and the main
+ * loop, or from several threads, at the same time
+ *
+ * overflow_counter keeps its state in two plain members. If an interrupt
+ * calls update() while the main loop is in the middle of update(), one of the
+ * overflows can be lost or counted twice. Even with the members protected, a
+ * context that read the hardware counter just before being interrupted passes
+ * in a count that is older than the one the interrupt already recorded, which
+ * looks like an overflow and makes the 64-bit count jump forward.
+ *
+ * This variant keeps its state in two 32-bit atomics, so it is lock-free on
+ * any core with 32-bit compare-exchange, such as Cortex-M3 and up, and
+ * interrupts never need to be disabled. The lower 32 bits of the extended
+ * count are updated with compare-exchange: each new count advances them by its
+ * distance from the previous count, modulo the counter width. A count less
+ * than half the counter range behind the previous one is treated as a stale
+ * reading: the extended count is left as is and returned, so values returned
+ * to any context never go backwards.
+ *
+ * The upper bits are kept as the number of half periods of the lower 32 bits
+ * and published after the lower bits cross into a new half period. A context
+ * interrupted between the two leaves them one half period behind, which the
+ * top bit of the lower 32 bits reveals, so readers correct for it rather than
+ * retry.
+ *
+ * In return, update() must be called at least once every half period of the
+ * counter, rather than once per period, and a stale reading must not be more
+ * than half a period old. The extended count wraps after 2^63 ticks.
+ *
+ * Cortex-M0 and M0+ have no compare-exchange instruction at all, so there the
+ * compiler calls the `__atomic_compare_exchange_4` library function, which the
+ * platform must provide by briefly masking interrupts.
+ *
+ * @tparam CountBitWidth - the bit width of the counter before the count value
+ * overflows.
+ */
+template<size_t CountBitWidth = 32>
+class concurrent_overflow_counter
+{
+public:
+  static_assert(CountBitWidth <= 32, "Bit width cannot exceed 32-bits");
+  static_assert(CountBitWidth > 1, "Bit width must be greater than 1");
+
+  /**
+   * @ingroup OverflowCounter
+   * @brief Construct a new concurrent overflow counter
+   *
+   * @param p_initial_count - current value of the counter. The first update()
+   * is subject to the half period limit like every other, so pass the count
+   * when the counter is already running.
+   */
+  explicit concurrent_overflow_counter(uint32_t p_initial_count = 0)
+    : m_lower(p_initial_count & mask)
+    , m_half_periods((p_initial_count & mask) >> 31)
+  {
+  }
+
+  /**
+   * @ingroup OverflowCounter
+   * @brief update the extended count with a new reading of the counter
+   *
+   * Safe to call from any number of contexts at once.
+   *
+   * @param p_new_count - current value of the counter
+   * @return uint64_t - 64-bit count, never less than a value previously
+   * returned by update() or value()
+   */
+  uint64_t update(uint32_t p_new_count)
+  {
+    constexpr uint32_t half_range = (mask >> 1) + 1;
+    p_new_count = p_new_count & mask;
+
+    // Read the half periods first so they can only lag behind the lower bits
+    const auto half_periods = m_half_periods.load(std::memory_order_acquire);
+    auto lower = m_lower.load(std::memory_order_relaxed);
+    while (true) {
+      const uint32_t distance = (p_new_count - (lower & mask)) & mask;
+      if (distance == 0 || distance >= half_range) {
+        // Unchanged, or a stale reading from a context that was interrupted
+        // after reading the counter
+        return combine(half_periods, lower);
+      }
+      if (m_lower.compare_exchange_weak(
+            lower, lower + distance, std::memory_order_relaxed)) {
+        lower += distance;
+        break;
+      }
+    }
+
+    const auto extended = combine(half_periods, lower);
+    publish(static_cast<uint32_t>(extended >> 31));
+    return extended;
+  }
+
+  /**
+   * @ingroup OverflowCounter
+   * @brief Get the extended count recorded by the latest update()
+   *
+   * @return uint64_t - 64-bit count
+   */
+  [[nodiscard]] uint64_t value() const
+  {
+    const auto half_periods = m_half_periods.load(std::memory_order_acquire);
+    return combine(half_periods, m_lower.load(std::memory_order_relaxed));
+  }
+
+  /**
+   * @ingroup OverflowCounter
+   * @brief Reset the overflow count back to zero.
+   *
+   * Must not be called while another context may be calling update().
+   *
+   * @param p_count - current value of the counter
+   */
+  void reset(uint32_t p_count = 0)
+  {
+    m_lower.store(p_count & mask, std::memory_order_relaxed);
+    m_half_periods.store((p_count & mask) >> 31, std::memory_order_release);
+  }
+
+private:
+  static constexpr auto mask =
+    generate_field_of_ones<CountBitWidth, uint32_t>();
+
+  /// Join the half period count with the lower 32 bits, correcting for a
+  /// half period that has been crossed but not yet published
+  static constexpr uint64_t combine(uint32_t p_half_periods, uint32_t p_lower)
+  {
+    constexpr uint32_t lower_half_mask = 0x7FFF'FFFF;
+    const uint32_t lag = (p_half_periods ^ (p_lower >> 31)) & 1;
+    const uint64_t half_periods = p_half_periods + lag;
+    return (half_periods << 31) | (p_lower & lower_half_mask);
+  }
+
+  /// Advance the published half periods, unless another context has already
+  /// published the same or a later one
+  void publish(uint32_t p_half_periods)
+  {
+    auto current = m_half_periods.load(std::memory_order_relaxed);
+    while (static_cast<int32_t>(p_half_periods - current) > 0 &&
+           !m_half_periods.compare_exchange_weak(
+             current, p_half_periods, std::memory_order_release)) {
+      continue;
+    }
+  }
+
+  std::atomic<uint32_t> m_lower = 0;
+  std::atomic<uint32_t> m_half_periods = 0;
+};
 }  // namespace hal
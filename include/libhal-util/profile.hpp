@@ -0,0 +1,433 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include <libhal/serial.hpp>
+#include <libhal/steady_clock.hpp>
+
+#include "serial.hpp"
+
+/**
+ * @defgroup Profile Profile
+ * Measure how long operations take in the field.
+ *
+ * A `hal::stopwatch` or `hal::scoped_probe` measures an operation in
+ * steady_clock ticks and records it into a `hal::latency_histogram`, which
+ * uses a fixed amount of memory however many samples are recorded:
+ *
+ *     hal::latency_histogram<> write_latency;
+ *
+ *     hal::status send(hal::serial& p_serial, std::span<const hal::byte> p_out)
+ *     {
+ *       HAL_PROBE(write_latency, clock);
+ *       return hal::write(p_serial, p_out);
+ *     }
+ *
+ *     // later
+ *     hal::dump_histogram(console, "write", write_latency);
+ *
+ * Define `LIBHAL_UTIL_DISABLE_PROBES` to make every `HAL_PROBE` expand to
+ * nothing, without touching the call sites.
+ */
+
+namespace hal {
+/**
+ * @ingroup Profile
+ * @brief Fixed size log-linear histogram of durations in ticks
+ *
+ * Values below 2^SubBucketBits each get their own bucket. Above that, every
+ * power of two range is split into 2^SubBucketBits equal buckets, so a
+ * recorded value is off by less than 1 / 2^SubBucketBits of itself (12.5% with
+ * the default of 3). This is the same scheme HdrHistogram uses, without the
+ * configurable range. Recording is O(1): a count leading zeros, a shift and an
+ * increment.
+ *
+ * @tparam SubBucketBits - log2 of the number of buckets per power of two
+ * @tparam MaxBits - values at or above 2^MaxBits are counted in the last
+ * bucket. The exact max() is still kept.
+ */
+template<size_t SubBucketBits = 3, size_t MaxBits = 32>
+class latency_histogram
+{
+public:
+  static_assert(SubBucketBits >= 1 && SubBucketBits < MaxBits,
+                "SubBucketBits must be between 1 and MaxBits - 1");
+  static_assert(MaxBits <= 64, "MaxBits cannot exceed 64");
+
+  /// Number of buckets per power of two
+  static constexpr size_t sub_buckets = size_t{ 1 } << SubBucketBits;
+  /// Total number of buckets
+  static constexpr size_t bucket_count =
+    (MaxBits - SubBucketBits + 1) * sub_buckets;
+
+  /**
+   * @ingroup Profile
+   * @brief Record a value
+   *
+   * @param p_value - duration in ticks
+   */
+  constexpr void record(std::uint64_t p_value)
+  {
+    m_buckets[bucket_of(p_value)]++;
+    m_count++;
+    m_sum += p_value;
+    m_min = std::min(m_min, p_value);
+    m_max = std::max(m_max, p_value);
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Remove all recorded values
+   *
+   */
+  constexpr void reset()
+  {
+    *this = latency_histogram{};
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the number of recorded values
+   *
+   * @return constexpr std::uint64_t - number of recorded values
+   */
+  [[nodiscard]] constexpr std::uint64_t count() const
+  {
+    return m_count;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the smallest recorded value
+   *
+   * @return constexpr std::uint64_t - exact minimum, or 0 if empty
+   */
+  [[nodiscard]] constexpr std::uint64_t min() const
+  {
+    return m_count == 0 ? 0 : m_min;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the largest recorded value
+   *
+   * @return constexpr std::uint64_t - exact maximum, or 0 if empty
+   */
+  [[nodiscard]] constexpr std::uint64_t max() const
+  {
+    return m_max;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the mean of the recorded values
+   *
+   * @return constexpr std::uint64_t - exact mean rounded down, or 0 if empty
+   */
+  [[nodiscard]] constexpr std::uint64_t mean() const
+  {
+    return m_count == 0 ? 0 : m_sum / m_count;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the value below which a share of the recorded values fall
+   *
+   * @param p_per_mille - share of the values in thousandths: 500 for the
+   * median, 990 for p99 and 999 for p99.9. Values above 1000 are treated as
+   * 1000.
+   * @return constexpr std::uint64_t - highest value of the bucket holding that
+   * rank, limited to max(). 0 if empty.
+   */
+  [[nodiscard]] constexpr std::uint64_t percentile(
+    std::uint32_t p_per_mille) const
+  {
+    if (m_count == 0) {
+      return 0;
+    }
+
+    const auto per_mille = std::min<std::uint64_t>(p_per_mille, 1000);
+    // Rank of the value, counting from 1, rounded up
+    const auto whole = (m_count / 1000) * per_mille;
+    const auto part = ((m_count % 1000) * per_mille + 999) / 1000;
+    const auto rank = std::max<std::uint64_t>(whole + part, 1);
+
+    std::uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < bucket_count; bucket++) {
+      seen += m_buckets[bucket];
+      if (seen >= rank) {
+        return std::min(highest_in(bucket), m_max);
+      }
+    }
+    return m_max;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the number of values recorded in a bucket
+   *
+   * @param p_bucket - bucket index, less than bucket_count
+   * @return constexpr std::uint32_t - number of values in the bucket
+   */
+  [[nodiscard]] constexpr std::uint32_t bucket(size_t p_bucket) const
+  {
+    return m_buckets[p_bucket];
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the index of the bucket a value is counted in
+   *
+   * @param p_value - value in ticks
+   * @return constexpr size_t - bucket index
+   */
+  [[nodiscard]] static constexpr size_t bucket_of(std::uint64_t p_value)
+  {
+    if (p_value < sub_buckets) {
+      return static_cast<size_t>(p_value);
+    }
+
+    const auto magnitude = static_cast<size_t>(std::bit_width(p_value)) - 1;
+    if (magnitude >= MaxBits) {
+      return bucket_count - 1;
+    }
+
+    const auto shift = magnitude - SubBucketBits;
+    const auto sub_bucket = static_cast<size_t>(p_value >> shift) - sub_buckets;
+    return (shift + 1) * sub_buckets + sub_bucket;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the smallest value counted in a bucket
+   *
+   * @param p_bucket - bucket index, less than bucket_count
+   * @return constexpr std::uint64_t - lowest value of the bucket
+   */
+  [[nodiscard]] static constexpr std::uint64_t lowest_in(size_t p_bucket)
+  {
+    if (p_bucket < sub_buckets) {
+      return p_bucket;
+    }
+
+    const auto shift = p_bucket / sub_buckets - 1;
+    const auto sub_bucket = p_bucket % sub_buckets;
+    return static_cast<std::uint64_t>(sub_buckets + sub_bucket) << shift;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the largest value counted in a bucket
+   *
+   * @param p_bucket - bucket index, less than bucket_count
+   * @return constexpr std::uint64_t - highest value of the bucket. The last
+   * bucket also counts every value beyond the range of the histogram.
+   */
+  [[nodiscard]] static constexpr std::uint64_t highest_in(size_t p_bucket)
+  {
+    if (p_bucket == bucket_count - 1) {
+      return std::numeric_limits<std::uint64_t>::max();
+    }
+    return lowest_in(p_bucket + 1) - 1;
+  }
+
+private:
+  std::array<std::uint32_t, bucket_count> m_buckets{};
+  std::uint64_t m_count = 0;
+  std::uint64_t m_sum = 0;
+  std::uint64_t m_min = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t m_max = 0;
+};
+
+/**
+ * @ingroup Profile
+ * @brief Measures the ticks of a steady clock that passed since it was started
+ *
+ */
+class stopwatch
+{
+public:
+  /**
+   * @ingroup Profile
+   * @brief Create a stopwatch and start it
+   *
+   * @param p_steady_clock - clock to measure with
+   */
+  explicit stopwatch(hal::steady_clock& p_steady_clock)
+    : m_clock(&p_steady_clock)
+    , m_start(p_steady_clock.uptime().ticks)
+  {
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Start measuring again from now
+   *
+   */
+  void restart()
+  {
+    m_start = m_clock->uptime().ticks;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the ticks since the stopwatch was started
+   *
+   * @return std::uint64_t - elapsed ticks
+   */
+  [[nodiscard]] std::uint64_t elapsed() const
+  {
+    return m_clock->uptime().ticks - m_start;
+  }
+
+  /**
+   * @ingroup Profile
+   * @brief Get the ticks since the stopwatch was started and restart it
+   *
+   * Uses a single clock read, so consecutive laps add up to the total time.
+   *
+   * @return std::uint64_t - elapsed ticks
+   */
+  std::uint64_t lap()
+  {
+    const auto now = m_clock->uptime().ticks;
+    const auto elapsed_ticks = now - m_start;
+    m_start = now;
+    return elapsed_ticks;
+  }
+
+private:
+  hal::steady_clock* m_clock;
+  std::uint64_t m_start;
+};
+
+/**
+ * @ingroup Profile
+ * @brief Records the ticks spent in a scope into a histogram
+ *
+ * Reads the clock when constructed and again when destroyed. Prefer the
+ * `HAL_PROBE` macro, which can be compiled out.
+ *
+ * @tparam Histogram - histogram type with a record(std::uint64_t) member
+ */
+template<typename Histogram>
+class scoped_probe
+{
+public:
+  /**
+   * @ingroup Profile
+   * @brief Start measuring a scope
+   *
+   * @param p_histogram - histogram to record the duration of the scope into.
+   * Must outlive the probe.
+   * @param p_steady_clock - clock to measure with
+   */
+  scoped_probe(Histogram& p_histogram, hal::steady_clock& p_steady_clock)
+    : m_histogram(&p_histogram)
+    , m_stopwatch(p_steady_clock)
+  {
+  }
+
+  scoped_probe(const scoped_probe&) = delete;
+  scoped_probe& operator=(const scoped_probe&) = delete;
+  scoped_probe(scoped_probe&&) = delete;
+  scoped_probe& operator=(scoped_probe&&) = delete;
+
+  ~scoped_probe()
+  {
+    m_histogram->record(m_stopwatch.elapsed());
+  }
+
+private:
+  Histogram* m_histogram;
+  stopwatch m_stopwatch;
+};
+
+/**
+ * @ingroup Profile
+ * @brief Write a summary and the non-empty buckets of a histogram
+ *
+ * Output looks like:
+ *
+ *     write: count=120 min=31 mean=40 p50=39 p90=47 p99=63 max=70 ticks
+ *       [28, 31] 2
+ *       [32, 35] 17
+ *
+ * @param p_serial - serial port to write to
+ * @param p_name - name printed before the summary
+ * @param p_histogram - histogram to dump
+ */
+template<size_t SubBucketBits, size_t MaxBits>
+void dump_histogram(
+  serial& p_serial,
+  std::string_view p_name,
+  const latency_histogram<SubBucketBits, MaxBits>& p_histogram)
+{
+  hal::print(p_serial,
+             "{}: count={} min={} mean={} p50={} p90={} p99={} max={} ticks\n",
+             p_name,
+             p_histogram.count(),
+             p_histogram.min(),
+             p_histogram.mean(),
+             p_histogram.percentile(500),
+             p_histogram.percentile(900),
+             p_histogram.percentile(990),
+             p_histogram.max());
+
+  using histogram = latency_histogram<SubBucketBits, MaxBits>;
+  for (size_t bucket = 0; bucket < histogram::bucket_count; bucket++) {
+    const auto values = p_histogram.bucket(bucket);
+    if (values == 0) {
+      continue;
+    }
+    hal::print(p_serial,
+               "  [{}, {}] {}\n",
+               histogram::lowest_in(bucket),
+               std::min(histogram::highest_in(bucket), p_histogram.max()),
+               values);
+  }
+}
+}  // namespace hal
+
+#define HAL_PROBE_CONCAT_INNER(a, b) a##b
+#define HAL_PROBE_CONCAT(a, b) HAL_PROBE_CONCAT_INNER(a, b)
+
+#if defined(LIBHAL_UTIL_DISABLE_PROBES)
+// sizeof names the arguments without evaluating them, so variables only used
+// by probes do not trip unused warnings.
+#define HAL_PROBE(histogram, steady_clock)                                     \
+  static_cast<void>(sizeof(histogram) + sizeof(steady_clock))
+#else
+/**
+ * @ingroup Profile
+ * @brief Record the time spent from here to the end of the scope
+ *
+ * Expands to nothing when `LIBHAL_UTIL_DISABLE_PROBES` is defined, in which
+ * case the arguments are not evaluated.
+ *
+ * @param histogram - histogram to record into
+ * @param steady_clock - hal::steady_clock to measure with
+ */
+#define HAL_PROBE(histogram, steady_clock)                                     \
+  ::hal::scoped_probe HAL_PROBE_CONCAT(hal_probe_, __LINE__)(histogram,        \
+                                                             steady_clock)
+#endif
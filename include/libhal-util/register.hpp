@@ -0,0 +1,385 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "bit.hpp"
+
+/**
+ * @defgroup Register Register
+ * Typed descriptions of memory mapped registers whose field updates are folded
+ * at compile time into a single read-modify-write.
+ */
+
+namespace hal {
+/**
+ * @ingroup Register
+ * @brief How software may access a register field
+ *
+ */
+enum class field_access : std::uint8_t
+{
+  /// Reads return the field's state, writes have no effect
+  read_only,
+  /// Writes change the field, reads return an undefined value
+  write_only,
+  /// Reads return the last value written or the hardware state
+  read_write,
+  /// Reads return a flag set by hardware. Writing 1 clears it, 0 does nothing.
+  write_one_to_clear,
+};
+
+/**
+ * @ingroup Register
+ * @brief A bit_mask together with its access policy
+ *
+ * Declare fields as constants and use them as template arguments:
+ *
+ *     constexpr hal::field enable{ hal::bit_mask::from<0>() };
+ *     constexpr hal::field divider{ hal::bit_mask::from<4, 7>() };
+ *     constexpr hal::field done{ hal::bit_mask::from<31>(),
+ *                                hal::field_access::write_one_to_clear };
+ */
+struct field
+{
+  /// Bits of the register holding the field
+  bit_mask mask;
+  /// Access policy of the field
+  field_access access = field_access::read_write;
+
+  /**
+   * @ingroup Register
+   * @brief Get the bits of the field within a register
+   *
+   * @tparam T - register type
+   * @return constexpr T - mask with the field's bits set
+   */
+  template<std::unsigned_integral T>
+  [[nodiscard]] constexpr T bits() const
+  {
+    return mask.value<T>();
+  }
+
+  /**
+   * @ingroup Register
+   * @brief Determine if software may write the field
+   *
+   * @return true - the field is not read only
+   */
+  [[nodiscard]] constexpr bool writable() const
+  {
+    return access != field_access::read_only;
+  }
+
+  /**
+   * @ingroup Register
+   * @brief Determine if reading the field returns its state
+   *
+   * @return true - the field is not write only
+   */
+  [[nodiscard]] constexpr bool readable() const
+  {
+    return access != field_access::write_only;
+  }
+
+  constexpr bool operator==(const field& p_other) const
+  {
+    return mask.position == p_other.mask.position &&
+           mask.width == p_other.mask.width && access == p_other.access;
+  }
+};
+
+/**
+ * @ingroup Register
+ * @brief Compile time description of a register and its fields
+ *
+ * The description tells a read-modify-write which bits must not be written
+ * back as they were read: write-one-to-clear flags, which would be cleared by
+ * accident, and write-only fields, whose read value is undefined. Those bits
+ * are written as 0 unless explicitly changed.
+ *
+ * When the description lists fields, hal::modify() only accepts those fields.
+ * A description without fields accepts any field.
+ *
+ * @tparam T - unsigned integral type of the register
+ * @tparam Fields - fields of the register
+ */
+template<std::unsigned_integral T, field... Fields>
+struct register_layout
+{
+  /// Integral type of the register
+  using type = T;
+
+  /// Bits whose read value may be written back unchanged
+  static constexpr T preserved_bits = static_cast<T>(
+    ~(static_cast<T>(0) |
+      ... |
+      (Fields.readable() && Fields.access != field_access::write_one_to_clear
+         ? static_cast<T>(0)
+         : Fields.template bits<T>())));
+
+  /**
+   * @ingroup Register
+   * @brief Determine if a field may be used with this register
+   *
+   * @tparam Field - field to check
+   * @return true - the field is one of Fields or no fields were listed
+   */
+  template<field Field>
+  static constexpr bool contains()
+  {
+    return sizeof...(Fields) == 0 || ((Field == Fields) || ...);
+  }
+};
+
+/**
+ * @ingroup Register
+ * @brief Pending update of a register built up from chained field operations
+ *
+ * Created by hal::modify(). Each operation returns a new object whose template
+ * arguments carry the bits to clear and the constant bits to set, so a chain
+ * of any length folds into one AND mask and one OR value at compile time. The
+ * values passed to insert() are the only part computed at runtime. The
+ * register is updated when the last object of the chain is destroyed, at the
+ * end of the full expression, with one volatile read and one volatile write.
+ * When the chain writes every preserved bit, the read is skipped.
+ *
+ * Every operation checks, at compile time, that the field belongs to the
+ * layout and that its access policy allows the operation.
+ *
+ * @tparam Layout - register_layout of the register
+ * @tparam Register - type of the register object, normally Layout::type
+ * @tparam ClearBits - bits replaced by this update
+ * @tparam SetBits - constant bits written as 1
+ */
+template<typename Layout,
+         typename Register,
+         typename Layout::type ClearBits = 0,
+         typename Layout::type SetBits = 0>
+class register_modify
+{
+public:
+  using type = typename Layout::type;
+
+  /**
+   * @ingroup Register
+   * @brief Start an update of a register
+   *
+   * @param p_register - register to update
+   * @param p_inserted - bits inserted at runtime so far
+   */
+  constexpr explicit register_modify(volatile Register* p_register,
+                                     type p_inserted = 0)
+    : m_register(p_register)
+    , m_inserted(p_inserted)
+  {
+  }
+
+  register_modify(const register_modify&) = delete;
+  register_modify& operator=(const register_modify&) = delete;
+  register_modify(register_modify&&) = delete;
+  register_modify& operator=(register_modify&&) = delete;
+
+  /**
+   * @ingroup Register
+   * @brief Set every bit of a field to 1
+   *
+   * @tparam Field - read-write or write-only field
+   * @return register_modify - the update including this operation
+   */
+  template<field Field>
+  constexpr auto set() &&
+  {
+    check<Field>();
+    static_assert(Field.access != field_access::write_one_to_clear,
+                  "Use clear<>() to clear a write-one-to-clear field");
+    constexpr auto bits = Field.template bits<type>();
+    return register_modify<Layout, Register, ClearBits | bits, SetBits | bits>(
+      release(), m_inserted & ~bits);
+  }
+
+  /**
+   * @ingroup Register
+   * @brief Clear every bit of a field
+   *
+   * For a write-one-to-clear field this writes 1s to the field, which clears
+   * the flags it holds.
+   *
+   * @tparam Field - writable field
+   * @return register_modify - the update including this operation
+   */
+  template<field Field>
+  constexpr auto clear() &&
+  {
+    check<Field>();
+    constexpr auto bits = Field.template bits<type>();
+    if constexpr (Field.access == field_access::write_one_to_clear) {
+      return register_modify<Layout,
+                             Register,
+                             ClearBits | bits,
+                             SetBits | bits>(release(), m_inserted & ~bits);
+    } else {
+      return register_modify<Layout,
+                             Register,
+                             ClearBits | bits,
+                             SetBits & static_cast<type>(~bits)>(
+        release(), m_inserted & ~bits);
+    }
+  }
+
+  /**
+   * @ingroup Register
+   * @brief Replace the contents of a field
+   *
+   * @tparam Field - read-write or write-only field
+   * @param p_value - value to insert. Bits beyond the field width are dropped.
+   * @return register_modify - the update including this operation
+   */
+  template<field Field>
+  constexpr auto insert(std::unsigned_integral auto p_value) &&
+  {
+    check<Field>();
+    static_assert(Field.access != field_access::write_one_to_clear,
+                  "Use clear<>() to clear a write-one-to-clear field");
+    constexpr auto bits = Field.template bits<type>();
+    const auto shifted = static_cast<type>(static_cast<type>(p_value)
+                                           << Field.mask.position);
+    return register_modify<Layout,
+                           Register,
+                           ClearBits | bits,
+                           SetBits & static_cast<type>(~bits)>(
+      release(), (m_inserted & ~bits) | (shifted & bits));
+  }
+
+  /**
+   * @ingroup Register
+   * @brief Write the update to the register
+   *
+   */
+  ~register_modify()
+  {
+    if (m_register == nullptr) {
+      return;
+    }
+
+    constexpr auto kept_bits =
+      static_cast<type>(Layout::preserved_bits & ~ClearBits);
+    auto value = static_cast<type>(SetBits | m_inserted);
+    if constexpr (kept_bits != 0) {
+      const type current = *m_register;
+      value = static_cast<type>(value | (current & kept_bits));
+    }
+    *m_register = value;
+  }
+
+private:
+  template<field Field>
+  static constexpr void check()
+  {
+    static_assert(Layout::template contains<Field>(),
+                  "Field is not part of this register's layout");
+    static_assert(Field.writable(), "Field is read only");
+    static_assert(Field.mask.position + Field.mask.width <= sizeof(type) * 8,
+                  "Field exceeds register width");
+  }
+
+  constexpr volatile Register* release()
+  {
+    return std::exchange(m_register, nullptr);
+  }
+
+  volatile Register* m_register;
+  type m_inserted;
+};
+
+/**
+ * @ingroup Register
+ * @brief Update fields of a register with one read-modify-write
+ *
+ *     using control = hal::register_layout<std::uint32_t, enable, divider,
+ *                                          done>;
+ *     hal::modify<control>(peripheral->control)
+ *       .set<enable>()
+ *       .insert<divider>(4U)
+ *       .clear<done>();
+ *
+ * compiles to the equivalent of:
+ *
+ *     peripheral->control = (peripheral->control & 0x7FFF'FF0E) | 0x8000'0041;
+ *
+ * @tparam Layout - register_layout describing the register
+ * @param p_register - register to update
+ * @return register_modify - pending update to chain field operations onto
+ */
+template<typename Layout, typename Register>
+[[nodiscard]] constexpr auto modify(volatile Register& p_register)
+{
+  return register_modify<Layout, Register>(&p_register);
+}
+
+/**
+ * @ingroup Register
+ * @brief Update fields of a register without a layout
+ *
+ * Any field is accepted, and no bits are treated as write-one-to-clear or
+ * write-only except those of the fields used.
+ *
+ * @param p_register - register to update
+ * @return register_modify - pending update to chain field operations onto
+ */
+template<std::unsigned_integral T>
+[[nodiscard]] constexpr auto modify(volatile T& p_register)
+{
+  return register_modify<register_layout<T>, T>(&p_register);
+}
+
+/**
+ * @ingroup Register
+ * @brief Read a field of a register
+ *
+ * @tparam Field - readable field
+ * @tparam Layout - register_layout describing the register
+ * @param p_register - register to read, once
+ * @return auto - value of the field shifted down to bit 0
+ */
+template<field Field, typename Layout, typename Register>
+[[nodiscard]] constexpr auto extract(const volatile Register& p_register)
+{
+  using type = typename Layout::type;
+  static_assert(Layout::template contains<Field>(),
+                "Field is not part of this register's layout");
+  static_assert(Field.readable(), "Field is write only");
+  const type current = p_register;
+  return bit_extract<Field.mask>(current);
+}
+
+/**
+ * @ingroup Register
+ * @brief Read a field of a register without a layout
+ *
+ * @tparam Field - readable field
+ * @param p_register - register to read, once
+ * @return T - value of the field shifted down to bit 0
+ */
+template<field Field, std::unsigned_integral T>
+[[nodiscard]] constexpr T extract(const volatile T& p_register)
+{
+  return extract<Field, register_layout<T>, T>(p_register);
+}
+}  // namespace hal
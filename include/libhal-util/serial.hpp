@@ -14,6 +14,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <concepts>
 #include <cstdio>
 #include <span>
 #include <string_view>
@@ -25,6 +28,7 @@
 
 #include "as_bytes.hpp"
 #include "comparison.hpp"
+#include "format.hpp"
 #include "math.hpp"
 
 /**
@@ -47,6 +51,22 @@ namespace hal {
   return equals(p_lhs.baud_rate, p_rhs.baud_rate) &&
          p_lhs.parity == p_rhs.parity && p_lhs.stop == p_rhs.stop;
 }
+/**
+ * @ingroup Serial
+ * @brief Segments shorter than this are gathered into a single write by
+ * `hal::write(serial&, std::span<const std::span<const hal::byte>>)`
+ *
+ */
+inline constexpr size_t write_gather_size = 32;
+
+/**
+ * @ingroup Serial
+ * @brief Size of the stack buffer `hal::print(serial&, format_string, ...)`
+ * collects formatted text in before writing it to the port
+ *
+ */
+inline constexpr size_t print_chunk_size = 64;
+
 /**
  * @ingroup Serial
  * @brief Write bytes to a serial port
@@ -97,6 +117,70 @@ namespace hal {
   return write(p_serial, as_bytes(p_data_out));
 }
 
+/**
+ * @ingroup Serial
+ * @brief Write multiple segments of bytes to a serial port in order
+ *
+ * Runs of segments smaller than `write_gather_size` are gathered into a small
+ * stack buffer and written with a single call to serial::write. Larger
+ * segments are written in place without copying. Partial writes are resumed
+ * from the byte where they stopped, including in the middle of a segment.
+ *
+ *     hal::write(serial, header, payload, crc);
+ *
+ * @param p_serial - the serial port that will be written to
+ * @param p_segments - segments to be written out the port, in order
+ * @return status - success or failure
+ */
+[[nodiscard]] inline status write(
+  serial& p_serial,
+  std::span<const std::span<const hal::byte>> p_segments)
+{
+  std::array<hal::byte, write_gather_size> gather;
+  size_t gathered = 0;
+
+  for (const auto& segment : p_segments) {
+    if (gathered + segment.size() > gather.size()) {
+      HAL_CHECK(write(p_serial, std::span(gather.data(), gathered)));
+      gathered = 0;
+    }
+
+    if (segment.size() >= gather.size()) {
+      HAL_CHECK(write(p_serial, segment));
+      continue;
+    }
+
+    std::copy(segment.begin(), segment.end(), gather.begin() + gathered);
+    gathered += segment.size();
+  }
+
+  return write(p_serial, std::span(gather.data(), gathered));
+}
+
+/**
+ * @ingroup Serial
+ * @brief Write multiple segments of bytes to a serial port in order
+ *
+ * Convenience form of `hal::write(serial&, std::span<const std::span<const
+ * hal::byte>>)`.
+ *
+ * @param p_serial - the serial port that will be written to
+ * @param p_segments - two or more segments convertible to std::span<const
+ * hal::byte>
+ * @return status - success or failure
+ */
+template<typename... Segments>
+  requires(sizeof...(Segments) >= 2 &&
+           (std::convertible_to<const Segments&, std::span<const hal::byte>> &&
+            ...))
+[[nodiscard]] status write(serial& p_serial, const Segments&... p_segments)
+{
+  const std::array<std::span<const hal::byte>, sizeof...(Segments)> segments{
+    std::span<const hal::byte>(p_segments)...
+  };
+  return write(p_serial, std::span<const std::span<const hal::byte>>(segments));
+}
+
 /**
  * @ingroup Serial
  * @brief Read bytes from a serial port
@@ -255,4 +339,63 @@ void print(serial& p_serial, const char* p_format, Parameters... p_parameters)
 
   (void)hal::write(p_serial, std::string_view(buffer.data(), length));
 }
+
+/**
+ * @ingroup Serial
+ * @brief Write formatted string data to serial port and drop return value
+ *
+ * The format string is parsed and checked against the arguments at compile
+ * time, see `hal::format_to` for the format string syntax. Formatted text is
+ * collected in a `print_chunk_size` stack buffer that is written to the port
+ * each time it fills and once at the end, so a short message is a single
+ * serial::write call. No buffer for the whole message is needed and the printf
+ * family of functions is not used. Prefer this over
+ * `hal::print<BufferSize>()`.
+ *
+ *     hal::print(serial, "temperature = {:.2f}C, status = 0x{:02X}\n",
+ *                temperature, status);
+ *
+ * @tparam Parameters - types of the arguments to be formatted
+ * @param p_serial - serial port to write data to
+ * @param p_format - format string
+ * @param p_parameters - arguments to be formatted
+ */
+template<typename... Parameters>
+void print(serial& p_serial,
+           format_string<Parameters...> p_format,
+           const Parameters&... p_parameters)
+{
+  std::array<char, print_chunk_size> chunk;
+  size_t length = 0;
+
+  auto flush = [&p_serial, &chunk, &length]() {
+    if (length != 0) {
+      (void)hal::write(p_serial, std::string_view(chunk.data(), length));
+      length = 0;
+    }
+  };
+
+  format_to(
+    [&p_serial, &chunk, &length, &flush](std::string_view p_text) {
+      // Text that would fill the chunk on its own is written in place
+      if (p_text.size() >= chunk.size()) {
+        flush();
+        (void)hal::write(p_serial, p_text);
+        return;
+      }
+      while (!p_text.empty()) {
+        if (length == chunk.size()) {
+          flush();
+        }
+        const auto count = std::min(p_text.size(), chunk.size() - length);
+        std::copy_n(p_text.begin(), count, chunk.begin() + length);
+        length += count;
+        p_text.remove_prefix(count);
+      }
+    },
+    p_format,
+    p_parameters...);
+
+  flush();
+}
 }  // namespace hal
@@ -14,8 +14,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <optional>
 #include <span>
 
@@ -27,6 +30,7 @@
 #include "as_bytes.hpp"
 #include "comparison.hpp"
 #include "enum.hpp"
+#include "streams.hpp"
 
 /**
  * @defgroup SerialCoroutines Serial Coroutines
@@ -36,6 +40,63 @@
  */
 
 namespace hal {
+/**
+ * @ingroup SerialCoroutines
+ * @brief Fill a prefix (failure) table for a byte sequence
+ *
+ * Each entry `p_table[i]` is set to the length of the longest proper prefix of
+ * `p_sequence[0..i]` that is also a suffix of it. Searchers use this table to
+ * resume a partial match after a mismatch without rereading any bytes and
+ * without missing matches in overlapping sequences such as "aab" within
+ * "aaab".
+ *
+ * @param p_sequence - sequence to build the table for
+ * @param p_table - table to fill. Only the first `p_sequence.size()` entries
+ * are written and p_table must be at least that large.
+ */
+constexpr void compute_prefix_table(std::span<const hal::byte> p_sequence,
+                                    std::span<size_t> p_table)
+{
+  if (p_sequence.empty()) {
+    return;
+  }
+
+  p_table[0] = 0;
+  size_t length = 0;
+
+  for (size_t index = 1; index < p_sequence.size(); index++) {
+    while (length > 0 && p_sequence[index] != p_sequence[length]) {
+      length = p_table[length - 1];
+    }
+    if (p_sequence[index] == p_sequence[length]) {
+      length++;
+    }
+    p_table[index] = length;
+  }
+}
+
+/**
+ * @ingroup SerialCoroutines
+ * @brief Generate, at compile time, the prefix table for a byte sequence
+ *
+ * Usage:
+ *
+ *     static constexpr std::array<hal::byte, 4> sync{ 'S', 'Y', 'N', 'C' };
+ *     static constexpr auto sync_table = hal::make_prefix_table(sync);
+ *
+ * @tparam N - length of the sequence
+ * @param p_sequence - sequence to build the table for
+ * @return constexpr std::array<size_t, N> - prefix table for the sequence
+ */
+template<size_t N>
+[[nodiscard]] constexpr std::array<size_t, N> make_prefix_table(
+  const std::array<hal::byte, N>& p_sequence)
+{
+  std::array<size_t, N> table{};
+  compute_prefix_table(p_sequence, table);
+  return table;
+}
+
 /**
  * @ingroup SerialCoroutines
  * @brief Discard received bytes until the sequence is found
@@ -64,6 +125,41 @@ public:
   {
   }
 
+  /**
+   * @ingroup SerialCoroutines
+   * @brief Construct a new skip beyond object that reads in bulk
+   *
+   * Rather than reading the serial port one byte at a time, each read attempt
+   * fills as much of p_scratch as the port has available and the received
+   * chunk is scanned using the sequence's prefix table. Bytes received after
+   * the end of the sequence are not discarded and can be retrieved via
+   * `remaining()`.
+   *
+   * @param p_serial - serial port to skip through
+   * @param p_sequence - sequence to search for. The lifetime of this data
+   * pointed to by this span must outlive this object, or not be used when the
+   * lifetime of that data is no longer available.
+   * @param p_prefix_table - prefix table for p_sequence generated by
+   * `hal::make_prefix_table()` or `hal::compute_prefix_table()`. Must be the
+   * same length as p_sequence and must outlive this object.
+   * @param p_scratch - buffer to read serial data into. Must outlive this
+   * object. If this is empty, then bytes will be read one at a time.
+   * @param p_read_limit - the maximum number read attempts from the port before
+   * returning. A value 0 will result in no reads from the serial port.
+   */
+  skip_past(serial& p_serial,
+            std::span<const hal::byte> p_sequence,
+            std::span<const size_t> p_prefix_table,
+            std::span<hal::byte> p_scratch,
+            size_t p_read_limit = 32)
+    : m_serial(&p_serial)
+    , m_sequence(p_sequence)
+    , m_prefix_table(p_prefix_table)
+    , m_scratch(p_scratch)
+    , m_read_limit(p_read_limit)
+  {
+  }
+
   /**
    * @ingroup SerialCoroutines
    * @brief skip data from the serial port until the sequence is reached.
@@ -84,6 +180,10 @@ public:
       return work_state::finished;
     }
 
+    if (!m_scratch.empty()) {
+      return skip_chunks();
+    }
+
     for (size_t read_limit = 0; read_limit < m_read_limit; read_limit++) {
       std::array<hal::byte, 1> buffer;
       auto read_result = HAL_CHECK(m_serial->read(buffer));
@@ -92,12 +192,7 @@ public:
         return work_state::in_progress;
       }
 
-      // Check if the next byte received matches the sequence
-      if (m_sequence[m_search_index] == read_result.data[0]) {
-        m_search_index++;
-      } else {  // Otherwise set the search index back to the start.
-        m_search_index = 0;
-      }
+      advance(read_result.data[0]);
 
       // Check if the search index is equal to the size of the sequence size
       if (m_search_index == m_sequence.size()) {
@@ -108,9 +203,77 @@ public:
     return work_state::in_progress;
   }
 
+  /**
+   * @ingroup SerialCoroutines
+   * @brief Get the bytes that were read after the end of the sequence
+   *
+   * Only bulk reads (constructed with a scratch buffer) can read past the end
+   * of the sequence. The returned span points into the scratch buffer and is
+   * only valid until the scratch buffer is reused.
+   *
+   * @return std::span<hal::byte> - bytes received after the sequence. Empty if
+   * the sequence has not been found or nothing followed it.
+   */
+  std::span<hal::byte> remaining()
+  {
+    return m_remaining;
+  }
+
 private:
+  result<work_state> skip_chunks()
+  {
+    for (size_t read_limit = 0; read_limit < m_read_limit; read_limit++) {
+      auto read_result = HAL_CHECK(m_serial->read(m_scratch));
+      auto received = read_result.data;
+
+      for (size_t index = 0; index < received.size(); index++) {
+        advance(received[index]);
+
+        if (m_search_index == m_sequence.size()) {
+          m_remaining = received.subspan(index + 1);
+          return work_state::finished;
+        }
+      }
+
+      // The port had fewer bytes than the scratch buffer could hold, so there
+      // is nothing left to read at the moment.
+      if (received.size() != m_scratch.size()) {
+        return work_state::in_progress;
+      }
+    }
+
+    return work_state::in_progress;
+  }
+
+  void advance(hal::byte p_byte)
+  {
+    // Without a prefix table, a mismatch sets the search index back to the
+    // start.
+    if (m_prefix_table.empty()) {
+      if (m_sequence[m_search_index] == p_byte) {
+        m_search_index++;
+      } else {
+        m_search_index = 0;
+      }
+      return;
+    }
+
+    // Fall back to the longest prefix of the sequence that is still matched
+    // by the bytes received so far.
+    while (m_search_index > 0 && m_sequence[m_search_index] != p_byte) {
+      m_search_index = m_prefix_table[m_search_index - 1];
+    }
+
+    if (m_sequence[m_search_index] == p_byte) {
+      m_search_index++;
+    }
+  }
+
   serial* m_serial;
   std::span<const hal::byte> m_sequence;
+  std::span<const size_t> m_prefix_table{};
+  std::span<hal::byte> m_scratch{};
+  std::span<hal::byte> m_remaining{};
   size_t m_read_limit;
   size_t m_search_index = 0;
 };
@@ -276,6 +439,168 @@ private:
   size_t m_search_index = 0;
 };
 
+/**
+ * @ingroup SerialCoroutines
+ * @brief Read received bytes into a buffer, in chunks, until the sequence is
+ * found
+ *
+ * Unlike `hal::read_upto`, each read attempt requests all of the unfilled
+ * space in the buffer, so a line can be received with a handful of driver
+ * calls rather than one call per byte. The received data is scanned for the
+ * first byte of the sequence using `std::memchr` and the full sequence is only
+ * compared at those candidate positions. Sequences that straddle two reads are
+ * still found.
+ *
+ * Because reads are not limited to a single byte, bytes received after the
+ * sequence may also be read from the port. Those bytes are kept in the buffer
+ * and are available via `remaining()`.
+ */
+class read_upto_chunked
+{
+public:
+  /**
+   * @ingroup SerialCoroutines
+   * @brief Construct a new read upto chunked object
+   *
+   * @param p_serial - serial port to read from
+   * @param p_sequence - sequence to search for. The lifetime of this data
+   * pointed to by this span must outlive this object, or not be used when the
+   * lifetime of that data is no longer available.
+   * @param p_buffer - buffer to fill data into
+   * @param p_read_limit - the maximum number read attempts from the port before
+   * returning. A value 0 will result in no reads from the serial port.
+   */
+  read_upto_chunked(serial& p_serial,
+                    std::span<const hal::byte> p_sequence,
+                    std::span<hal::byte> p_buffer,
+                    size_t p_read_limit = 32)
+    : m_serial(&p_serial)
+    , m_sequence(p_sequence)
+    , m_buffer(p_buffer)
+    , m_read_limit(p_read_limit)
+    , m_found(p_sequence.empty())
+  {
+  }
+
+  /**
+   * @ingroup SerialCoroutines
+   * @brief read data into the buffer.
+   *
+   * This function will return if the read limit is reached or if there are no
+   * more bytes in the serial port.
+   *
+   * Call this function again to resume reading from the port.
+   *
+   * @return result<work_state> - work_state::in_progress if the sequence hasn't
+   * been met and the buffer still has space.
+   * @return result<work_state> - work_state::failed if the sequence wasn't
+   * found before the buffer was filled completely.
+   * @return result<work_state> - work_state::finished if the sequence was
+   * found before the buffer was filled completely.
+   */
+  result<work_state> operator()()
+  {
+    if (m_found) {
+      return work_state::finished;
+    }
+    if (m_filled == m_buffer.size()) {
+      return work_state::failed;
+    }
+
+    for (size_t read_limit = 0; read_limit < m_read_limit; read_limit++) {
+      auto read_result = HAL_CHECK(m_serial->read(m_buffer.subspan(m_filled)));
+      m_filled += read_result.data.size();
+
+      if (search()) {
+        return work_state::finished;
+      }
+
+      if (m_filled == m_buffer.size()) {
+        return work_state::failed;
+      }
+
+      if (read_result.data.empty() || read_result.available == 0) {
+        return work_state::in_progress;
+      }
+    }
+
+    return work_state::in_progress;
+  }
+
+  /**
+   * @ingroup SerialCoroutines
+   * @brief Get the data read up to and including the sequence
+   *
+   * @return std::span<hal::byte> - the filled portion of the buffer. If the
+   * sequence has not been found, this contains every byte read so far.
+   */
+  std::span<hal::byte> span()
+  {
+    return m_buffer.first(m_found ? m_match_end : m_filled);
+  }
+
+  /**
+   * @ingroup SerialCoroutines
+   * @brief Get the bytes that were read after the end of the sequence
+   *
+   * @return std::span<hal::byte> - bytes received after the sequence. Empty if
+   * the sequence has not been found or nothing followed it.
+   */
+  std::span<hal::byte> remaining()
+  {
+    if (!m_found) {
+      return m_buffer.subspan(m_filled, 0);
+    }
+    return m_buffer.subspan(m_match_end, m_filled - m_match_end);
+  }
+
+private:
+  bool search()
+  {
+    const auto first_byte = m_sequence[0];
+
+    while (m_search_from < m_filled) {
+      const auto* start = m_buffer.data() + m_search_from;
+      const auto* candidate = static_cast<const hal::byte*>(
+        std::memchr(start, first_byte, m_filled - m_search_from));
+
+      if (candidate == nullptr) {
+        m_search_from = m_filled;
+        return false;
+      }
+
+      const auto candidate_index =
+        static_cast<size_t>(candidate - m_buffer.data());
+
+      // Not enough bytes have been received to verify the full sequence at
+      // this candidate. Resume the search from here after the next read.
+      if (candidate_index + m_sequence.size() > m_filled) {
+        m_search_from = candidate_index;
+        return false;
+      }
+
+      if (std::equal(m_sequence.begin(), m_sequence.end(), candidate)) {
+        m_match_end = candidate_index + m_sequence.size();
+        m_found = true;
+        return true;
+      }
+
+      m_search_from = candidate_index + 1;
+    }
+
+    return false;
+  }
+
+  serial* m_serial;
+  std::span<const hal::byte> m_sequence;
+  std::span<hal::byte> m_buffer;
+  size_t m_read_limit;
+  size_t m_filled = 0;
+  size_t m_search_from = 0;
+  size_t m_match_end = 0;
+  bool m_found;
+};
+
 /**
  * @ingroup SerialCoroutines
  * @brief Read bytes from serial port and convert to integer
@@ -358,4 +683,143 @@ private:
   bool m_found_digit = false;
   bool m_finished = false;
 };
+
+/**
+ * @ingroup SerialCoroutines
+ * @brief Read bytes from serial port and convert to a signed, unsigned, or
+ * floating point number
+ *
+ * See `hal::stream_parse_number` for the accepted formats.
+ *
+ * @tparam T - type of the number to parse
+ * @tparam Base - base of the number, 10 or 16.
+ */
+template<typename T, unsigned Base = 10>
+class read_number
+{
+public:
+  /**
+   * @ingroup SerialCoroutines
+   * @brief Construct a new read_number object
+   *
+   * Bytes are read from the serial port one at a time so that no bytes beyond
+   * the end of the number are taken from the port. The byte that terminates
+   * the number is consumed.
+   *
+   * @param p_serial - serial port to read from
+   * @param p_read_limit - the maximum number read attempts from the port before
+   * returning. A value 0 will result in no reads from the serial port.
+   */
+  read_number(serial& p_serial, size_t p_read_limit = 32)
+    : m_serial(&p_serial)
+    , m_read_limit(p_read_limit)
+  {
+  }
+
+  /**
+   * @ingroup SerialCoroutines
+   * @brief Construct a new read_number object that reads in bulk
+   *
+   * Each read attempt fills as much of p_scratch as the port has available,
+   * allowing long numbers to be parsed several digits at a time. Bytes
+   * received after the number, starting with the byte that terminated it, can
+   * be retrieved via `remaining()`.
+   *
+   * @param p_serial - serial port to read from
+   * @param p_scratch - buffer to read serial data into. Must outlive this
+   * object.
+   * @param p_read_limit - the maximum number read attempts from the port before
+   * returning. A value 0 will result in no reads from the serial port.
+   */
+  read_number(serial& p_serial,
+              std::span<hal::byte> p_scratch,
+              size_t p_read_limit = 32)
+    : m_serial(&p_serial)
+    , m_scratch(p_scratch)
+    , m_read_limit(p_read_limit)
+  {
+  }
+
+  /**
+   * @ingroup SerialCoroutines
+   * @brief parse serial data and convert to a number
+   *
+   * This function will return if a number was found, the number overflowed T,
+   * or no more bytes in the serial port.
+   *
+   * Call this function again to resume reading from the port.
+   *
+   * @return result<work_state> - work_state::in_progress - if a number hasn't
+   * been found
+   * @return result<work_state> - work_state::finished - number has been found
+   * and a non-number byte has also been found.
+   * @return result<work_state> - work_state::failed - the number does not fit
+   * within T.
+   */
+  result<work_state> operator()()
+  {
+    if (m_parser.state() != work_state::in_progress) {
+      return m_parser.state();
+    }
+
+    std::array<hal::byte, 1> single_byte;
+    auto buffer = m_scratch.empty() ? std::span<hal::byte>(single_byte)
+                                    : m_scratch;
+
+    for (size_t read_limit = 0; read_limit < m_read_limit; read_limit++) {
+      auto read_result = HAL_CHECK(m_serial->read(buffer));
+      std::span<const hal::byte> received = read_result.data;
+      auto leftover = received | m_parser;
+
+      if (m_parser.state() != work_state::in_progress) {
+        if (!m_scratch.empty()) {
+          m_remaining = m_scratch.subspan(
+            static_cast<size_t>(leftover.data() - m_scratch.data()),
+            leftover.size());
+        }
+        return m_parser.state();
+      }
+
+      if (read_result.data.size() != buffer.size()) {
+        return work_state::in_progress;
+      }
+    }
+
+    return work_state::in_progress;
+  }
+
+  /**
+   * @return std::optional<T> - number if the parsing is finished or
+   * std::nullopt
+   */
+  std::optional<T> get()
+  {
+    if (m_parser.state() != work_state::finished) {
+      return std::nullopt;
+    }
+    return m_parser.value();
+  }
+
+  /**
+   * @ingroup SerialCoroutines
+   * @brief Get the bytes that were read after the end of the number
+   *
+   * Only bulk reads (constructed with a scratch buffer) can read past the end
+   * of the number. The returned span points into the scratch buffer and is only
+   * valid until the scratch buffer is reused.
+   *
+   * @return std::span<hal::byte> - bytes received after the number
+   */
+  std::span<hal::byte> remaining()
+  {
+    return m_remaining;
+  }
+
+private:
+  serial* m_serial;
+  std::span<hal::byte> m_scratch{};
+  std::span<hal::byte> m_remaining{};
+  size_t m_read_limit;
+  stream_parse_number<T, Base> m_parser{};
+};
 }  // namespace hal
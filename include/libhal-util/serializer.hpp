@@ -0,0 +1,391 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include <libhal/units.hpp>
+
+#include "bit.hpp"
+#include "endian.hpp"
+
+/**
+ * @defgroup Serializer Serializer
+ * Conversion between structs and their wire format, described field by field
+ * at compile time.
+ *
+ * `hal::as_bytes` reinterprets memory, so the struct's padding and the host's
+ * byte order end up on the wire. A serializer instead lists where each member
+ * goes in the buffer and in which byte order:
+ *
+ *     struct reading
+ *     {
+ *       std::int16_t temperature;
+ *       std::uint32_t pressure;
+ *       std::uint8_t mode;
+ *       bool ready;
+ *     };
+ *
+ *     using reading_format = hal::serializer<
+ *       reading,
+ *       hal::field_at<&reading::temperature, 0>,
+ *       hal::field_at<&reading::pressure, 2, std::endian::little>,
+ *       hal::bits_at<&reading::mode, 6, hal::bit_mask::from<0, 2>()>,
+ *       hal::bits_at<&reading::ready, 6, hal::bit_mask::from<7>()>>;
+ *
+ *     std::array<hal::byte, reading_format::size> buffer =
+ *       reading_format::pack(value);
+ *     reading decoded = reading_format::unpack(buffer);
+ *
+ * pack() and unpack() are constexpr and contain no branches: each field is a
+ * fixed sequence of shifts, masks and byte moves.
+ */
+
+namespace hal {
+/**
+ * @ingroup Serializer
+ * @brief Types of a pointer to data member
+ *
+ * @tparam MemberPointer - pointer to data member type
+ */
+template<typename MemberPointer>
+struct member_pointer_traits;
+
+template<typename Class, typename Member>
+struct member_pointer_traits<Member Class::*>
+{
+  /// Class the member belongs to
+  using class_type = Class;
+  /// Type of the member
+  using member_type = Member;
+};
+
+/**
+ * @ingroup Serializer
+ * @brief Types a serializer can place in a buffer
+ *
+ * Integers, bool, enums and IEEE-754 float and double.
+ */
+template<typename T>
+concept serializable_value =
+  std::integral<T> || std::is_enum_v<T> ||
+  (std::floating_point<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+
+/**
+ * @ingroup Serializer
+ * @brief Unsigned integer holding the bits of a serializable value
+ *
+ * @tparam T - serializable type
+ */
+template<serializable_value T>
+using serialized_bits_t = std::conditional_t<
+  sizeof(T) == 1,
+  std::uint8_t,
+  std::conditional_t<
+    sizeof(T) == 2,
+    std::uint16_t,
+    std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+
+/**
+ * @ingroup Serializer
+ * @brief Get the bits of a serializable value
+ *
+ * @param p_value - value to convert
+ * @return constexpr auto - bits of p_value as an unsigned integer of the same
+ * size
+ */
+template<serializable_value T>
+constexpr serialized_bits_t<T> to_serialized_bits(T p_value)
+{
+  if constexpr (std::floating_point<T>) {
+    return std::bit_cast<serialized_bits_t<T>>(p_value);
+  } else {
+    return static_cast<serialized_bits_t<T>>(p_value);
+  }
+}
+
+/**
+ * @ingroup Serializer
+ * @brief Convert bits back into a serializable value
+ *
+ * @tparam T - serializable type
+ * @param p_bits - bits of the value
+ * @return constexpr T - the value
+ */
+template<serializable_value T>
+constexpr T from_serialized_bits(serialized_bits_t<T> p_bits)
+{
+  if constexpr (std::floating_point<T>) {
+    return std::bit_cast<T>(p_bits);
+  } else if constexpr (std::same_as<T, bool>) {
+    return p_bits != 0;
+  } else {
+    return static_cast<T>(p_bits);
+  }
+}
+
+/**
+ * @ingroup Serializer
+ * @brief Serializer field holding a whole member
+ *
+ * The member occupies sizeof(member) bytes of the buffer starting at Offset.
+ *
+ * @tparam Member - pointer to the data member
+ * @tparam Offset - byte offset of the field in the buffer
+ * @tparam Order - byte order of the field in the buffer
+ */
+template<auto Member, size_t Offset, std::endian Order = std::endian::big>
+struct field_at
+{
+  using class_type =
+    typename member_pointer_traits<decltype(Member)>::class_type;
+  using member_type =
+    typename member_pointer_traits<decltype(Member)>::member_type;
+  static_assert(serializable_value<member_type>,
+                "Member must be an integer, bool, enum, float or double");
+
+  /// Bytes of the buffer used by the field
+  static constexpr size_t end = Offset + sizeof(member_type);
+
+  /**
+   * @ingroup Serializer
+   * @brief Mark the bits of the buffer this field occupies
+   *
+   * @param p_occupied - one mask per byte of the buffer
+   * @return true - the field does not overlap a field marked before it
+   */
+  template<size_t Size>
+  static constexpr bool occupy(std::array<hal::byte, Size>& p_occupied)
+  {
+    bool disjoint = true;
+    for (size_t index = Offset; index < end; index++) {
+      disjoint = disjoint && p_occupied[index] == 0;
+      p_occupied[index] = 0xFF;
+    }
+    return disjoint;
+  }
+
+  /**
+   * @ingroup Serializer
+   * @brief Write the member into the buffer
+   *
+   * @param p_object - object holding the member
+   * @param p_buffer - zero initialized buffer to write into
+   */
+  template<size_t Size>
+  static constexpr void pack(const class_type& p_object,
+                             std::array<hal::byte, Size>& p_buffer)
+  {
+    store_endian<Order>(to_serialized_bits(p_object.*Member),
+                        std::span(p_buffer).subspan(Offset));
+  }
+
+  /**
+   * @ingroup Serializer
+   * @brief Read the member from the buffer
+   *
+   * @param p_buffer - buffer to read from
+   * @param p_object - object to write the member into
+   */
+  template<size_t Size>
+  static constexpr void unpack(const std::array<hal::byte, Size>& p_buffer,
+                               class_type& p_object)
+  {
+    using bits_t = serialized_bits_t<member_type>;
+    p_object.*Member = from_serialized_bits<member_type>(
+      load_endian<Order, bits_t>(std::span(p_buffer).subspan(Offset)));
+  }
+};
+
+/**
+ * @ingroup Serializer
+ * @brief Serializer field holding a member in some bits of an integer
+ *
+ * The buffer holds a Storage sized integer at Offset, in the given byte order,
+ * and the member occupies the bits of that integer selected by Mask. Several
+ * bits_at fields may share the same integer as long as their masks do not
+ * overlap. Signed members are sign extended from the top bit of the mask when
+ * unpacked.
+ *
+ * @tparam Member - pointer to the data member
+ * @tparam Offset - byte offset of the integer in the buffer
+ * @tparam Mask - bits of the integer holding the member
+ * @tparam Storage - unsigned integer type of the integer in the buffer
+ * @tparam Order - byte order of the integer in the buffer
+ */
+template<auto Member,
+         size_t Offset,
+         bit_mask Mask,
+         std::unsigned_integral Storage = std::uint8_t,
+         std::endian Order = std::endian::big>
+struct bits_at
+{
+  using class_type =
+    typename member_pointer_traits<decltype(Member)>::class_type;
+  using member_type =
+    typename member_pointer_traits<decltype(Member)>::member_type;
+  static_assert(std::integral<member_type> || std::is_enum_v<member_type>,
+                "Member must be an integer, bool or enum");
+  static_assert(Mask.position + Mask.width <= sizeof(Storage) * 8,
+                "Mask exceeds the storage integer");
+  static_assert(Mask.width <= sizeof(member_type) * 8,
+                "Mask is wider than the member");
+
+  /// Bytes of the buffer used by the field
+  static constexpr size_t end = Offset + sizeof(Storage);
+
+  /**
+   * @ingroup Serializer
+   * @brief Mark the bits of the buffer this field occupies
+   *
+   * @param p_occupied - one mask per byte of the buffer
+   * @return true - the field does not overlap a field marked before it
+   */
+  template<size_t Size>
+  static constexpr bool occupy(std::array<hal::byte, Size>& p_occupied)
+  {
+    std::array<hal::byte, sizeof(Storage)> mask_bytes{};
+    store_endian<Order>(Mask.value<Storage>(), mask_bytes);
+    bool disjoint = true;
+    for (size_t index = 0; index < mask_bytes.size(); index++) {
+      auto& occupied = p_occupied[Offset + index];
+      disjoint = disjoint && (occupied & mask_bytes[index]) == 0;
+      occupied |= mask_bytes[index];
+    }
+    return disjoint;
+  }
+
+  /**
+   * @ingroup Serializer
+   * @brief Write the member into the buffer
+   *
+   * @param p_object - object holding the member
+   * @param p_buffer - zero initialized buffer to write into
+   */
+  template<size_t Size>
+  static constexpr void pack(const class_type& p_object,
+                             std::array<hal::byte, Size>& p_buffer)
+  {
+    const auto value = static_cast<Storage>(p_object.*Member);
+    const auto bits =
+      static_cast<Storage>((value << Mask.position) & Mask.value<Storage>());
+
+    std::array<hal::byte, sizeof(Storage)> bytes{};
+    store_endian<Order>(bits, bytes);
+    for (size_t index = 0; index < bytes.size(); index++) {
+      p_buffer[Offset + index] |= bytes[index];
+    }
+  }
+
+  /**
+   * @ingroup Serializer
+   * @brief Read the member from the buffer
+   *
+   * @param p_buffer - buffer to read from
+   * @param p_object - object to write the member into
+   */
+  template<size_t Size>
+  static constexpr void unpack(const std::array<hal::byte, Size>& p_buffer,
+                               class_type& p_object)
+  {
+    const auto storage =
+      load_endian<Order, Storage>(std::span(p_buffer).subspan(Offset));
+    const auto value = bit_extract<Mask>(storage);
+
+    if constexpr (std::is_signed_v<member_type>) {
+      // Move the field's top bit to the sign bit, then shift back down
+      // arithmetically to copy it into the upper bits
+      using signed_t = std::make_signed_t<std::common_type_t<member_type, int>>;
+      constexpr auto unused_bits = sizeof(signed_t) * 8 - Mask.width;
+      using unsigned_t = std::make_unsigned_t<signed_t>;
+      const auto shifted = static_cast<signed_t>(
+        static_cast<unsigned_t>(static_cast<unsigned_t>(value) << unused_bits));
+      p_object.*Member = static_cast<member_type>(shifted >> unused_bits);
+    } else if constexpr (std::same_as<member_type, bool>) {
+      p_object.*Member = value != 0;
+    } else {
+      p_object.*Member = static_cast<member_type>(value);
+    }
+  }
+};
+
+/**
+ * @ingroup Serializer
+ * @brief Packs a struct into a fixed size buffer and back
+ *
+ * The buffer size is the end of the last field. Bytes not covered by a field
+ * are packed as zero and ignored when unpacking. Fields are checked at compile
+ * time to belong to T and not to overlap.
+ *
+ * @tparam T - struct to serialize
+ * @tparam Fields - field_at and bits_at descriptions of the members of T
+ */
+template<typename T, typename... Fields>
+class serializer
+{
+public:
+  static_assert((std::same_as<typename Fields::class_type, T> && ...),
+                "Every field must be a member of T");
+
+  /// Size of the serialized buffer in bytes
+  static constexpr size_t size = std::max({ size_t{ 0 }, Fields::end... });
+
+  /// Buffer holding a serialized T
+  using buffer_t = std::array<hal::byte, size>;
+
+  static_assert(
+    []() {
+      [[maybe_unused]] buffer_t occupied{};
+      return (Fields::occupy(occupied) && ...);
+    }(),
+    "Fields overlap");
+
+  /**
+   * @ingroup Serializer
+   * @brief Serialize an object
+   *
+   * @param p_object - object to serialize
+   * @return constexpr buffer_t - the object's wire format
+   */
+  [[nodiscard]] static constexpr buffer_t pack(const T& p_object)
+  {
+    buffer_t buffer{};
+    (Fields::pack(p_object, buffer), ...);
+    return buffer;
+  }
+
+  /**
+   * @ingroup Serializer
+   * @brief Deserialize an object
+   *
+   * @param p_buffer - the object's wire format
+   * @return constexpr T - the object. Members without a field are value
+   * initialized.
+   */
+  [[nodiscard]] static constexpr T unpack(const buffer_t& p_buffer)
+  {
+    T object{};
+    (Fields::unpack(p_buffer, object), ...);
+    return object;
+  }
+};
+}  // namespace hal
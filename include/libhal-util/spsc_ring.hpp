@@ -0,0 +1,238 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+/**
+ * @defgroup SpscRing Single Producer Single Consumer Ring
+ *
+ */
+
+namespace hal {
+/**
+ * @ingroup SpscRing
+ * @brief Lock-free single producer single consumer ring buffer
+ *
+ * Intended for passing data from an interrupt service routine to the main
+ * loop, or between two threads. Exactly one context may call the producer
+ * functions (`push`) and exactly one context may call the consumer functions
+ * (`pop`, `peek` and `consume`). Functions that only observe the ring (`size`,
+ * `empty`, `full`) may be called from either side, but the result may be out
+ * of date by the time it is used.
+ *
+ * Only atomic loads and stores are used, no read-modify-write operations, so
+ * this works on cores without exclusive access instructions such as the
+ * Cortex-M0.
+ *
+ * A byte ring can feed `streams.hpp` stages without copying:
+ *
+ *     auto data = ring.peek();
+ *     auto remaining = data.first | parser;
+ *     ring.consume(data.first.size() - remaining.size());
+ *
+ * @tparam T - type of the elements, must be trivially copyable
+ * @tparam Capacity - maximum number of elements, must be a power of two
+ * @tparam IndexAlignment - alignment of the producer and consumer indices. Set
+ * this to the cache line size on cores with a data cache to keep the two
+ * indices in separate cache lines.
+ */
+template<typename T,
+         size_t Capacity,
+         size_t IndexAlignment = alignof(std::atomic<size_t>)>
+class spsc_ring
+{
+public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "spsc_ring elements must be trivially copyable");
+  static_assert(std::has_single_bit(Capacity),
+                "spsc_ring capacity must be a power of two");
+
+  /// Elements available to the consumer, split at the wrap point
+  struct peek_t
+  {
+    /// Oldest elements in the ring
+    std::span<const T> first;
+    /// Elements following first that wrapped to the start of the buffer
+    std::span<const T> second;
+
+    /**
+     * @return size_t - total number of elements in both spans
+     */
+    [[nodiscard]] constexpr size_t size() const
+    {
+      return first.size() + second.size();
+    }
+  };
+
+  /**
+   * @return constexpr size_t - the maximum number of elements in the ring
+   */
+  [[nodiscard]] static constexpr size_t capacity()
+  {
+    return Capacity;
+  }
+
+  /**
+   * @brief Push a single element (producer only)
+   *
+   * @param p_value - element to push
+   * @return true - the element was pushed
+   * @return false - the ring is full and the element was dropped
+   */
+  bool push(const T& p_value)
+  {
+    return push(std::span<const T>(&p_value, 1)) == 1;
+  }
+
+  /**
+   * @brief Push as many elements as will fit (producer only)
+   *
+   * Elements are published to the consumer together once they have all been
+   * copied.
+   *
+   * @param p_values - elements to push in order
+   * @return size_t - number of elements pushed from the front of p_values
+   */
+  size_t push(std::span<const T> p_values)
+  {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    const auto tail = m_tail.load(std::memory_order_acquire);
+    const auto count = std::min(p_values.size(), Capacity - (head - tail));
+
+    const auto start = head & mask;
+    const auto before_wrap = std::min(count, Capacity - start);
+    std::copy_n(p_values.begin(), before_wrap, m_buffer.begin() + start);
+    std::copy_n(
+      p_values.begin() + before_wrap, count - before_wrap, m_buffer.begin());
+
+    m_head.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @brief Pop a single element (consumer only)
+   *
+   * @return std::optional<T> - the oldest element or std::nullopt if the ring
+   * is empty
+   */
+  std::optional<T> pop()
+  {
+    T value{};
+    if (pop(std::span<T>(&value, 1)) == 0) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  /**
+   * @brief Pop as many elements as are available (consumer only)
+   *
+   * @param p_values - buffer to copy elements into
+   * @return size_t - number of elements copied to the front of p_values
+   */
+  size_t pop(std::span<T> p_values)
+  {
+    const auto data = peek();
+    const auto from_first = std::min(p_values.size(), data.first.size());
+    const auto from_second =
+      std::min(p_values.size() - from_first, data.second.size());
+
+    std::copy_n(data.first.begin(), from_first, p_values.begin());
+    std::copy_n(
+      data.second.begin(), from_second, p_values.begin() + from_first);
+
+    consume(from_first + from_second);
+    return from_first + from_second;
+  }
+
+  /**
+   * @brief View the available elements without copying (consumer only)
+   *
+   * The elements remain valid until they are released with `consume()`.
+   *
+   * @return peek_t - available elements, split at the wrap point
+   */
+  [[nodiscard]] peek_t peek() const
+  {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    const auto head = m_head.load(std::memory_order_acquire);
+    const auto count = head - tail;
+
+    const auto start = tail & mask;
+    const auto before_wrap = std::min(count, Capacity - start);
+
+    return peek_t{
+      .first = std::span<const T>(m_buffer.data() + start, before_wrap),
+      .second = std::span<const T>(m_buffer.data(), count - before_wrap),
+    };
+  }
+
+  /**
+   * @brief Release elements returned by `peek()` (consumer only)
+   *
+   * @param p_count - number of elements to release. Must not exceed the size
+   * of the last `peek()`.
+   */
+  void consume(size_t p_count)
+  {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    m_tail.store(tail + p_count, std::memory_order_release);
+  }
+
+  /**
+   * @return size_t - number of elements in the ring
+   */
+  [[nodiscard]] size_t size() const
+  {
+    const auto tail = m_tail.load(std::memory_order_acquire);
+    const auto head = m_head.load(std::memory_order_acquire);
+    // The producer may have advanced between the two loads
+    return std::min(head - tail, Capacity);
+  }
+
+  /**
+   * @return true - the ring has no elements
+   */
+  [[nodiscard]] bool empty() const
+  {
+    return size() == 0;
+  }
+
+  /**
+   * @return true - the ring cannot accept more elements
+   */
+  [[nodiscard]] bool full() const
+  {
+    return size() == Capacity;
+  }
+
+private:
+  static constexpr size_t mask = Capacity - 1;
+
+  // Indices count up forever and are masked on use. Unsigned wrap around keeps
+  // `head - tail` correct.
+  alignas(IndexAlignment) std::atomic<size_t> m_head = 0;
+  alignas(IndexAlignment) std::atomic<size_t> m_tail = 0;
+  std::array<T, Capacity> m_buffer{};
+};
+}  // namespace hal
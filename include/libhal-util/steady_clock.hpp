@@ -14,6 +14,10 @@
 
 #pragma once
 
+#include <concepts>
+#include <cstdint>
+#include <limits>
+
 #include <libhal/error.hpp>
 #include <libhal/steady_clock.hpp>
 #include <libhal/timeout.hpp>
@@ -26,6 +30,269 @@
  */
 
 namespace hal {
+/**
+ * @ingroup SteadyClock
+ * @brief Converts between time durations and steady clock ticks using only
+ * integer math
+ *
+ * The frequency is captured once at construction and turned into fixed-point
+ * multipliers with a 64-bit fraction (a multiplier/shift pair with a shift of
+ * 64). Conversions then take a handful of 32x32 bit multiplies, with no
+ * division and no floating point, which matters on cores without an FPU or a
+ * hardware divider. Results are exact: the fixed-point estimate is off by at
+ * most one and a single compare corrects it.
+ *
+ * Construct one and keep it around when creating many timeouts from the same
+ * clock:
+ *
+ *     hal::tick_converter converter(clock);
+ *     auto timeout = hal::create_timeout(clock, converter, 10ms);
+ */
+class tick_converter
+{
+public:
+  /**
+   * @ingroup SteadyClock
+   * @brief Create a tick converter for a frequency
+   *
+   * @param p_frequency - tick frequency, rounded to the nearest whole hertz.
+   * Frequencies below 0.5Hz produce zero for every conversion.
+   */
+  constexpr explicit tick_converter(hal::hertz p_frequency)
+    : m_frequency(to_whole_hertz(p_frequency))
+  {
+    if (m_frequency == 0) {
+      return;
+    }
+    m_ticks_per_ns = reciprocal_parts(m_frequency, nanoseconds_per_second);
+    m_ns_per_tick = reciprocal_parts(nanoseconds_per_second, m_frequency);
+  }
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Create a tick converter for a steady clock
+   *
+   * @param p_steady_clock - clock to read the frequency of. Only used during
+   * construction.
+   */
+  explicit tick_converter(hal::steady_clock& p_steady_clock)
+    : tick_converter(p_steady_clock.frequency().operating_frequency)
+  {
+  }
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Get the frequency used for conversions
+   *
+   * @return constexpr std::uint64_t - frequency in whole hertz
+   */
+  [[nodiscard]] constexpr std::uint64_t frequency() const
+  {
+    return m_frequency;
+  }
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Convert a duration to the number of whole ticks within it
+   *
+   * @param p_duration - duration to convert. Negative durations produce 0.
+   * @return constexpr std::uint64_t - floor(duration * frequency). Results
+   * that do not fit in 64 bits wrap around.
+   */
+  [[nodiscard]] constexpr std::uint64_t to_ticks(
+    hal::time_duration p_duration) const
+  {
+    using nanoseconds = std::chrono::duration<std::int64_t, std::nano>;
+    const auto count =
+      std::chrono::duration_cast<nanoseconds>(p_duration).count();
+    if (count <= 0) {
+      return 0;
+    }
+    return scale(static_cast<std::uint64_t>(count),
+                 m_ticks_per_ns,
+                 m_frequency,
+                 nanoseconds_per_second);
+  }
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Convert a duration to ticks of a frequency without a converter
+   *
+   * For one-off conversions, where constructing a tick_converter would cost
+   * more than the conversion itself. Only the duration to ticks direction is
+   * computed: both the duration and the frequency are split into a multiple of
+   * one second and a remainder using a compile time reciprocal of 10^9, which
+   * takes three 64x64 to 128 bit multiplies and no division or loop.
+   *
+   * @param p_frequency - tick frequency, rounded to the nearest whole hertz
+   * @param p_duration - duration to convert. Negative durations produce 0.
+   * @return constexpr std::uint64_t - the same result as
+   * `tick_converter(p_frequency).to_ticks(p_duration)`
+   */
+  [[nodiscard]] static constexpr std::uint64_t to_ticks(
+    hal::hertz p_frequency,
+    hal::time_duration p_duration)
+  {
+    using nanoseconds = std::chrono::duration<std::int64_t, std::nano>;
+    const auto count =
+      std::chrono::duration_cast<nanoseconds>(p_duration).count();
+    if (count <= 0) {
+      return 0;
+    }
+
+    // ns * f / 10^9 = (s * 10^9 + r) * f / 10^9
+    //               = s * f + r * (fs * 10^9 + fr) / 10^9
+    //               = s * f + r * fs + r * fr / 10^9
+    // where r * fr < 10^18 fits in 64 bits.
+    const auto frequency = to_whole_hertz(p_frequency);
+    const auto duration = split_seconds(static_cast<std::uint64_t>(count));
+    const auto cycles = split_seconds(frequency);
+    const auto fraction = split_seconds(duration.remainder * cycles.remainder);
+    return duration.quotient * frequency +
+           duration.remainder * cycles.quotient + fraction.quotient;
+  }
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Convert a number of ticks to the whole nanoseconds within it
+   *
+   * @param p_ticks - number of ticks
+   * @return constexpr hal::time_duration - floor(ticks / frequency). Results
+   * that do not fit in hal::time_duration wrap around.
+   */
+  [[nodiscard]] constexpr hal::time_duration to_duration(
+    std::uint64_t p_ticks) const
+  {
+    using nanoseconds = std::chrono::duration<std::int64_t, std::nano>;
+    if (m_frequency == 0) {
+      return hal::time_duration(0);
+    }
+    const auto count = scale(
+      p_ticks, m_ns_per_tick, nanoseconds_per_second, m_frequency);
+    return std::chrono::duration_cast<hal::time_duration>(
+      nanoseconds(static_cast<std::int64_t>(count)));
+  }
+
+private:
+  static constexpr std::uint64_t nanoseconds_per_second = 1'000'000'000;
+
+  /// p_numerator / p_denominator as a whole part and a 64-bit fraction
+  struct fixed_point
+  {
+    std::uint64_t whole = 0;
+    std::uint64_t fraction = 0;
+  };
+
+  struct wide_product
+  {
+    std::uint64_t high;
+    std::uint64_t low;
+  };
+
+  struct quotient_remainder
+  {
+    std::uint64_t quotient;
+    std::uint64_t remainder;
+  };
+
+  /// Divide by 10^9 with a multiply by its 64-bit reciprocal. The truncated
+  /// reciprocal puts the quotient at most one below the exact result, which a
+  /// single compare corrects.
+  static constexpr quotient_remainder split_seconds(std::uint64_t p_value)
+  {
+    constexpr auto reciprocal =
+      std::numeric_limits<std::uint64_t>::max() / nanoseconds_per_second;
+    auto quotient = multiply(p_value, reciprocal).high;
+    auto remainder = p_value - quotient * nanoseconds_per_second;
+    if (remainder >= nanoseconds_per_second) {
+      quotient++;
+      remainder -= nanoseconds_per_second;
+    }
+    return { .quotient = quotient, .remainder = remainder };
+  }
+
+  static constexpr std::uint64_t to_whole_hertz(hal::hertz p_frequency)
+  {
+    if (!(p_frequency >= 0.5f)) {
+      return 0;
+    }
+    return static_cast<std::uint64_t>(p_frequency + 0.5f);
+  }
+
+  /// Full 128-bit product built from 32-bit multiplies so that it is cheap on
+  /// 32-bit cores without 128-bit integer support.
+  static constexpr wide_product multiply(std::uint64_t p_lhs,
+                                         std::uint64_t p_rhs)
+  {
+    constexpr std::uint64_t mask = 0xFFFF'FFFF;
+    const auto lhs_low = p_lhs & mask;
+    const auto lhs_high = p_lhs >> 32;
+    const auto rhs_low = p_rhs & mask;
+    const auto rhs_high = p_rhs >> 32;
+
+    const auto low_low = lhs_low * rhs_low;
+    const auto low_high = lhs_low * rhs_high;
+    const auto high_low = lhs_high * rhs_low;
+    const auto high_high = lhs_high * rhs_high;
+
+    const auto middle =
+      (low_low >> 32) + (low_high & mask) + (high_low & mask);
+
+    return wide_product{
+      .high = high_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32),
+      .low = (middle << 32) | (low_low & mask),
+    };
+  }
+
+  /// Only evaluated during construction, so the divisions here are not on
+  /// the conversion path.
+  static constexpr fixed_point reciprocal_parts(std::uint64_t p_numerator,
+                                                std::uint64_t p_denominator)
+  {
+    fixed_point result{ .whole = p_numerator / p_denominator };
+    auto remainder = p_numerator % p_denominator;
+
+    // Long division of the remainder, one bit of the fraction at a time
+    for (int bit = 63; bit >= 0; bit--) {
+      const bool carry = (remainder >> 63) != 0;
+      remainder <<= 1;
+      if (carry || remainder >= p_denominator) {
+        remainder -= p_denominator;
+        result.fraction |= std::uint64_t{ 1 } << bit;
+      }
+    }
+
+    return result;
+  }
+
+  /// floor(p_value * p_numerator / p_denominator) where p_factor is
+  /// p_numerator / p_denominator in fixed point
+  static constexpr std::uint64_t scale(std::uint64_t p_value,
+                                       const fixed_point& p_factor,
+                                       std::uint64_t p_numerator,
+                                       std::uint64_t p_denominator)
+  {
+    // The truncated fraction makes this estimate at most one below the exact
+    // result.
+    auto estimate =
+      p_value * p_factor.whole + multiply(p_value, p_factor.fraction).high;
+
+    // Bump the estimate if (estimate + 1) * denominator still fits within
+    // value * numerator.
+    const auto exact = multiply(p_value, p_numerator);
+    const auto next = multiply(estimate + 1, p_denominator);
+    const bool below = next.high < exact.high ||
+                       (next.high == exact.high && next.low <= exact.low);
+    estimate += below ? 1 : 0;
+
+    return estimate;
+  }
+
+  std::uint64_t m_frequency;
+  fixed_point m_ticks_per_ns{};
+  fixed_point m_ns_per_tick{};
+};
+
 /**
  * @ingroup SteadyClock
  * @brief Function to compute a future timestamp in ticks
@@ -49,6 +316,23 @@ namespace hal {
 inline std::uint64_t future_deadline(hal::steady_clock& p_steady_clock,
                                      hal::time_duration p_duration);
 
+/**
+ * @ingroup SteadyClock
+ * @brief Function to compute a future timestamp in ticks using a cached tick
+ * converter
+ *
+ * @param p_steady_clock - the steady_clock used to calculate the future
+ * duration
+ * @param p_converter - tick converter created for p_steady_clock
+ * @param p_duration - the duration for which we need to compute a future
+ * timestamp
+ * @return std::uint64_t - the future timestamp in steady clock ticks, at least
+ * one tick after the current uptime
+ */
+std::uint64_t future_deadline(hal::steady_clock& p_steady_clock,
+                              const tick_converter& p_converter,
+                              hal::time_duration p_duration);
+
 /**
  * @ingroup SteadyClock
  * @brief Timeout object based on hal::steady_clock
@@ -69,6 +353,19 @@ public:
   static steady_clock_timeout create(hal::steady_clock& p_steady_clock,
                                      hal::time_duration p_duration);
 
+  /**
+   * @ingroup SteadyClock
+   * @brief Create a steady_clock_timeout using a cached tick converter
+   *
+   * @param p_steady_clock - steady clock implementation
+   * @param p_converter - tick converter created for p_steady_clock
+   * @param p_duration - amount of time until timeout
+   * @return steady_clock_timeout - steady_clock_timeout object
+   */
+  static steady_clock_timeout create(hal::steady_clock& p_steady_clock,
+                                     const tick_converter& p_converter,
+                                     hal::time_duration p_duration);
+
   /**
    * @ingroup SteadyClock
    * @brief Construct a new counter timeout object
@@ -139,6 +436,304 @@ private:
 steady_clock_timeout create_timeout(hal::steady_clock& p_steady_clock,
                                     hal::time_duration p_duration);
 
+/**
+ * @ingroup SteadyClock
+ * @brief Create a timeout object based on hal::steady_clock using a cached
+ * tick converter
+ *
+ * @param p_steady_clock - hal::steady_clock implementation
+ * @param p_converter - tick converter created for p_steady_clock
+ * @param p_duration - amount of time until timeout
+ * @return hal::steady_clock_timeout - timeout object
+ */
+steady_clock_timeout create_timeout(hal::steady_clock& p_steady_clock,
+                                    const tick_converter& p_converter,
+                                    hal::time_duration p_duration);
+
+/**
+ * @ingroup SteadyClock
+ * @brief Timeout based on hal::steady_clock that skips clock reads when it is
+ * polled faster than needed
+ *
+ * Every clock read measures how many calls were made since the previous read
+ * and how many ticks passed. The number of calls until the next read is then
+ * set so that the next read lands at most `max_overshoot` after the previous
+ * one, assuming the poll rate stays the same. A timeout is therefore reported
+ * at most `max_overshoot` after the deadline, as long as polls do not suddenly
+ * become slower. The interval at most doubles per read and never exceeds
+ * `max_interval`, which limits the damage when they do.
+ *
+ * Use `hal::create_adaptive_timeout()` to create one.
+ */
+class adaptive_steady_clock_timeout
+{
+public:
+  /// Upper limit on the number of calls between two clock reads
+  static constexpr std::uint32_t max_interval = 1U << 16;
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Create an adaptive_steady_clock_timeout
+   *
+   * @param p_steady_clock - steady clock implementation
+   * @param p_converter - tick converter created for p_steady_clock
+   * @param p_duration - amount of time until timeout
+   * @param p_max_overshoot - how late the timeout may be reported
+   * @return adaptive_steady_clock_timeout - timeout object
+   */
+  static adaptive_steady_clock_timeout create(
+    hal::steady_clock& p_steady_clock,
+    const tick_converter& p_converter,
+    hal::time_duration p_duration,
+    hal::time_duration p_max_overshoot);
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Create an adaptive_steady_clock_timeout without a tick converter
+   *
+   * @param p_steady_clock - steady clock implementation
+   * @param p_duration - amount of time until timeout
+   * @param p_max_overshoot - how late the timeout may be reported
+   * @return adaptive_steady_clock_timeout - timeout object
+   */
+  static adaptive_steady_clock_timeout create(
+    hal::steady_clock& p_steady_clock,
+    hal::time_duration p_duration,
+    hal::time_duration p_max_overshoot);
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Call this object to check if it has timed out.
+   *
+   * @return status - success or failure
+   * @throws std::errc::timed_out - if the timeout time has been exceeded.
+   */
+  status operator()();
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Get the current number of calls per clock read
+   *
+   * @return std::uint32_t - calls per clock read
+   */
+  [[nodiscard]] std::uint32_t interval() const
+  {
+    return m_interval;
+  }
+
+private:
+  static adaptive_steady_clock_timeout create_from_ticks(
+    hal::steady_clock& p_steady_clock,
+    std::uint64_t p_ticks_required,
+    std::uint64_t p_overshoot_ticks);
+
+  adaptive_steady_clock_timeout(hal::steady_clock& p_steady_clock,
+                                std::uint64_t p_start,
+                                std::uint64_t p_deadline,
+                                std::uint64_t p_overshoot_ticks);
+
+  hal::steady_clock* m_counter;
+  std::uint64_t m_last_sample;
+  std::uint64_t m_deadline;
+  std::uint64_t m_overshoot_ticks;
+  std::uint32_t m_interval = 1;
+  std::uint32_t m_calls = 0;
+};
+
+/**
+ * @ingroup SteadyClock
+ * @brief Create a timeout that reads the clock only as often as needed to meet
+ * a maximum overshoot
+ *
+ * Prefer this over `hal::create_timeout()` in tight polling loops on clocks
+ * that are expensive to read.
+ *
+ * @param p_steady_clock - hal::steady_clock implementation
+ * @param p_duration - amount of time until timeout
+ * @param p_max_overshoot - how late the timeout may be reported
+ * @return hal::adaptive_steady_clock_timeout - timeout object
+ */
+adaptive_steady_clock_timeout create_adaptive_timeout(
+  hal::steady_clock& p_steady_clock,
+  hal::time_duration p_duration,
+  hal::time_duration p_max_overshoot);
+
+/**
+ * @ingroup SteadyClock
+ * @brief Create an adaptive timeout using a cached tick converter
+ *
+ * @param p_steady_clock - hal::steady_clock implementation
+ * @param p_converter - tick converter created for p_steady_clock
+ * @param p_duration - amount of time until timeout
+ * @param p_max_overshoot - how late the timeout may be reported
+ * @return hal::adaptive_steady_clock_timeout - timeout object
+ */
+adaptive_steady_clock_timeout create_adaptive_timeout(
+  hal::steady_clock& p_steady_clock,
+  const tick_converter& p_converter,
+  hal::time_duration p_duration,
+  hal::time_duration p_max_overshoot);
+
+/**
+ * @ingroup SteadyClock
+ * @brief An absolute point in time on a steady clock that can be handed down
+ * to sub-operations
+ *
+ * A deadline is a timeout: calling it reads the clock once and reports
+ * std::errc::timed_out once the deadline has passed. Unlike
+ * steady_clock_timeout it can be narrowed for a sub-operation with within()
+ * or split() and combined with `hal::earliest()`. The result is always another
+ * deadline, so a check costs a single uptime() read however deeply the
+ * deadlines were nested.
+ *
+ *     hal::status modbus_request(hal::deadline p_deadline)
+ *     {
+ *       // Give the write at most half of the remaining time
+ *       HAL_CHECK(write_request(p_deadline.split(1, 2)));
+ *       // Reading the reply may take 5ms or whatever is left, if less
+ *       return read_reply(p_deadline.within(5ms));
+ *     }
+ */
+class deadline
+{
+public:
+  /**
+   * @ingroup SteadyClock
+   * @brief Create a deadline at an absolute uptime
+   *
+   * @param p_steady_clock - clock the deadline is measured against
+   * @param p_ticks - uptime in ticks at which the deadline expires
+   */
+  constexpr deadline(hal::steady_clock& p_steady_clock, std::uint64_t p_ticks)
+    : m_counter(&p_steady_clock)
+    , m_ticks(p_ticks)
+  {
+  }
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Call this object to check if it has timed out.
+   *
+   * @return status - success or failure
+   * @throws std::errc::timed_out - if the deadline has passed.
+   */
+  status operator()();
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Get the number of ticks until the deadline
+   *
+   * @return std::uint64_t - ticks remaining, or zero if the deadline has passed
+   */
+  [[nodiscard]] std::uint64_t remaining() const;
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Narrow the deadline to a duration from now
+   *
+   * @param p_converter - tick converter created for this deadline's clock
+   * @param p_duration - maximum amount of time from now
+   * @return deadline - whichever is earlier of this deadline and now plus
+   * p_duration
+   */
+  [[nodiscard]] deadline within(const tick_converter& p_converter,
+                                hal::time_duration p_duration) const;
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Narrow the deadline to a duration from now
+   *
+   * Reads the clock frequency. Use the tick_converter overload when narrowing
+   * often.
+   *
+   * @param p_duration - maximum amount of time from now
+   * @return deadline - whichever is earlier of this deadline and now plus
+   * p_duration
+   */
+  [[nodiscard]] deadline within(hal::time_duration p_duration) const;
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Give a fraction of the remaining time to a sub-operation
+   *
+   * @param p_numerator - numerator of the fraction of the remaining time
+   * @param p_denominator - denominator of the fraction of the remaining time.
+   * Fractions above one are treated as one and a zero denominator returns an
+   * unchanged deadline.
+   * @return deadline - deadline p_numerator / p_denominator of the remaining
+   * time from now
+   */
+  [[nodiscard]] deadline split(std::uint32_t p_numerator,
+                               std::uint32_t p_denominator) const;
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Get the uptime at which the deadline expires
+   *
+   * @return constexpr std::uint64_t - deadline in ticks of clock()
+   */
+  [[nodiscard]] constexpr std::uint64_t ticks() const
+  {
+    return m_ticks;
+  }
+
+  /**
+   * @ingroup SteadyClock
+   * @brief Get the clock the deadline is measured against
+   *
+   * @return constexpr hal::steady_clock& - the deadline's clock
+   */
+  [[nodiscard]] constexpr hal::steady_clock& clock() const
+  {
+    return *m_counter;
+  }
+
+private:
+  hal::steady_clock* m_counter;
+  std::uint64_t m_ticks;
+};
+
+/**
+ * @ingroup SteadyClock
+ * @brief Create a deadline a duration from now
+ *
+ * @param p_steady_clock - hal::steady_clock implementation
+ * @param p_duration - amount of time until the deadline
+ * @return hal::deadline - deadline at least one tick in the future
+ */
+deadline create_deadline(hal::steady_clock& p_steady_clock,
+                         hal::time_duration p_duration);
+
+/**
+ * @ingroup SteadyClock
+ * @brief Create a deadline a duration from now using a cached tick converter
+ *
+ * @param p_steady_clock - hal::steady_clock implementation
+ * @param p_converter - tick converter created for p_steady_clock
+ * @param p_duration - amount of time until the deadline
+ * @return hal::deadline - deadline at least one tick in the future
+ */
+deadline create_deadline(hal::steady_clock& p_steady_clock,
+                         const tick_converter& p_converter,
+                         hal::time_duration p_duration);
+
+/**
+ * @ingroup SteadyClock
+ * @brief Get the earliest of a set of deadlines
+ *
+ * Does not read the clock. All deadlines must be on the same clock.
+ *
+ * @param p_first - first deadline
+ * @param p_rest - other deadlines
+ * @return constexpr deadline - the deadline that expires first
+ */
+constexpr deadline earliest(deadline p_first,
+                            std::same_as<deadline> auto... p_rest)
+{
+  ((p_first = p_rest.ticks() < p_first.ticks() ? p_rest : p_first), ...);
+  return p_first;
+}
+
 /**
  * @ingroup SteadyClock
  * @brief Delay execution for a duration of time using a hardware steady_clock.
@@ -149,10 +744,25 @@ steady_clock_timeout create_timeout(hal::steady_clock& p_steady_clock,
  */
 void delay(hal::steady_clock& p_steady_clock, hal::time_duration p_duration);
 
+/**
+ * @ingroup SteadyClock
+ * @brief Delay execution for a duration of time using a cached tick converter
+ *
+ * @param p_steady_clock - steady_clock driver
+ * @param p_converter - tick converter created for p_steady_clock
+ * @param p_duration - the amount of time to delay for. Zero or negative time
+ * duration will delay for one tick of the p_steady_clock.
+ */
+void delay(hal::steady_clock& p_steady_clock,
+           const tick_converter& p_converter,
+           hal::time_duration p_duration);
+
 /**
  * @ingroup SteadyClock
  * @brief Generates a function that, when passed a duration, returns a timeout
  *
+ * The clock frequency is read once, when the generator is created.
+ *
  * @param p_steady_clock - steady_clock driver that must out live the lifetime
  * of the returned lambda.
  * @return auto - a callable that returns a new timeout object each time a time
@@ -160,8 +770,9 @@ void delay(hal::steady_clock& p_steady_clock, hal::time_duration p_duration);
  */
 inline auto timeout_generator(hal::steady_clock& p_steady_clock)
 {
-  return [&p_steady_clock](hal::time_duration p_duration) -> auto {
-    return create_timeout(p_steady_clock, p_duration);
+  return [&p_steady_clock, converter = tick_converter(p_steady_clock)](
+           hal::time_duration p_duration) -> auto {
+    return create_timeout(p_steady_clock, converter, p_duration);
   };
 }
 }  // namespace hal
@@ -14,13 +14,26 @@
 
 #pragma once
 
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <optional>
 #include <span>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include <libhal/error.hpp>
 #include <libhal/timeout.hpp>
 #include <libhal/units.hpp>
 
+#include "timeout.hpp"
+
 /**
  * @defgroup Streams Streams
  *
@@ -56,6 +69,298 @@ private:
   size_t m_search_index = 0;
 };
 
+/**
+ * @ingroup Streams
+ * @brief Count the number of automaton states required for a set of patterns
+ *
+ * Use this to determine the StateCount template argument of
+ * `hal::find_any_automaton`.
+ *
+ * @tparam PatternCount - number of patterns
+ * @param p_patterns - patterns that will be searched for
+ * @return constexpr size_t - number of states, one for each unique prefix of
+ * the patterns plus the start state.
+ */
+template<size_t PatternCount>
+[[nodiscard]] constexpr size_t find_any_state_count(
+  const std::array<std::string_view, PatternCount>& p_patterns)
+{
+  size_t count = 1;
+
+  for (size_t index = 0; index < PatternCount; index++) {
+    const auto pattern = p_patterns[index];
+    for (size_t length = 1; length <= pattern.size(); length++) {
+      const auto prefix = pattern.substr(0, length);
+      bool is_unique = true;
+      for (size_t other = 0; other < index; other++) {
+        if (p_patterns[other].substr(0, length) == prefix) {
+          is_unique = false;
+          break;
+        }
+      }
+      if (is_unique) {
+        count++;
+      }
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @ingroup Streams
+ * @brief Aho-Corasick automaton for finding any one of a set of patterns
+ *
+ * The automaton is intended to be built at compile time and placed in read
+ * only memory. Its size is fixed by the template arguments and it never
+ * allocates.
+ *
+ * Usage:
+ *
+ *     static constexpr std::array<std::string_view, 3> responses{
+ *       "OK", "ERROR", "+CME ERROR"
+ *     };
+ *     static constexpr hal::find_any_automaton<
+ *       responses.size(), hal::find_any_state_count(responses)>
+ *       response_automaton(responses);
+ *
+ * States are stored in breadth first order so that the children of each state
+ * are adjacent to each other. Transitions out of the start state are looked up
+ * in a 256 entry table, as the start state is where the search spends most of
+ * its time while skipping bytes that cannot begin a pattern.
+ *
+ * @tparam PatternCount - number of patterns
+ * @tparam StateCount - number of states, see `hal::find_any_state_count`
+ */
+template<size_t PatternCount, size_t StateCount>
+class find_any_automaton
+{
+public:
+  static_assert(StateCount < std::numeric_limits<std::uint16_t>::max(),
+                "Too many states for a 16-bit state index");
+
+  /// Value of `output()` for states that do not complete a pattern
+  static constexpr std::uint16_t no_match =
+    std::numeric_limits<std::uint16_t>::max();
+
+  /**
+   * @ingroup Streams
+   * @brief Build the automaton
+   *
+   * @param p_patterns - patterns to search for. Empty patterns are ignored. If
+   * a pattern appears more than once, the first index is reported.
+   */
+  constexpr explicit find_any_automaton(
+    const std::array<std::string_view, PatternCount>& p_patterns)
+  {
+    // Build a plain trie using first child / next sibling links
+    std::array<std::uint16_t, StateCount> trie_child{};
+    std::array<std::uint16_t, StateCount> trie_sibling{};
+    std::array<hal::byte, StateCount> trie_symbol{};
+    std::array<std::uint16_t, StateCount> trie_output{};
+    trie_output.fill(no_match);
+    size_t trie_size = 1;
+
+    for (size_t index = 0; index < PatternCount; index++) {
+      if (p_patterns[index].empty()) {
+        continue;
+      }
+
+      std::uint16_t state = 0;
+      for (const auto character : p_patterns[index]) {
+        const auto symbol = static_cast<hal::byte>(character);
+        auto child = trie_child[state];
+        while (child != 0 && trie_symbol[child] != symbol) {
+          child = trie_sibling[child];
+        }
+        if (child == 0) {
+          child = static_cast<std::uint16_t>(trie_size++);
+          trie_symbol[child] = symbol;
+          trie_sibling[child] = trie_child[state];
+          trie_child[state] = child;
+        }
+        state = child;
+      }
+
+      if (trie_output[state] == no_match) {
+        trie_output[state] = static_cast<std::uint16_t>(index);
+      }
+    }
+
+    // Renumber the states in breadth first order, so that each state's
+    // children are contiguous.
+    std::array<std::uint16_t, StateCount> queue{};
+    size_t queue_end = 1;
+
+    for (size_t position = 0; position < queue_end; position++) {
+      const auto trie_state = queue[position];
+      auto& state = m_states[position];
+      state.first_child = static_cast<std::uint16_t>(queue_end);
+      state.output = trie_output[trie_state];
+
+      for (auto child = trie_child[trie_state]; child != 0;
+           child = trie_sibling[child]) {
+        m_states[queue_end].symbol = trie_symbol[child];
+        queue[queue_end++] = child;
+        state.child_count++;
+      }
+    }
+
+    for (std::uint16_t child = 1; child <= m_states[0].child_count; child++) {
+      m_start[m_states[child].symbol] = child;
+    }
+
+    // Failure links must be computed in breadth first order, as each link
+    // depends on the links of shallower states.
+    for (std::uint16_t state = 0; state < queue_end; state++) {
+      const auto& parent = m_states[state];
+      for (std::uint16_t offset = 0; offset < parent.child_count; offset++) {
+        const auto child = static_cast<std::uint16_t>(parent.first_child +
+                                                      offset);
+        auto& current = m_states[child];
+
+        if (state != 0) {
+          current.failure = next(parent.failure, current.symbol);
+        }
+
+        if (current.output == no_match) {
+          current.output = m_states[current.failure].output;
+        }
+      }
+    }
+  }
+
+  /**
+   * @ingroup Streams
+   * @brief Get the state that follows p_state after receiving p_symbol
+   *
+   * @param p_state - current state
+   * @param p_symbol - received byte
+   * @return constexpr std::uint16_t - next state
+   */
+  [[nodiscard]] constexpr std::uint16_t next(std::uint16_t p_state,
+                                             hal::byte p_symbol) const
+  {
+    while (p_state != 0) {
+      const auto& state = m_states[p_state];
+      for (std::uint16_t offset = 0; offset < state.child_count; offset++) {
+        const auto child =
+          static_cast<std::uint16_t>(state.first_child + offset);
+        if (m_states[child].symbol == p_symbol) {
+          return child;
+        }
+      }
+      p_state = state.failure;
+    }
+    return m_start[p_symbol];
+  }
+
+  /**
+   * @ingroup Streams
+   * @brief Get the pattern completed by reaching a state
+   *
+   * @param p_state - state to check
+   * @return constexpr std::uint16_t - index of the pattern or `no_match`. If
+   * several patterns end at the same position, the longest is reported.
+   */
+  [[nodiscard]] constexpr std::uint16_t output(std::uint16_t p_state) const
+  {
+    return m_states[p_state].output;
+  }
+
+private:
+  struct state_t
+  {
+    std::uint16_t first_child = 0;
+    std::uint16_t child_count = 0;
+    std::uint16_t failure = 0;
+    std::uint16_t output = no_match;
+    hal::byte symbol = 0;
+  };
+
+  std::array<state_t, StateCount> m_states{};
+  std::array<std::uint16_t, 256> m_start{};
+};
+
+/**
+ * @ingroup Streams
+ * @brief Discard received bytes until any one of a set of patterns is found
+ *
+ * Each byte is examined once regardless of the number of patterns, using an
+ * automaton built by `hal::find_any_automaton`.
+ *
+ * @tparam PatternCount - number of patterns
+ * @tparam StateCount - number of states in the automaton
+ */
+template<size_t PatternCount, size_t StateCount>
+class stream_find_any
+{
+public:
+  /**
+   * @ingroup Streams
+   * @brief Construct a new find any object
+   *
+   * @param p_automaton - automaton to search with. Must outlive this object.
+   * Multiple stream_find_any objects can share the same automaton.
+   */
+  explicit stream_find_any(
+    const find_any_automaton<PatternCount, StateCount>& p_automaton)
+    : m_automaton(&p_automaton)
+  {
+  }
+
+  /**
+   * @ingroup Streams
+   * @brief Search for the patterns
+   *
+   * @return std::span<const hal::byte> - bytes after the end of the matched
+   * pattern or an empty span if no pattern was completed
+   */
+  friend std::span<const hal::byte> operator|(
+    const std::span<const hal::byte>& p_input_data,
+    stream_find_any& p_self)
+  {
+    if (p_input_data.empty() || p_self.m_pattern.has_value()) {
+      return p_input_data;
+    }
+
+    for (size_t index = 0; index < p_input_data.size(); index++) {
+      p_self.m_state = p_self.m_automaton->next(p_self.m_state,
+                                                p_input_data[index]);
+      const auto output = p_self.m_automaton->output(p_self.m_state);
+
+      if (output != automaton_t::no_match) {
+        p_self.m_pattern = output;
+        return p_input_data.subspan(index + 1);
+      }
+    }
+
+    return p_input_data.subspan(p_input_data.size());
+  }
+
+  work_state state()
+  {
+    return m_pattern.has_value() ? work_state::finished
+                                 : work_state::in_progress;
+  }
+
+  /**
+   * @return std::optional<size_t> - index of the pattern that was found or
+   * std::nullopt if no pattern has been found yet
+   */
+  std::optional<size_t> pattern()
+  {
+    return m_pattern;
+  }
+
+private:
+  using automaton_t = find_any_automaton<PatternCount, StateCount>;
+
+  const automaton_t* m_automaton;
+  std::optional<size_t> m_pattern = std::nullopt;
+  std::uint16_t m_state = 0;
+};
+
 /**
  * @ingroup Streams
  * @brief Non-blocking callable for reading serial data into a buffer
@@ -185,6 +490,302 @@ private:
   bool m_finished = false;
 };
 
+/**
+ * @ingroup Streams
+ * @brief Read bytes from stream and convert to a signed, unsigned, or floating
+ * point number
+ *
+ * Non-number bytes before the number are skipped. Parsing finishes on the
+ * first byte after the number that cannot be part of it, which is left at the
+ * start of the returned span.
+ *
+ * Accepted formats:
+ *
+ * - Signed integers: an optional '-' or '+' directly before the digits.
+ *   Unsigned types treat a sign as a non-number byte.
+ * - Hexadecimal integers (Base = 16): upper or lower case digits with an
+ *   optional "0x" or "0X" prefix.
+ * - Floating point: an optional sign, digits, and an optional '.' followed by
+ *   fractional digits, e.g. "-4807.038". The integer digits may be left out,
+ *   as in ".5" or "-.5". Exponents are not supported.
+ *
+ * If an integer does not fit within T, the state becomes work_state::failed
+ * and the returned span starts at the digit that caused the overflow.
+ *
+ * Decimal digits are consumed eight at a time when the input span has enough
+ * bytes left, which makes long numbers considerably cheaper than byte-by-byte
+ * parsing.
+ *
+ * @tparam T - type of the number to parse
+ * @tparam Base - base of the number, 10 or 16. Floating point numbers must be
+ * base 10.
+ */
+template<typename T, unsigned Base = 10>
+  requires(std::integral<T> || std::floating_point<T>)
+class stream_parse_number
+{
+public:
+  static_assert(Base == 10 || Base == 16, "Only base 10 and 16 are supported");
+  static_assert(std::integral<T> || Base == 10,
+                "Floating point numbers must be base 10");
+
+  /**
+   * @ingroup Streams
+   * @brief Construct a new parse number object
+   */
+  explicit stream_parse_number() = default;
+
+  friend std::span<const hal::byte> operator|(
+    const std::span<const hal::byte>& p_input_data,
+    stream_parse_number& p_self)
+  {
+    if (p_self.m_state != work_state::in_progress) {
+      return p_input_data;
+    }
+
+    size_t index = 0;
+    while (index < p_input_data.size()) {
+      if constexpr (Base == 10) {
+        if (p_self.parse_eight_digits(p_input_data, index)) {
+          index += 8;
+          continue;
+        }
+      }
+
+      const auto input = p_input_data[index];
+      const auto digit = to_digit(input);
+
+      if (digit < Base) {
+        if (!p_self.accumulate(digit)) {
+          p_self.m_state = work_state::failed;
+          return p_input_data.subspan(index);
+        }
+        p_self.m_found_digit = true;
+      } else if (p_self.m_found_digit) {
+        if (!p_self.accept_separator(input)) {
+          p_self.finish();
+          return p_input_data.subspan(index);
+        }
+      } else {
+        p_self.accept_sign(input);
+      }
+
+      index++;
+    }
+
+    return p_input_data.last(0);
+  }
+
+  work_state state()
+  {
+    return m_state;
+  }
+
+  /**
+   * @return const T& - the parsed value. Only valid once the state is
+   * work_state::finished.
+   */
+  const T& value()
+  {
+    return m_value;
+  }
+
+private:
+  using magnitude_t = std::uint64_t;
+
+  static constexpr unsigned to_digit(hal::byte p_byte)
+  {
+    if (p_byte >= '0' && p_byte <= '9') {
+      return static_cast<unsigned>(p_byte - '0');
+    }
+    if constexpr (Base == 16) {
+      // Setting bit 5 converts 'A' through 'F' to 'a' through 'f'
+      const auto lower = static_cast<hal::byte>(p_byte | 0x20);
+      if (lower >= 'a' && lower <= 'f') {
+        return static_cast<unsigned>(lower - 'a') + 10U;
+      }
+    }
+    return Base;
+  }
+
+  static constexpr magnitude_t magnitude_limit(bool p_negative)
+  {
+    if constexpr (std::floating_point<T>) {
+      return std::numeric_limits<magnitude_t>::max();
+    } else if constexpr (std::is_signed_v<T>) {
+      constexpr auto max =
+        static_cast<magnitude_t>(std::numeric_limits<T>::max());
+      return p_negative ? max + 1 : max;
+    } else {
+      return std::numeric_limits<T>::max();
+    }
+  }
+
+  /**
+   * @return true - the digit was accumulated into the number
+   * @return false - the digit would overflow the number
+   */
+  bool accumulate(unsigned p_digit)
+  {
+    if constexpr (std::floating_point<T>) {
+      // Digits beyond the precision of the accumulator only affect the scale
+      // of the integer part and are otherwise dropped.
+      if (m_magnitude > (magnitude_limit(false) - p_digit) / Base) {
+        if (!m_in_fraction) {
+          m_exponent++;
+        }
+        return true;
+      }
+      if (m_in_fraction) {
+        m_exponent--;
+      }
+    } else {
+      if (m_magnitude > (magnitude_limit(m_negative) - p_digit) / Base) {
+        return false;
+      }
+    }
+
+    m_magnitude = (m_magnitude * Base) + p_digit;
+    return true;
+  }
+
+  /**
+   * @brief Convert eight ASCII decimal digits at the index at once
+   *
+   * @return true - eight digits were parsed and accumulated
+   * @return false - fewer than eight digits remain, the accumulator could
+   * overflow, or the platform is not little endian. Nothing is consumed.
+   */
+  bool parse_eight_digits(std::span<const hal::byte> p_input, size_t p_index)
+  {
+    if constexpr (std::endian::native != std::endian::little) {
+      return false;
+    }
+
+    constexpr magnitude_t eight_digit_scale = 100'000'000;
+    constexpr magnitude_t zeros = 0x3030'3030'3030'3030;
+
+    if (p_input.size() - p_index < 8) {
+      return false;
+    }
+
+    magnitude_t chunk = 0;
+    std::memcpy(&chunk, p_input.data() + p_index, sizeof(chunk));
+
+    // Each byte must be within '0' (0x30) and '9' (0x39). Adding 6 to a digit
+    // keeps it within 0x3_ where as ':' through '?' carry into 0x4_.
+    constexpr magnitude_t high_nibbles = 0xF0F0'F0F0'F0F0'F0F0;
+    constexpr magnitude_t six = 0x0606'0606'0606'0606;
+    if ((chunk & high_nibbles) != zeros ||
+        ((chunk + six) & high_nibbles) != zeros) {
+      return false;
+    }
+
+    // Combine adjacent digits into pairs, then pairs into groups of four, then
+    // the two groups of four into the final value.
+    chunk -= zeros;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x0000'00FF'0000'00FF) * (100 + (1'000'000ULL << 32))) +
+             (((chunk >> 16) & 0x0000'00FF'0000'00FF) *
+              (1 + (10'000ULL << 32)))) >>
+            32;
+
+    // Checked before multiplying, as the product can wrap a 64-bit
+    // accumulator. Leave an overflowing chunk to the byte-by-byte path so it
+    // stops at the digit that overflows.
+    const auto limit = magnitude_limit(m_negative);
+    if (m_magnitude > (limit - chunk) / eight_digit_scale) {
+      return false;
+    }
+
+    m_magnitude = (m_magnitude * eight_digit_scale) + chunk;
+    m_found_digit = true;
+    if constexpr (std::floating_point<T>) {
+      if (m_in_fraction) {
+        m_exponent -= 8;
+      }
+    }
+    return true;
+  }
+
+  void accept_sign(hal::byte p_byte)
+  {
+    if constexpr (std::floating_point<T>) {
+      // A '.' before any digit starts the fraction and keeps a sign directly
+      // before it. A second '.' means the first was not part of the number.
+      if (p_byte == '.') {
+        if (m_in_fraction) {
+          m_negative = false;
+        }
+        m_in_fraction = true;
+        return;
+      }
+      m_in_fraction = false;
+    }
+    if constexpr (std::is_signed_v<T>) {
+      if (p_byte == '-' || p_byte == '+') {
+        m_negative = (p_byte == '-');
+        return;
+      }
+    }
+    // Any other non-digit byte means that a previous sign was not directly
+    // before the number.
+    m_negative = false;
+  }
+
+  /**
+   * @return true - the byte is part of the number
+   * @return false - the byte terminates the number
+   */
+  bool accept_separator(hal::byte p_byte)
+  {
+    if constexpr (std::floating_point<T>) {
+      if (p_byte == '.' && !m_in_fraction) {
+        m_in_fraction = true;
+        return true;
+      }
+    }
+    if constexpr (Base == 16) {
+      if ((p_byte == 'x' || p_byte == 'X') && !m_found_prefix &&
+          m_magnitude == 0) {
+        m_found_prefix = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void finish()
+  {
+    if constexpr (std::floating_point<T>) {
+      T scale = 1;
+      for (int i = 0; i < std::abs(m_exponent); i++) {
+        scale *= 10;
+      }
+      auto value = static_cast<T>(m_magnitude);
+      value = (m_exponent < 0) ? value / scale : value * scale;
+      m_value = m_negative ? -value : value;
+    } else if constexpr (std::is_signed_v<T>) {
+      // Negate as unsigned to avoid overflowing when the value is
+      // std::numeric_limits<T>::min().
+      const auto magnitude = m_negative ? (~m_magnitude + 1) : m_magnitude;
+      m_value = static_cast<T>(static_cast<std::int64_t>(magnitude));
+    } else {
+      m_value = static_cast<T>(m_magnitude);
+    }
+    m_state = work_state::finished;
+  }
+
+  T m_value = 0;
+  magnitude_t m_magnitude = 0;
+  int m_exponent = 0;
+  work_state m_state = work_state::in_progress;
+  bool m_found_digit = false;
+  bool m_negative = false;
+  bool m_in_fraction = false;
+  bool m_found_prefix = false;
+};
+
 /**
  * @ingroup Streams
  * @brief Skip number of bytes in a byte stream
@@ -209,4 +810,131 @@ public:
 private:
   size_t m_skip;
 };
+
+/**
+ * @ingroup Streams
+ * @brief Chain stream stages together into a single stage
+ *
+ * A pipeline holds references to a fixed set of stages, known at compile time,
+ * and passes each incoming chunk through them in order. Each stage consumes
+ * bytes before handing the rest of the chunk to the next stage, so every byte
+ * is only examined once. Stages that have already finished are skipped rather
+ * than called again, and no stage after an in progress or failed stage is
+ * called.
+ *
+ * Usage:
+ *
+ *     hal::stream_find find_length(hal::as_bytes("Content-Length: "sv));
+ *     hal::stream_parse<std::uint32_t> parse_length;
+ *     hal::stream_pipeline header(find_length, parse_length);
+ *
+ *     auto remaining = received_data | header;
+ *     if (hal::finished(header.state())) {
+ *       // use parse_length.value()
+ *     }
+ *
+ * A pipeline is itself a stage and can be used within `operator|` chains or
+ * other pipelines.
+ *
+ * @tparam Stages - types of the stages in the pipeline. Each must have a
+ * `state()` function returning work_state and an `operator|` taking a
+ * `std::span<const hal::byte>`.
+ */
+template<has_work_state... Stages>
+class stream_pipeline
+{
+public:
+  static_assert(sizeof...(Stages) > 0, "A pipeline requires at least 1 stage");
+
+  /**
+   * @ingroup Streams
+   * @brief Construct a new pipeline object
+   *
+   * @param p_stages - stages to run in order. Each stage must outlive this
+   * object.
+   */
+  explicit stream_pipeline(Stages&... p_stages)
+    : m_stages(p_stages...)
+  {
+  }
+
+  friend std::span<const hal::byte> operator|(
+    const std::span<const hal::byte>& p_input_data,
+    stream_pipeline& p_self)
+  {
+    if (p_self.m_state != work_state::in_progress) {
+      return p_input_data;
+    }
+
+    auto remaining = p_input_data;
+    p_self.run(remaining, std::index_sequence_for<Stages...>{});
+
+    if (p_self.m_stage == sizeof...(Stages)) {
+      p_self.m_state = work_state::finished;
+    }
+
+    return remaining;
+  }
+
+  /**
+   * @return work_state - work_state::finished if every stage has finished,
+   * work_state::failed if a stage failed, or work_state::in_progress
+   */
+  work_state state()
+  {
+    return m_state;
+  }
+
+  /**
+   * @ingroup Streams
+   * @brief Get the index of the stage that the pipeline stopped on
+   *
+   * @return size_t - index of the stage that is in progress or that failed.
+   * Returns the number of stages when every stage has finished.
+   */
+  size_t stage()
+  {
+    return m_stage;
+  }
+
+private:
+  template<size_t... Index>
+  void run(std::span<const hal::byte>& p_data,
+           std::index_sequence<Index...> /* indices */)
+  {
+    // Stops at the first stage that has not finished
+    (run_stage<Index>(p_data) && ...);
+  }
+
+  /**
+   * @return true - the stage has finished and the next stage can be run
+   * @return false - the stage needs more data or has failed
+   */
+  template<size_t Index>
+  bool run_stage(std::span<const hal::byte>& p_data)
+  {
+    if (Index < m_stage) {
+      return true;
+    }
+
+    auto& stage = std::get<Index>(m_stages);
+    p_data = p_data | stage;
+    const auto stage_state = stage.state();
+
+    if (stage_state == work_state::finished) {
+      m_stage = Index + 1;
+      return true;
+    }
+
+    if (stage_state == work_state::failed) {
+      m_state = work_state::failed;
+    }
+
+    return false;
+  }
+
+  std::tuple<Stages&...> m_stages;
+  size_t m_stage = 0;
+  work_state m_state = work_state::in_progress;
+};
 }  // namespace hal
@@ -14,10 +14,13 @@
 
 #pragma once
 
+#include <array>
 #include <concepts>
+#include <cstdint>
 #include <functional>
 #include <ios>
 #include <system_error>
+#include <utility>
 
 #include <libhal/error.hpp>
 #include <libhal/timeout.hpp>
@@ -136,4 +139,199 @@ inline result<work_state> try_until(worker auto&& p_worker,
   worker auto& worker = p_worker;
   return try_until(worker, p_timeout);
 };
+
+/**
+ * @ingroup TimeoutUtil
+ * @brief Timeout that expires after a fixed number of checks
+ *
+ * Never reads a clock, which makes loops bounded by it fully deterministic.
+ * Useful for host benchmarks and tests, and as a safety net for loops that
+ * should always finish within a known number of polls.
+ */
+class iteration_timeout
+{
+public:
+  /**
+   * @ingroup TimeoutUtil
+   * @brief Create an iteration timeout
+   *
+   * @param p_iterations - number of checks that succeed before the timeout
+   * expires. Zero expires on the first check.
+   */
+  constexpr explicit iteration_timeout(std::uint64_t p_iterations)
+    : m_remaining(p_iterations)
+  {
+  }
+
+  /**
+   * @ingroup TimeoutUtil
+   * @brief Call this object to check if it has timed out.
+   *
+   * @return status - success or failure
+   * @throws std::errc::timed_out - if the iteration budget has been used up
+   */
+  status operator()()
+  {
+    if (m_remaining == 0) {
+      return hal::new_error(std::errc::timed_out);
+    }
+    m_remaining--;
+    return success();
+  }
+
+  /**
+   * @ingroup TimeoutUtil
+   * @brief Get the number of checks left before the timeout expires
+   *
+   * @return constexpr std::uint64_t - remaining iterations
+   */
+  [[nodiscard]] constexpr std::uint64_t remaining() const
+  {
+    return m_remaining;
+  }
+
+private:
+  std::uint64_t m_remaining;
+};
+
+/**
+ * @ingroup TimeoutUtil
+ * @brief Timeout adaptor that only checks the wrapped timeout every N calls
+ *
+ * Checking a steady_clock_timeout reads the clock on every call, which can
+ * cost more than the work being polled. This adaptor forwards one check out of
+ * every interval and reports success for the others. Once the wrapped timeout
+ * has expired the adaptor keeps reporting the error.
+ *
+ * The worst case overshoot is interval - 1 extra calls after the wrapped
+ * timeout expires, plus however long those calls take.
+ *
+ * @tparam Timeout - timeout type to wrap
+ */
+template<timeout Timeout>
+class amortized_timeout
+{
+public:
+  /**
+   * @ingroup TimeoutUtil
+   * @brief Wrap a timeout
+   *
+   * @param p_timeout - timeout to check every p_interval calls
+   * @param p_interval - number of calls per check of p_timeout. Zero is
+   * treated as one, which checks on every call.
+   */
+  constexpr amortized_timeout(Timeout p_timeout, std::uint32_t p_interval)
+    : m_timeout(std::move(p_timeout))
+    , m_interval(p_interval == 0 ? 1 : p_interval)
+  {
+  }
+
+  /**
+   * @ingroup TimeoutUtil
+   * @brief Call this object to check if it has timed out.
+   *
+   * @return status - success or failure
+   * @throws std::errc::timed_out - if the wrapped timeout has expired. The
+   * first error from the wrapped timeout is passed through as is.
+   */
+  status operator()()
+  {
+    if (m_expired) {
+      return hal::new_error(std::errc::timed_out);
+    }
+
+    m_calls++;
+    if (m_calls < m_interval) {
+      return success();
+    }
+    m_calls = 0;
+
+    auto timeout_status = m_timeout();
+    m_expired = !timeout_status;
+    return timeout_status;
+  }
+
+private:
+  Timeout m_timeout;
+  std::uint32_t m_interval;
+  std::uint32_t m_calls = 0;
+  bool m_expired = false;
+};
+
+/**
+ * @ingroup TimeoutUtil
+ * @brief Check a timeout only every N calls
+ *
+ *     auto timeout = hal::amortize(hal::create_timeout(clock, 10ms), 64);
+ *     HAL_CHECK(hal::try_until(worker, timeout));
+ *
+ * @param p_timeout - timeout to wrap
+ * @param p_interval - number of calls per check of p_timeout
+ * @return amortized_timeout - timeout that checks p_timeout every p_interval
+ * calls
+ */
+template<timeout Timeout>
+constexpr auto amortize(Timeout p_timeout, std::uint32_t p_interval)
+{
+  return amortized_timeout<Timeout>(std::move(p_timeout), p_interval);
+}
+
+/**
+ * @ingroup TimeoutUtil
+ * @brief Combine timeouts into one that expires as soon as any of them does
+ *
+ * Timeouts are checked in order and checking stops at the first one that
+ * reports an error, whose error is returned. Put the cheapest timeout first.
+ *
+ * To combine hal::deadline objects use `hal::earliest()` instead, which
+ * collapses them into a single deadline that reads the clock once per check.
+ *
+ * @param p_timeouts - timeouts to combine
+ * @return auto - timeout that expires when any of p_timeouts expires
+ */
+template<timeout... Timeouts>
+constexpr auto any_of(Timeouts... p_timeouts)
+{
+  return [... timeouts = std::move(p_timeouts)]() mutable -> status {
+    status combined_status{};
+    // Short circuits on the first timeout that reports an error
+    (void)((combined_status = timeouts(), bool{ combined_status }) && ...);
+    return combined_status;
+  };
+}
+
+/**
+ * @ingroup TimeoutUtil
+ * @brief Combine timeouts into one that expires once all of them have
+ *
+ * Each timeout is checked until it first reports an error and is skipped from
+ * then on. Useful for operations that must wait out several independent
+ * minimum times.
+ *
+ * @param p_timeouts - timeouts to combine
+ * @return auto - timeout that expires when every one of p_timeouts has expired
+ */
+template<timeout... Timeouts>
+constexpr auto all_of(Timeouts... p_timeouts)
+{
+  return [... timeouts = std::move(p_timeouts),
+          expired = std::array<bool, sizeof...(Timeouts)>{}]() mutable
+         -> status {
+    size_t index = 0;
+    bool all_expired = true;
+    auto check = [&](auto& p_timeout) {
+      if (!expired[index]) {
+        expired[index] = !p_timeout();
+      }
+      all_expired = expired[index] && all_expired;
+      index++;
+    };
+
+    (check(timeouts), ...);
+    if (all_expired) {
+      return hal::new_error(std::errc::timed_out);
+    }
+    return success();
+  };
+}
 }  // namespace hal
@@ -0,0 +1,464 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <libhal/functional.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "steady_clock.hpp"
+
+/**
+ * @defgroup TimerWheel Timer Wheel
+ *
+ */
+
+namespace hal {
+/**
+ * @ingroup TimerWheel
+ * @brief Hierarchical timing wheel for large numbers of software timers
+ *
+ * Time is divided into wheel ticks of a fixed resolution. Level 0 has one slot
+ * per wheel tick, and each level above it has slots that are SlotsPerLevel
+ * times wider than the level below. A timer is placed in the lowest level
+ * that can hold its expiry. When time reaches the start of a higher level slot,
+ * the timers in that slot are moved down a level, which is called a cascade.
+ *
+ * - Scheduling and cancelling a timer is O(1)
+ * - Each timer is cascaded at most once per level before it expires
+ * - `poll()` skips over empty level 0 slots using an occupancy bitmap
+ *
+ * Timers are intrusive nodes owned by the caller, so the wheel never
+ * allocates. A timer cancels itself when destroyed.
+ *
+ * Timers with expiries beyond the range of the top level are parked in the
+ * top level and rescheduled as time moves closer to their expiry. The range
+ * is resolution * SlotsPerLevel^Levels.
+ *
+ *     hal::timer_wheel<4, 64> wheel(clock, 1ms);
+ *     hal::timer_wheel<4, 64>::timer retransmit([&]() { resend(); });
+ *     wheel.schedule(retransmit, 250ms);
+ *     while (true) {
+ *       wheel.poll();
+ *     }
+ *
+ * @tparam Levels - number of levels in the wheel
+ * @tparam SlotsPerLevel - number of slots in each level. Must be a power of two
+ * between 2 and 64.
+ */
+template<size_t Levels, size_t SlotsPerLevel>
+class timer_wheel
+{
+public:
+  static_assert(Levels >= 1, "timer_wheel requires at least one level");
+  static_assert(std::has_single_bit(SlotsPerLevel) && SlotsPerLevel >= 2 &&
+                  SlotsPerLevel <= 64,
+                "SlotsPerLevel must be a power of two between 2 and 64");
+  static_assert(Levels * std::countr_zero(SlotsPerLevel) < 64,
+                "The range of the wheel must fit within 64 bits of ticks");
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Timer that can be scheduled on the wheel
+   *
+   * Timers cannot be copied or moved while they may be scheduled, as the wheel
+   * refers to them by address.
+   */
+  class timer
+  {
+  public:
+    friend class timer_wheel;
+
+    /**
+     * @ingroup TimerWheel
+     * @brief Construct a new timer
+     *
+     * @param p_handler - called from `timer_wheel::poll()` when the timer
+     * expires. The handler may schedule or cancel any timer, including this
+     * one.
+     */
+    explicit timer(hal::callback<void()> p_handler)
+      : m_handler(std::move(p_handler))
+    {
+    }
+
+    timer(const timer&) = delete;
+    timer& operator=(const timer&) = delete;
+    timer(timer&&) = delete;
+    timer& operator=(timer&&) = delete;
+
+    /**
+     * @ingroup TimerWheel
+     * @brief Cancel the timer if it is scheduled
+     *
+     */
+    ~timer()
+    {
+      cancel();
+    }
+
+    /**
+     * @ingroup TimerWheel
+     * @brief Remove the timer from its wheel without calling the handler
+     *
+     * Does nothing if the timer is not scheduled.
+     */
+    void cancel()
+    {
+      if (m_wheel != nullptr) {
+        m_wheel->unlink(*this);
+      }
+    }
+
+    /**
+     * @ingroup TimerWheel
+     * @brief Determine if the timer is scheduled
+     *
+     * @return true - the timer is scheduled and has not expired or been
+     * cancelled
+     */
+    [[nodiscard]] bool active() const
+    {
+      return m_wheel != nullptr;
+    }
+
+    /**
+     * @ingroup TimerWheel
+     * @brief Get the wheel tick at which the timer expires
+     *
+     * @return std::uint64_t - expiry in wheel ticks, only meaningful while
+     * active
+     */
+    [[nodiscard]] std::uint64_t expiry() const
+    {
+      return m_expiry;
+    }
+
+  private:
+    hal::callback<void()> m_handler;
+    timer_wheel* m_wheel = nullptr;
+    timer* m_next = nullptr;
+    // Address of the pointer that points to this timer, either a slot head or
+    // the m_next of the previous timer. Allows O(1) removal.
+    timer** m_link = nullptr;
+    std::uint64_t m_expiry = 0;
+    std::uint8_t m_level = 0;
+    std::uint8_t m_slot = 0;
+  };
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Construct a timer wheel
+   *
+   * @param p_steady_clock - clock that drives the wheel. Must outlive the
+   * wheel.
+   * @param p_resolution - duration of one wheel tick. Timers expire on wheel
+   * tick boundaries. Rounded down to whole clock ticks, minimum one.
+   */
+  timer_wheel(hal::steady_clock& p_steady_clock,
+              hal::time_duration p_resolution)
+    : m_steady_clock(&p_steady_clock)
+    , m_converter(p_steady_clock)
+  {
+    const auto resolution = m_converter.to_ticks(p_resolution);
+    m_resolution = (resolution == 0) ? 1 : resolution;
+    m_now = m_steady_clock->uptime().ticks / m_resolution;
+  }
+
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator=(const timer_wheel&) = delete;
+  timer_wheel(timer_wheel&&) = delete;
+  timer_wheel& operator=(timer_wheel&&) = delete;
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Cancel all remaining timers
+   *
+   */
+  ~timer_wheel()
+  {
+    for (auto& level : m_slots) {
+      for (auto* head : level) {
+        while (head != nullptr) {
+          auto* next = head->m_next;
+          head->m_wheel = nullptr;
+          head = next;
+        }
+      }
+    }
+  }
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Schedule a timer to expire after a delay
+   *
+   * If the timer is already scheduled, it is rescheduled. The timer will not
+   * expire before the delay has elapsed, and expires on the first call to
+   * `poll()` after that.
+   *
+   * @param p_timer - timer to schedule
+   * @param p_delay - minimum time until the timer expires
+   */
+  void schedule(timer& p_timer, hal::time_duration p_delay)
+  {
+    const auto deadline =
+      m_steady_clock->uptime().ticks + m_converter.to_ticks(p_delay);
+    schedule_at(p_timer, deadline);
+  }
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Schedule a timer to expire at an uptime
+   *
+   * @param p_timer - timer to schedule
+   * @param p_deadline - steady clock uptime in ticks at which to expire. The
+   * timer expires on the first call to `poll()` at or after this uptime.
+   */
+  void schedule_at(timer& p_timer, std::uint64_t p_deadline)
+  {
+    p_timer.cancel();
+    // Round up to the next wheel tick so the timer never expires early
+    const auto expiry = (p_deadline + m_resolution - 1) / m_resolution;
+    p_timer.m_expiry = (expiry > m_now) ? expiry : m_now;
+    p_timer.m_wheel = this;
+    m_size++;
+    place(p_timer);
+  }
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Advance the wheel to the current uptime and run expired timers
+   *
+   * Must not be called from within a timer handler.
+   *
+   * @return size_t - number of timers that expired
+   */
+  size_t poll()
+  {
+    return advance(m_steady_clock->uptime().ticks / m_resolution);
+  }
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Get the number of scheduled timers
+   *
+   * @return size_t - number of scheduled timers
+   */
+  [[nodiscard]] size_t size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Get the current wheel tick
+   *
+   * @return std::uint64_t - the wheel tick as of the last `poll()`
+   */
+  [[nodiscard]] std::uint64_t now() const
+  {
+    return m_now;
+  }
+
+  /**
+   * @ingroup TimerWheel
+   * @brief Get the number of steady clock ticks in one wheel tick
+   *
+   * @return std::uint64_t - resolution in steady clock ticks
+   */
+  [[nodiscard]] std::uint64_t resolution() const
+  {
+    return m_resolution;
+  }
+
+private:
+  static constexpr size_t slot_bits = std::countr_zero(SlotsPerLevel);
+  static constexpr std::uint64_t slot_mask = SlotsPerLevel - 1;
+  // Marks timers that have been detached from their slot for processing
+  static constexpr std::uint8_t detached_level = 0xFF;
+
+  static constexpr size_t digit(std::uint64_t p_ticks, size_t p_level)
+  {
+    return (p_ticks >> (p_level * slot_bits)) & slot_mask;
+  }
+
+  void place(timer& p_timer)
+  {
+    // The level is the highest digit at which the expiry differs from now.
+    // Every lower level slot for the expiry is reached before the timer is
+    // due, so the timer is cascaded down one level at a time.
+    //
+    // Timers that are already due go in the current level 0 slot, which is
+    // expired right after cascading.
+    size_t level = 0;
+    size_t slot = digit(m_now, 0);
+
+    if (p_timer.m_expiry > m_now) {
+      const auto difference = p_timer.m_expiry ^ m_now;
+      level = (static_cast<size_t>(std::bit_width(difference)) - 1) / slot_bits;
+      slot = digit(p_timer.m_expiry, level);
+    }
+
+    if (level >= Levels) {
+      // Beyond the range of the wheel: park the timer in top level slot 0,
+      // which is next visited at the start of the next range, and place it
+      // again from there.
+      level = Levels - 1;
+      slot = 0;
+    }
+
+    auto*& head = m_slots[level][slot];
+    p_timer.m_level = static_cast<std::uint8_t>(level);
+    p_timer.m_slot = static_cast<std::uint8_t>(slot);
+    p_timer.m_next = head;
+    p_timer.m_link = &head;
+    if (head != nullptr) {
+      head->m_link = &p_timer.m_next;
+    }
+    head = &p_timer;
+    m_occupied[level] |= std::uint64_t{ 1 } << slot;
+  }
+
+  void unlink(timer& p_timer)
+  {
+    *p_timer.m_link = p_timer.m_next;
+    if (p_timer.m_next != nullptr) {
+      p_timer.m_next->m_link = p_timer.m_link;
+    }
+
+    if (p_timer.m_level != detached_level &&
+        m_slots[p_timer.m_level][p_timer.m_slot] == nullptr) {
+      m_occupied[p_timer.m_level] &= ~(std::uint64_t{ 1 } << p_timer.m_slot);
+    }
+
+    p_timer.m_wheel = nullptr;
+    p_timer.m_next = nullptr;
+    p_timer.m_link = nullptr;
+    m_size--;
+  }
+
+  /// Move a slot's timers to a local list so that handlers and re-placement
+  /// can modify the slot while it is processed.
+  timer* detach(size_t p_level, size_t p_slot, timer*& p_list)
+  {
+    auto*& head = m_slots[p_level][p_slot];
+    p_list = head;
+    head = nullptr;
+    m_occupied[p_level] &= ~(std::uint64_t{ 1 } << p_slot);
+
+    if (p_list != nullptr) {
+      p_list->m_link = &p_list;
+    }
+    for (auto* node = p_list; node != nullptr; node = node->m_next) {
+      node->m_level = detached_level;
+    }
+    return p_list;
+  }
+
+  void cascade()
+  {
+    // A level cascades when every digit below it has wrapped to zero
+    size_t top = 1;
+    while (top + 1 < Levels && digit(m_now, top) == 0) {
+      top++;
+    }
+
+    for (size_t level = top; level >= 1; level--) {
+      timer* list = nullptr;
+      detach(level, digit(m_now, level), list);
+      while (list != nullptr) {
+        auto& node = *list;
+        list = node.m_next;
+        if (list != nullptr) {
+          list->m_link = &list;
+        }
+        place(node);
+      }
+    }
+  }
+
+  size_t expire(size_t p_slot)
+  {
+    timer* list = nullptr;
+    detach(0, p_slot, list);
+
+    size_t expired = 0;
+    while (list != nullptr) {
+      auto& node = *list;
+      if (node.m_expiry > m_now) {
+        // Parked beyond the range of a single level wheel
+        list = node.m_next;
+        if (list != nullptr) {
+          list->m_link = &list;
+        }
+        place(node);
+        continue;
+      }
+      unlink(node);
+      expired++;
+      // The handler is run last, as it may reschedule or destroy the timer
+      node.m_handler();
+    }
+    return expired;
+  }
+
+  size_t advance(std::uint64_t p_target)
+  {
+    size_t expired = 0;
+
+    // Timers scheduled for a tick that has already been processed
+    if (m_occupied[0] & (std::uint64_t{ 1 } << digit(m_now, 0))) {
+      expired += expire(digit(m_now, 0));
+    }
+
+    while (m_now < p_target) {
+      // Jump to the next occupied level 0 slot in this rotation, otherwise to
+      // the start of the next rotation where the upper levels cascade.
+      const auto index = digit(m_now, 0);
+      const auto later = (m_occupied[0] >> index) >> 1;
+      const auto next = (later != 0)
+                          ? m_now + 1 + std::countr_zero(later)
+                          : (m_now | slot_mask) + 1;
+
+      if (next > p_target) {
+        m_now = p_target;
+        break;
+      }
+
+      m_now = next;
+      if (Levels > 1 && digit(m_now, 0) == 0) {
+        cascade();
+      }
+      expired += expire(digit(m_now, 0));
+    }
+
+    return expired;
+  }
+
+  hal::steady_clock* m_steady_clock;
+  tick_converter m_converter;
+  std::uint64_t m_resolution = 1;
+  std::uint64_t m_now = 0;
+  size_t m_size = 0;
+  std::array<std::uint64_t, Levels> m_occupied{};
+  std::array<std::array<timer*, SlotsPerLevel>, Levels> m_slots{};
+};
+}  // namespace hal
@@ -0,0 +1,313 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include <libhal/functional.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "steady_clock.hpp"
+
+/**
+ * @defgroup VirtualSteadyClock Virtual Steady Clock
+ *
+ */
+
+namespace hal {
+/**
+ * @ingroup VirtualSteadyClock
+ * @brief steady_clock whose time only moves when the program moves it
+ *
+ * Time advances by a fixed step on every uptime() call, by explicit calls to
+ * advance(), or by jumping straight to the next scheduled event. Code that
+ * polls the clock, such as `hal::delay`, `hal::try_until` and
+ * `hal::steady_clock_timeout`, then runs as fast as the host allows and
+ * behaves the same on every run. A 24 hour soak test of a protocol takes as
+ * long as the work done in it, not 24 hours.
+ *
+ * Fake peripherals schedule events to model things that happen at a point in
+ * time, such as a reply arriving over serial. Events fire in time order while
+ * the clock advances, and see now() equal to their scheduled time:
+ *
+ *     hal::virtual_steady_clock clock(1'000'000.0f);
+ *     hal::virtual_steady_clock::event reply([&]() { serial.inject("OK"); });
+ *     clock.skip_to_events(true);
+ *     clock.schedule(reply, 250ms);
+ *     // The first uptime() call jumps straight to 250ms and fires the reply
+ *     HAL_CHECK(hal::try_until(read_ok, hal::create_timeout(clock, 1s)));
+ *
+ * Hooks inject the imperfections of real clocks: set_jitter() offsets each
+ * reading and set_counter_bits() makes the reported uptime wrap like a narrow
+ * hardware counter.
+ */
+class virtual_steady_clock : public hal::steady_clock
+{
+public:
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Callback that runs when the virtual time reaches a point
+   *
+   * Events are intrusive nodes owned by the caller. They cannot be copied or
+   * moved and remove themselves from the clock when destroyed.
+   */
+  class event
+  {
+  public:
+    friend class virtual_steady_clock;
+
+    /**
+     * @ingroup VirtualSteadyClock
+     * @brief Construct a new event
+     *
+     * @param p_handler - called when the event fires. May schedule events,
+     * including this one.
+     */
+    explicit event(hal::callback<void()> p_handler)
+      : m_handler(std::move(p_handler))
+    {
+    }
+
+    event(const event&) = delete;
+    event& operator=(const event&) = delete;
+    event(event&&) = delete;
+    event& operator=(event&&) = delete;
+
+    /**
+     * @ingroup VirtualSteadyClock
+     * @brief Remove the event from its clock
+     *
+     */
+    ~event()
+    {
+      cancel();
+    }
+
+    /**
+     * @ingroup VirtualSteadyClock
+     * @brief Remove the event from its clock without firing it
+     *
+     * Does nothing if the event is not scheduled.
+     */
+    void cancel();
+
+    /**
+     * @ingroup VirtualSteadyClock
+     * @brief Determine if the event is waiting to fire
+     *
+     * @return true - the event is scheduled
+     * @return false - the event has fired, was cancelled or was never scheduled
+     */
+    [[nodiscard]] bool scheduled() const
+    {
+      return m_clock != nullptr;
+    }
+
+  private:
+    hal::callback<void()> m_handler;
+    virtual_steady_clock* m_clock = nullptr;
+    event* m_next = nullptr;
+    std::uint64_t m_ticks = 0;
+  };
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Construct a virtual steady clock
+   *
+   * @param p_frequency - frequency reported by the clock
+   * @param p_start - initial uptime in ticks. Start close to the 64-bit limit
+   * to test how code copes with the uptime overflowing. Time wraps around
+   * past the limit, and events are ordered by their distance from now(), so
+   * they must be scheduled within 2^63 ticks of it.
+   */
+  explicit virtual_steady_clock(hal::hertz p_frequency,
+                                std::uint64_t p_start = 0);
+
+  virtual_steady_clock(const virtual_steady_clock&) = delete;
+  virtual_steady_clock& operator=(const virtual_steady_clock&) = delete;
+  virtual_steady_clock(virtual_steady_clock&&) = delete;
+  virtual_steady_clock& operator=(virtual_steady_clock&&) = delete;
+  ~virtual_steady_clock() override;
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Set how far time advances on each uptime() call
+   *
+   * Each call returns the current time and then advances it, so the first
+   * reading is the start time.
+   *
+   * @param p_ticks - ticks to advance after each reading. Defaults to 0.
+   */
+  void set_step(std::uint64_t p_ticks)
+  {
+    m_step = p_ticks;
+  }
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Set how far time advances on each uptime() call
+   *
+   * @param p_duration - time to advance after each reading
+   */
+  void set_step(hal::time_duration p_duration)
+  {
+    m_step = m_converter.to_ticks(p_duration);
+  }
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Let uptime() jump to the next scheduled event
+   *
+   * When enabled, each uptime() call advances to the next scheduled event if
+   * that is further away than the step, so code waiting on an event does not
+   * spin through the time in between.
+   *
+   * @param p_enable - true to jump to events
+   */
+  void skip_to_events(bool p_enable)
+  {
+    m_skip_to_events = p_enable;
+  }
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Offset every reading by a value chosen by a callback
+   *
+   * Readings stay monotonic: an offset that would make the uptime go backwards
+   * reports the previous reading again. Pass an empty callback to remove the
+   * jitter.
+   *
+   * @param p_jitter - returns the offset in ticks to add to the next reading
+   */
+  void set_jitter(hal::callback<std::int64_t()> p_jitter)
+  {
+    m_jitter = std::move(p_jitter);
+  }
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Report the uptime as a counter of limited width
+   *
+   * Emulates a hardware counter that has not been extended to 64 bits, to
+   * test overflow handling such as `hal::overflow_counter`.
+   *
+   * @param p_bits - width of the reported uptime, 1 to 64. 64 disables
+   * wrapping.
+   * @param p_on_overflow - called from uptime() each time a reading has
+   * wrapped since the previous one, the way an overflow interrupt would fire
+   */
+  void set_counter_bits(std::uint8_t p_bits,
+                        hal::callback<void()> p_on_overflow = {});
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Schedule an event at an absolute uptime
+   *
+   * Reschedules the event if it is already scheduled. An event scheduled at
+   * or before now() fires on the next advance.
+   *
+   * @param p_event - event to fire
+   * @param p_ticks - uptime at which to fire it
+   */
+  void schedule_at(event& p_event, std::uint64_t p_ticks);
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Schedule an event a duration from now
+   *
+   * @param p_event - event to fire
+   * @param p_delay - time from now() until the event fires
+   */
+  void schedule(event& p_event, hal::time_duration p_delay)
+  {
+    schedule_at(p_event, m_now + m_converter.to_ticks(p_delay));
+  }
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Advance time, firing the events that fall within it
+   *
+   * @param p_ticks - ticks to advance
+   */
+  void advance(std::uint64_t p_ticks)
+  {
+    advance_by(p_ticks);
+  }
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Advance time, firing the events that fall within it
+   *
+   * @param p_duration - time to advance
+   */
+  void advance(hal::time_duration p_duration)
+  {
+    advance(m_converter.to_ticks(p_duration));
+  }
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Advance time to the next scheduled event and fire it
+   *
+   * @return true - an event fired
+   * @return false - no events were scheduled
+   */
+  bool run_next_event();
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Get the virtual time without advancing it
+   *
+   * @return std::uint64_t - uptime in ticks, without jitter or wrapping
+   */
+  [[nodiscard]] std::uint64_t now() const
+  {
+    return m_now;
+  }
+
+  /**
+   * @ingroup VirtualSteadyClock
+   * @brief Get the number of times uptime() has been called
+   *
+   * @return std::uint64_t - number of readings
+   */
+  [[nodiscard]] std::uint64_t readings() const
+  {
+    return m_readings;
+  }
+
+private:
+  frequency_t driver_frequency() override;
+  uptime_t driver_uptime() override;
+  [[nodiscard]] std::int64_t ticks_until(std::uint64_t p_ticks) const;
+  [[nodiscard]] std::uint64_t ticks_due(const event& p_event) const;
+  void advance_by(std::uint64_t p_ticks);
+  void remove(event& p_event);
+
+  tick_converter m_converter;
+  hal::hertz m_frequency;
+  hal::callback<std::int64_t()> m_jitter{};
+  hal::callback<void()> m_on_overflow{};
+  event* m_events = nullptr;
+  std::uint64_t m_now;
+  std::uint64_t m_last_reading;
+  std::uint64_t m_step = 0;
+  std::uint64_t m_readings = 0;
+  std::uint8_t m_counter_bits = 64;
+  bool m_skip_to_events = false;
+};
+}  // namespace hal
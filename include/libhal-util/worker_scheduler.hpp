@@ -0,0 +1,333 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <libhal/error.hpp>
+#include <libhal/functional.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/timeout.hpp>
+#include <libhal/units.hpp>
+
+#include "steady_clock.hpp"
+
+/**
+ * @defgroup WorkerScheduler Worker Scheduler
+ *
+ */
+
+namespace hal {
+/**
+ * @ingroup WorkerScheduler
+ * @brief Cooperative round-robin scheduler for worker callables
+ *
+ * `hal::try_until` drives a single worker until it terminates, which starves
+ * every other worker in the meantime. The scheduler instead calls each of its
+ * workers once per round, so a stream pipeline, a `hal::read_into` and a
+ * `hal::skip_past` can all make progress from a single main loop:
+ *
+ *     hal::worker_scheduler scheduler;
+ *     hal::worker_scheduler::task reader([&]() {
+ *       auto state = read_worker();
+ *       if (bytes_were_consumed()) {
+ *         reader.mark_progress();
+ *       }
+ *       return state;
+ *     });
+ *     reader.set_deadline(clock, 100ms);
+ *     reader.on_complete([](hal::result<hal::work_state> p_result) { ... });
+ *     scheduler.add(reader);
+ *
+ *     while (true) {
+ *       scheduler.run_once();
+ *       if (scheduler.idle()) {
+ *         sleep_until_interrupt();
+ *       }
+ *     }
+ *
+ * Within a round, tasks run in order of descending priority and tasks of equal
+ * priority run in the order they were added. Every task runs once per round
+ * regardless of priority, so a busy high priority task cannot starve the
+ * others.
+ *
+ * Tasks are intrusive nodes owned by the caller, so the scheduler never
+ * allocates. A task removes itself from the scheduler when destroyed.
+ */
+class worker_scheduler
+{
+public:
+  /**
+   * @ingroup WorkerScheduler
+   * @brief Unit of work that can be added to a scheduler
+   *
+   * Tasks cannot be copied or moved, as the scheduler refers to them by
+   * address.
+   */
+  class task
+  {
+  public:
+    friend class worker_scheduler;
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Construct a new task
+     *
+     * @param p_worker - worker to call once per round until it returns a
+     * terminal state or an error
+     * @param p_priority - tasks with a higher priority run earlier in a round
+     */
+    explicit task(hal::callback<result<work_state>()> p_worker,
+                  std::uint8_t p_priority = 0)
+      : m_worker(std::move(p_worker))
+      , m_priority(p_priority)
+    {
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    task(task&&) = delete;
+    task& operator=(task&&) = delete;
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Remove the task from its scheduler
+     *
+     */
+    ~task()
+    {
+      cancel();
+    }
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Set the function called when the task leaves the scheduler
+     *
+     * The callback receives the terminal state of the worker, the error
+     * returned by the worker, or the error returned by the deadline. It is not
+     * called when the task is cancelled. The callback may add the task to a
+     * scheduler again.
+     *
+     * @param p_on_complete - completion callback
+     */
+    void on_complete(hal::callback<void(result<work_state>)> p_on_complete)
+    {
+      m_on_complete = std::move(p_on_complete);
+    }
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Limit how long the task may run
+     *
+     * The deadline is checked after each call to the worker that returns
+     * `work_state::in_progress`. If the deadline returns an error, the task is
+     * removed and the error is passed to the completion callback.
+     *
+     * @param p_deadline - timeout callable, such as a `steady_clock_timeout`
+     */
+    void set_deadline(hal::callback<status()> p_deadline)
+    {
+      m_deadline = std::move(p_deadline);
+    }
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Limit how long the task may run, starting now
+     *
+     * @param p_steady_clock - clock to measure the deadline against
+     * @param p_duration - amount of time the task may run
+     */
+    void set_deadline(hal::steady_clock& p_steady_clock,
+                      hal::time_duration p_duration)
+    {
+      set_deadline(create_timeout(p_steady_clock, p_duration));
+    }
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Remove the deadline from the task
+     *
+     */
+    void clear_deadline()
+    {
+      m_deadline = nullptr;
+    }
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Report that the worker made progress without finishing
+     *
+     * Called by the worker, for example after consuming bytes while more
+     * input is buffered. Keeps the round it is called in from being
+     * considered idle, so the application does not sleep with work pending.
+     */
+    void mark_progress()
+    {
+      m_progressed = true;
+    }
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Remove the task from its scheduler without completing it
+     *
+     * Does nothing if the task is not in a scheduler.
+     */
+    void cancel()
+    {
+      if (m_scheduler != nullptr) {
+        m_scheduler->remove(*this);
+      }
+    }
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Determine if the task is in a scheduler
+     *
+     * @return true - the task is in a scheduler and has not completed or been
+     * cancelled
+     */
+    [[nodiscard]] bool active() const
+    {
+      return m_scheduler != nullptr;
+    }
+
+    /**
+     * @ingroup WorkerScheduler
+     * @brief Get the priority of the task
+     *
+     * @return std::uint8_t - priority of the task
+     */
+    [[nodiscard]] std::uint8_t priority() const
+    {
+      return m_priority;
+    }
+
+  private:
+    hal::callback<result<work_state>()> m_worker;
+    hal::callback<void(result<work_state>)> m_on_complete;
+    hal::callback<status()> m_deadline;
+    worker_scheduler* m_scheduler = nullptr;
+    task* m_next = nullptr;
+    // Address of the pointer that points to this task, either the head of the
+    // scheduler or the m_next of the previous task. Allows O(1) removal.
+    task** m_link = nullptr;
+    std::uint8_t m_priority = 0;
+    bool m_progressed = false;
+  };
+
+  worker_scheduler() = default;
+  worker_scheduler(const worker_scheduler&) = delete;
+  worker_scheduler& operator=(const worker_scheduler&) = delete;
+  worker_scheduler(worker_scheduler&&) = delete;
+  worker_scheduler& operator=(worker_scheduler&&) = delete;
+
+  /**
+   * @ingroup WorkerScheduler
+   * @brief Remove all remaining tasks without completing them
+   *
+   */
+  ~worker_scheduler();
+
+  /**
+   * @ingroup WorkerScheduler
+   * @brief Add a task to the scheduler
+   *
+   * If the task is in a scheduler already, it is moved to this one. A task
+   * added while a round is running may not run until the next round.
+   *
+   * @param p_task - task to add
+   */
+  void add(task& p_task);
+
+  /**
+   * @ingroup WorkerScheduler
+   * @brief Run every task once
+   *
+   * Tasks that terminate, fail, or pass their deadline are removed and their
+   * completion callback is called. Must not be called from within a worker or
+   * completion callback.
+   *
+   * @return size_t - number of tasks that completed during the round
+   */
+  size_t run_once();
+
+  /**
+   * @ingroup WorkerScheduler
+   * @brief Run rounds until no task remains or the scheduler becomes idle
+   *
+   * Keeps running while any task completes or marks progress in a round.
+   *
+   * @return size_t - number of tasks that completed
+   */
+  size_t run_until_idle();
+
+  /**
+   * @ingroup WorkerScheduler
+   * @brief Mark that something happened that a worker may be waiting for
+   *
+   * Safe to call from an interrupt service routine, such as a serial receive
+   * or pin interrupt. Prevents the next round from being considered idle.
+   */
+  void notify()
+  {
+    m_notified.store(true, std::memory_order_release);
+  }
+
+  /**
+   * @ingroup WorkerScheduler
+   * @brief Determine if the application can sleep
+   *
+   * The scheduler is idle when it has no tasks, or when in the last round no
+   * task completed or called `task::mark_progress()`, and `notify()` was not
+   * called since the round started. Idle means every worker is waiting on
+   * something outside of the scheduler, such as an interrupt, provided that
+   * workers mark the rounds in which they make partial progress.
+   *
+   * @return true - calling `run_once()` again is unlikely to make progress
+   * until an interrupt occurs
+   */
+  [[nodiscard]] bool idle() const
+  {
+    return m_head == nullptr ||
+           (m_idle && !m_notified.load(std::memory_order_acquire));
+  }
+
+  /**
+   * @ingroup WorkerScheduler
+   * @brief Get the number of tasks in the scheduler
+   *
+   * @return size_t - number of tasks
+   */
+  [[nodiscard]] size_t size() const
+  {
+    return m_size;
+  }
+
+private:
+  void remove(task& p_task);
+  void complete(task& p_task, result<work_state> p_result);
+
+  task* m_head = nullptr;
+  // Next task to run in the current round. Updated when that task is removed
+  // so that workers and callbacks may remove any task.
+  task* m_cursor = nullptr;
+  size_t m_size = 0;
+  bool m_idle = false;
+  std::atomic<bool> m_notified = false;
+};
+}  // namespace hal
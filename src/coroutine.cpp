@@ -0,0 +1,181 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/coroutine.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <system_error>
+
+#include <libhal/error.hpp>
+#include <libhal/units.hpp>
+
+namespace hal {
+namespace {
+coroutine_arena* active_arena = nullptr;
+}  // namespace
+
+coroutine_arena::coroutine_arena(std::span<hal::byte> p_memory)
+{
+  constexpr auto alignment = alignof(header);
+  const auto address = reinterpret_cast<std::uintptr_t>(p_memory.data());
+  const auto padding = (alignment - (address % alignment)) % alignment;
+
+  if (padding >= p_memory.size()) {
+    return;
+  }
+
+  auto aligned = p_memory.subspan(padding);
+  m_memory = aligned.first(aligned.size() - (aligned.size() % alignment));
+}
+
+void* coroutine_arena::allocate(size_t p_size) noexcept
+{
+  constexpr auto alignment = alignof(header);
+  const auto frame_size = (p_size + alignment - 1) / alignment * alignment;
+  const auto total = sizeof(header) + frame_size;
+
+  if (total > m_memory.size() - m_used) {
+    return nullptr;
+  }
+
+  auto* block = new (m_memory.data() + m_used) header{
+    .arena = this,
+    .previous = m_top,
+    .free = false,
+  };
+  m_top = block;
+  m_used += total;
+  m_peak = std::max(m_peak, m_used);
+  return block + 1;
+}
+
+void coroutine_arena::deallocate(void* p_frame) noexcept
+{
+  if (p_frame == nullptr) {
+    return;
+  }
+
+  auto* block = static_cast<header*>(p_frame) - 1;
+  auto& arena = *block->arena;
+  block->free = true;
+
+  // Release the top frame and any frames below it that were freed out of
+  // order
+  while (arena.m_top != nullptr && arena.m_top->free) {
+    arena.m_used = static_cast<size_t>(
+      reinterpret_cast<hal::byte*>(arena.m_top) - arena.m_memory.data());
+    arena.m_top = arena.m_top->previous;
+  }
+}
+
+coroutine_arena* coroutine_arena::active() noexcept
+{
+  return active_arena;
+}
+
+coroutine_arena* coroutine_arena::make_active(
+  coroutine_arena* p_arena) noexcept
+{
+  return std::exchange(active_arena, p_arena);
+}
+
+task_promise_base::~task_promise_base()
+{
+  if (m_executor != nullptr) {
+    m_executor->remove(*this);
+  }
+}
+
+coroutine_executor::~coroutine_executor()
+{
+  while (m_head != nullptr) {
+    auto* next = m_head->m_next;
+    m_head->m_executor = nullptr;
+    m_head->m_next = nullptr;
+    m_head->m_link = nullptr;
+    m_head = next;
+  }
+}
+
+status coroutine_executor::add(task_promise_base& p_root)
+{
+  if (p_root.m_started || p_root.m_executor != nullptr ||
+      p_root.m_continuation) {
+    return new_error(std::errc::invalid_argument);
+  }
+
+  // Append so that tasks start in the order they were spawned
+  auto** link = &m_head;
+  while (*link != nullptr) {
+    link = &(*link)->m_next;
+  }
+
+  p_root.m_next = nullptr;
+  p_root.m_link = link;
+  *link = &p_root;
+  p_root.m_executor = this;
+  m_size++;
+  return success();
+}
+
+void coroutine_executor::remove(task_promise_base& p_root)
+{
+  if (m_cursor == &p_root) {
+    m_cursor = p_root.m_next;
+  }
+
+  *p_root.m_link = p_root.m_next;
+  if (p_root.m_next != nullptr) {
+    p_root.m_next->m_link = p_root.m_link;
+  }
+
+  p_root.m_executor = nullptr;
+  p_root.m_next = nullptr;
+  p_root.m_link = nullptr;
+  m_size--;
+}
+
+size_t coroutine_executor::run_once()
+{
+  size_t finished = 0;
+  auto* previous_arena = coroutine_arena::make_active(m_arena);
+  m_cursor = m_head;
+
+  while (m_cursor != nullptr) {
+    auto& root = *m_cursor;
+    m_cursor = root.m_next;
+
+    if (!root.m_started) {
+      root.m_started = true;
+      root.m_handle.resume();
+    } else if (root.m_poll != nullptr && root.m_poll(root.m_poll_context)) {
+      auto waiting = std::exchange(root.m_waiting, nullptr);
+      root.m_poll = nullptr;
+      root.m_poll_context = nullptr;
+      waiting.resume();
+    }
+
+    if (root.m_handle.done()) {
+      remove(root);
+      finished++;
+    }
+  }
+
+  coroutine_arena::make_active(previous_arena);
+  return finished;
+}
+}  // namespace hal
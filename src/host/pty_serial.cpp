@@ -0,0 +1,278 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/host/pty_serial.hpp>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <system_error>
+#include <utility>
+
+namespace hal {
+namespace {
+/// Size of the N_TTY receive buffer, which the kernel does not report
+constexpr size_t tty_buffer_size = 4096;
+
+/// Errors from system calls carry their errno as a std::errc
+auto errno_error()
+{
+  return hal::new_error(static_cast<std::errc>(errno));
+}
+
+status make_raw(int p_fd)
+{
+  termios attributes{};
+  if (::tcgetattr(p_fd, &attributes) != 0) {
+    return errno_error();
+  }
+  ::cfmakeraw(&attributes);
+  if (::tcsetattr(p_fd, TCSANOW, &attributes) != 0) {
+    return errno_error();
+  }
+  return success();
+}
+
+result<int> make_epoll(int p_fd)
+{
+  const int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    return errno_error();
+  }
+
+  // Edge triggering is not used: every wait re-checks the current state
+  epoll_event event{ .events = EPOLLIN, .data = { .fd = p_fd } };
+  if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, p_fd, &event) != 0) {
+    auto error = errno_error();
+    ::close(epoll_fd);
+    return error;
+  }
+  return epoll_fd;
+}
+}  // namespace
+
+result<pty_serial> pty_serial::create()
+{
+  const int fd = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return errno_error();
+  }
+
+  pty_serial controller(fd, -1);
+  if (::grantpt(fd) != 0 || ::unlockpt(fd) != 0) {
+    return errno_error();
+  }
+  if (::ptsname_r(fd,
+                  controller.m_peer_path.data(),
+                  controller.m_peer_path.size()) != 0) {
+    return errno_error();
+  }
+
+  HAL_CHECK(make_raw(fd));
+  controller.m_epoll_fd = HAL_CHECK(make_epoll(fd));
+  return controller;
+}
+
+result<pty_serial> pty_serial::open_peer()
+{
+  if (m_peer_path[0] == '\0') {
+    return hal::new_error(std::errc::invalid_argument);
+  }
+
+  const int fd =
+    ::open(m_peer_path.data(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return errno_error();
+  }
+
+  pty_serial device(fd, -1);
+  HAL_CHECK(make_raw(fd));
+  device.m_epoll_fd = HAL_CHECK(make_epoll(fd));
+  return device;
+}
+
+std::string_view pty_serial::peer_path() const
+{
+  return m_peer_path.data();
+}
+
+result<bool> pty_serial::wait_readable(hal::time_duration p_timeout)
+{
+  using milliseconds = std::chrono::duration<int, std::milli>;
+  const auto timeout = std::chrono::duration_cast<milliseconds>(p_timeout);
+  return wait_for(EPOLLIN, std::max(timeout.count(), 0));
+}
+
+pty_serial::pty_serial(pty_serial&& p_other) noexcept
+  : m_fd(std::exchange(p_other.m_fd, -1))
+  , m_epoll_fd(std::exchange(p_other.m_epoll_fd, -1))
+  , m_peer_path(p_other.m_peer_path)
+{
+}
+
+pty_serial& pty_serial::operator=(pty_serial&& p_other) noexcept
+{
+  if (this != &p_other) {
+    close();
+    m_fd = std::exchange(p_other.m_fd, -1);
+    m_epoll_fd = std::exchange(p_other.m_epoll_fd, -1);
+    m_peer_path = p_other.m_peer_path;
+  }
+  return *this;
+}
+
+pty_serial::~pty_serial()
+{
+  close();
+}
+
+pty_serial::pty_serial(int p_fd, int p_epoll_fd)
+  : m_fd(p_fd)
+  , m_epoll_fd(p_epoll_fd)
+{
+}
+
+status pty_serial::driver_configure(const settings& p_settings)
+{
+  termios attributes{};
+  if (::tcgetattr(m_fd, &attributes) != 0) {
+    return errno_error();
+  }
+
+  // A pseudo-terminal carries bytes at memory speed, but the settings are
+  // still applied so that programs on the other end see them
+  const auto baud_rate = static_cast<speed_t>(p_settings.baud_rate);
+  if (::cfsetspeed(&attributes, baud_rate) != 0) {
+    return hal::new_error(std::errc::invalid_argument);
+  }
+
+  attributes.c_cflag &= ~static_cast<tcflag_t>(CSTOPB | PARENB | PARODD);
+  if (p_settings.stop == settings::stop_bits::two) {
+    attributes.c_cflag |= CSTOPB;
+  }
+  switch (p_settings.parity) {
+    case settings::parity::none:
+      break;
+    case settings::parity::odd:
+      attributes.c_cflag |= PARENB | PARODD;
+      break;
+    case settings::parity::even:
+      attributes.c_cflag |= PARENB;
+      break;
+    default:
+      // Mark and space parity are not portable termios options
+      return hal::new_error(std::errc::invalid_argument);
+  }
+
+  if (::tcsetattr(m_fd, TCSANOW, &attributes) != 0) {
+    return errno_error();
+  }
+  return success();
+}
+
+result<serial::write_t> pty_serial::driver_write(
+  std::span<const hal::byte> p_data)
+{
+  while (true) {
+    const auto written = ::write(m_fd, p_data.data(), p_data.size());
+    if (written >= 0) {
+      return write_t{ p_data.first(static_cast<size_t>(written)) };
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN) {
+      return errno_error();
+    }
+
+    // The kernel buffer is full. Wait for the other end to drain it, but not
+    // forever if nothing is reading.
+    constexpr int drain_timeout_ms = 1000;
+    if (!HAL_CHECK(wait_for(EPOLLOUT, drain_timeout_ms))) {
+      return hal::new_error(std::errc::timed_out);
+    }
+  }
+}
+
+result<serial::read_t> pty_serial::driver_read(std::span<hal::byte> p_data)
+{
+  auto received = ::read(m_fd, p_data.data(), p_data.size());
+  if (received < 0) {
+    // EIO means the other end is not open yet or was closed, which a serial
+    // port sees as nothing arriving
+    if (errno != EAGAIN && errno != EINTR && errno != EIO) {
+      return errno_error();
+    }
+    received = 0;
+  }
+
+  int available = 0;
+  if (::ioctl(m_fd, FIONREAD, &available) != 0) {
+    available = 0;
+  }
+
+  return read_t{
+    .data = p_data.first(static_cast<size_t>(received)),
+    .available = static_cast<size_t>(available),
+    .capacity = tty_buffer_size,
+  };
+}
+
+result<serial::flush_t> pty_serial::driver_flush()
+{
+  if (::tcflush(m_fd, TCIFLUSH) != 0) {
+    return errno_error();
+  }
+  return flush_t{};
+}
+
+result<bool> pty_serial::wait_for(std::uint32_t p_events, int p_timeout_ms)
+{
+  epoll_event event{ .events = p_events, .data = { .fd = m_fd } };
+  if (::epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, m_fd, &event) != 0) {
+    return errno_error();
+  }
+
+  while (true) {
+    epoll_event ready{};
+    const int count = ::epoll_wait(m_epoll_fd, &ready, 1, p_timeout_ms);
+    if (count >= 0) {
+      return count > 0;
+    }
+    if (errno != EINTR) {
+      return errno_error();
+    }
+  }
+}
+
+void pty_serial::close()
+{
+  if (m_epoll_fd >= 0) {
+    ::close(m_epoll_fd);
+    m_epoll_fd = -1;
+  }
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+}
+}  // namespace hal
@@ -0,0 +1,38 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/host/steady_clock.hpp>
+
+#include <time.h>
+
+#include <cstdint>
+
+namespace hal {
+steady_clock::frequency_t host_steady_clock::driver_frequency()
+{
+  return frequency_t{ .operating_frequency = 1'000'000'000.0f };
+}
+
+steady_clock::uptime_t host_steady_clock::driver_uptime()
+{
+  constexpr std::uint64_t nanoseconds_per_second = 1'000'000'000;
+  timespec now{};
+  // Cannot fail for a supported clock id and a valid pointer
+  (void)::clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  return uptime_t{
+    .ticks = static_cast<std::uint64_t>(now.tv_sec) * nanoseconds_per_second +
+             static_cast<std::uint64_t>(now.tv_nsec),
+  };
+}
+}  // namespace hal
@@ -14,25 +14,41 @@
 
 #include <libhal-util/steady_clock.hpp>
 
+#include <algorithm>
+#include <cstdint>
+
 namespace hal {
-std::uint64_t future_deadline(hal::steady_clock& p_steady_clock,
-                              hal::time_duration p_duration)
+namespace {
+/// Ticks of the clock within a duration, without building a tick_converter
+std::uint64_t uncached_ticks(hal::steady_clock& p_steady_clock,
+                             hal::time_duration p_duration)
 {
-  using period = decltype(p_duration)::period;
-  const auto frequency = p_steady_clock.frequency().operating_frequency;
-  const auto tick_period = wavelength<period>(frequency);
-  auto ticks_required = p_duration / tick_period;
-  using unsigned_ticks = std::make_unsigned_t<decltype(ticks_required)>;
+  return tick_converter::to_ticks(
+    p_steady_clock.frequency().operating_frequency, p_duration);
+}
 
-  if (ticks_required <= 1) {
-    ticks_required = 1;
-  }
+std::uint64_t deadline_after(hal::steady_clock& p_steady_clock,
+                             std::uint64_t p_ticks_required)
+{
+  return std::max<std::uint64_t>(p_ticks_required, 1) +
+         p_steady_clock.uptime().ticks;
+}
+}  // namespace
 
-  const auto ticks = static_cast<unsigned_ticks>(ticks_required);
-  const auto future_timestamp = ticks + p_steady_clock.uptime().ticks;
+std::uint64_t future_deadline(hal::steady_clock& p_steady_clock,
+                              hal::time_duration p_duration)
+{
+  return deadline_after(p_steady_clock,
+                        uncached_ticks(p_steady_clock, p_duration));
+}
 
-  return future_timestamp;
+std::uint64_t future_deadline(hal::steady_clock& p_steady_clock,
+                              const tick_converter& p_converter,
+                              hal::time_duration p_duration)
+{
+  return deadline_after(p_steady_clock, p_converter.to_ticks(p_duration));
 }
+
 steady_clock_timeout steady_clock_timeout::create(
   hal::steady_clock& p_steady_clock,
   hal::time_duration p_duration)
@@ -41,6 +57,16 @@ steady_clock_timeout steady_clock_timeout::create(
   return { p_steady_clock, deadline };
 }
 
+steady_clock_timeout steady_clock_timeout::create(
+  hal::steady_clock& p_steady_clock,
+  const tick_converter& p_converter,
+  hal::time_duration p_duration)
+{
+  const auto deadline =
+    future_deadline(p_steady_clock, p_converter, p_duration);
+  return { p_steady_clock, deadline };
+}
+
 status steady_clock_timeout::operator()()
 {
   auto current_count = m_counter->uptime().ticks;
@@ -65,11 +91,201 @@ steady_clock_timeout create_timeout(hal::steady_clock& p_steady_clock,
   return steady_clock_timeout::create(p_steady_clock, p_duration);
 }
 
-void delay(hal::steady_clock& p_steady_clock, hal::time_duration p_duration)
+steady_clock_timeout create_timeout(hal::steady_clock& p_steady_clock,
+                                    const tick_converter& p_converter,
+                                    hal::time_duration p_duration)
+{
+  return steady_clock_timeout::create(p_steady_clock, p_converter, p_duration);
+}
+
+adaptive_steady_clock_timeout adaptive_steady_clock_timeout::create(
+  hal::steady_clock& p_steady_clock,
+  const tick_converter& p_converter,
+  hal::time_duration p_duration,
+  hal::time_duration p_max_overshoot)
+{
+  return create_from_ticks(p_steady_clock,
+                           p_converter.to_ticks(p_duration),
+                           p_converter.to_ticks(p_max_overshoot));
+}
+
+adaptive_steady_clock_timeout adaptive_steady_clock_timeout::create(
+  hal::steady_clock& p_steady_clock,
+  hal::time_duration p_duration,
+  hal::time_duration p_max_overshoot)
+{
+  return create_from_ticks(p_steady_clock,
+                           uncached_ticks(p_steady_clock, p_duration),
+                           uncached_ticks(p_steady_clock, p_max_overshoot));
+}
+
+adaptive_steady_clock_timeout adaptive_steady_clock_timeout::create_from_ticks(
+  hal::steady_clock& p_steady_clock,
+  std::uint64_t p_ticks_required,
+  std::uint64_t p_overshoot_ticks)
 {
-  auto ticks_until_timeout = future_deadline(p_steady_clock, p_duration);
-  while (p_steady_clock.uptime().ticks < ticks_until_timeout) {
+  const auto ticks_required = std::max<std::uint64_t>(p_ticks_required, 1);
+
+  // Keeps overshoot * max_interval within 64 bits. That is still over 39 hours
+  // at 1GHz.
+  constexpr std::uint64_t overshoot_limit = std::uint64_t{ 1 } << 47;
+  const auto overshoot_ticks = std::min(p_overshoot_ticks, overshoot_limit);
+
+  const auto start = p_steady_clock.uptime().ticks;
+  return { p_steady_clock, start, start + ticks_required, overshoot_ticks };
+}
+
+status adaptive_steady_clock_timeout::operator()()
+{
+  m_calls++;
+  if (m_calls < m_interval) {
+    return success();
+  }
+
+  const auto current_count = m_counter->uptime().ticks;
+
+  if (current_count >= m_deadline) {
+    return hal::new_error(std::errc::timed_out);
+  }
+
+  // Calls that fit within the overshoot at the rate measured since the last
+  // read. The interval may at most double per read so a short burst of fast
+  // polls cannot stretch it far beyond what the overshoot allows.
+  const auto elapsed = current_count - m_last_sample;
+  const auto growth_limit = std::min<std::uint64_t>(
+    std::uint64_t{ m_interval } * 2, max_interval);
+  auto next_interval = growth_limit;
+
+  if (elapsed != 0) {
+    next_interval =
+      std::min(m_overshoot_ticks * m_calls / elapsed, growth_limit);
+  }
+
+  m_interval =
+    static_cast<std::uint32_t>(std::max<std::uint64_t>(next_interval, 1));
+  m_calls = 0;
+  m_last_sample = current_count;
+  return success();
+}
+
+adaptive_steady_clock_timeout::adaptive_steady_clock_timeout(
+  hal::steady_clock& p_steady_clock,
+  std::uint64_t p_start,
+  std::uint64_t p_deadline,
+  std::uint64_t p_overshoot_ticks)
+  : m_counter(&p_steady_clock)
+  , m_last_sample(p_start)
+  , m_deadline(p_deadline)
+  , m_overshoot_ticks(p_overshoot_ticks)
+{
+}
+
+adaptive_steady_clock_timeout create_adaptive_timeout(
+  hal::steady_clock& p_steady_clock,
+  hal::time_duration p_duration,
+  hal::time_duration p_max_overshoot)
+{
+  return adaptive_steady_clock_timeout::create(
+    p_steady_clock, p_duration, p_max_overshoot);
+}
+
+adaptive_steady_clock_timeout create_adaptive_timeout(
+  hal::steady_clock& p_steady_clock,
+  const tick_converter& p_converter,
+  hal::time_duration p_duration,
+  hal::time_duration p_max_overshoot)
+{
+  return adaptive_steady_clock_timeout::create(
+    p_steady_clock, p_converter, p_duration, p_max_overshoot);
+}
+
+status deadline::operator()()
+{
+  if (m_counter->uptime().ticks >= m_ticks) {
+    return hal::new_error(std::errc::timed_out);
+  }
+
+  return success();
+}
+
+std::uint64_t deadline::remaining() const
+{
+  const auto current_count = m_counter->uptime().ticks;
+
+  if (current_count >= m_ticks) {
+    return 0;
+  }
+
+  return m_ticks - current_count;
+}
+
+deadline deadline::within(const tick_converter& p_converter,
+                          hal::time_duration p_duration) const
+{
+  const auto narrowed = future_deadline(*m_counter, p_converter, p_duration);
+  return { *m_counter, std::min(narrowed, m_ticks) };
+}
+
+deadline deadline::within(hal::time_duration p_duration) const
+{
+  const auto narrowed = future_deadline(*m_counter, p_duration);
+  return { *m_counter, std::min(narrowed, m_ticks) };
+}
+
+deadline deadline::split(std::uint32_t p_numerator,
+                         std::uint32_t p_denominator) const
+{
+  if (p_denominator == 0) {
+    return *this;
+  }
+
+  const auto numerator = std::min(p_numerator, p_denominator);
+  const auto current_count = m_counter->uptime().ticks;
+  if (current_count >= m_ticks) {
+    return *this;
+  }
+
+  // Split the multiply so that remaining * numerator cannot overflow
+  const auto remaining_ticks = m_ticks - current_count;
+  const auto share = remaining_ticks / p_denominator * numerator +
+                     remaining_ticks % p_denominator * numerator /
+                       p_denominator;
+  return { *m_counter, current_count + share };
+}
+
+deadline create_deadline(hal::steady_clock& p_steady_clock,
+                         hal::time_duration p_duration)
+{
+  return { p_steady_clock, future_deadline(p_steady_clock, p_duration) };
+}
+
+deadline create_deadline(hal::steady_clock& p_steady_clock,
+                         const tick_converter& p_converter,
+                         hal::time_duration p_duration)
+{
+  return { p_steady_clock,
+           future_deadline(p_steady_clock, p_converter, p_duration) };
+}
+
+namespace {
+void wait_until(hal::steady_clock& p_steady_clock, std::uint64_t p_ticks)
+{
+  while (p_steady_clock.uptime().ticks < p_ticks) {
     continue;
   }
 }
+}  // namespace
+
+void delay(hal::steady_clock& p_steady_clock, hal::time_duration p_duration)
+{
+  wait_until(p_steady_clock, future_deadline(p_steady_clock, p_duration));
+}
+
+void delay(hal::steady_clock& p_steady_clock,
+           const tick_converter& p_converter,
+           hal::time_duration p_duration)
+{
+  wait_until(p_steady_clock,
+             future_deadline(p_steady_clock, p_converter, p_duration));
+}
 }  // namespace hal
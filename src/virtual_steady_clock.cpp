@@ -0,0 +1,172 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/virtual_steady_clock.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace hal {
+void virtual_steady_clock::event::cancel()
+{
+  if (m_clock != nullptr) {
+    m_clock->remove(*this);
+  }
+}
+
+virtual_steady_clock::virtual_steady_clock(hal::hertz p_frequency,
+                                           std::uint64_t p_start)
+  : m_converter(p_frequency)
+  , m_frequency(p_frequency)
+  , m_now(p_start)
+  , m_last_reading(p_start)
+{
+}
+
+virtual_steady_clock::~virtual_steady_clock()
+{
+  while (m_events != nullptr) {
+    remove(*m_events);
+  }
+}
+
+void virtual_steady_clock::set_counter_bits(std::uint8_t p_bits,
+                                            hal::callback<void()> p_on_overflow)
+{
+  m_counter_bits = std::clamp<std::uint8_t>(p_bits, 1, 64);
+  m_on_overflow = std::move(p_on_overflow);
+}
+
+void virtual_steady_clock::schedule_at(event& p_event, std::uint64_t p_ticks)
+{
+  p_event.cancel();
+  p_event.m_ticks = p_ticks;
+  p_event.m_clock = this;
+
+  // Insert after events at the same time so that they fire in the order they
+  // were scheduled
+  const auto distance = ticks_until(p_ticks);
+  auto** link = &m_events;
+  while (*link != nullptr && ticks_until((*link)->m_ticks) <= distance) {
+    link = &(*link)->m_next;
+  }
+  p_event.m_next = *link;
+  *link = &p_event;
+}
+
+bool virtual_steady_clock::run_next_event()
+{
+  if (m_events == nullptr) {
+    return false;
+  }
+  advance_by(ticks_due(*m_events));
+  return true;
+}
+
+void virtual_steady_clock::remove(event& p_event)
+{
+  auto** link = &m_events;
+  while (*link != nullptr && *link != &p_event) {
+    link = &(*link)->m_next;
+  }
+  if (*link != nullptr) {
+    *link = p_event.m_next;
+  }
+  p_event.m_next = nullptr;
+  p_event.m_clock = nullptr;
+}
+
+std::int64_t virtual_steady_clock::ticks_until(std::uint64_t p_ticks) const
+{
+  // Wraps with the uptime, so times just past the 64-bit limit are still
+  // ahead of times just before it
+  return static_cast<std::int64_t>(p_ticks - m_now);
+}
+
+std::uint64_t virtual_steady_clock::ticks_due(const event& p_event) const
+{
+  const auto distance = ticks_until(p_event.m_ticks);
+  return distance > 0 ? static_cast<std::uint64_t>(distance) : 0;
+}
+
+void virtual_steady_clock::advance_by(std::uint64_t p_ticks)
+{
+  const auto end = m_now + p_ticks;
+
+  // Events may schedule further events, so take the first one each time
+  while (m_events != nullptr &&
+         ticks_until(m_events->m_ticks) <= ticks_until(end)) {
+    auto& next = *m_events;
+    m_events = next.m_next;
+    next.m_next = nullptr;
+    next.m_clock = nullptr;
+    m_now += ticks_due(next);
+    if (next.m_handler) {
+      next.m_handler();
+    }
+  }
+
+  // A handler may have advanced the clock past the end already
+  if (ticks_until(end) > 0) {
+    m_now = end;
+  }
+}
+
+steady_clock::frequency_t virtual_steady_clock::driver_frequency()
+{
+  return frequency_t{ .operating_frequency = m_frequency };
+}
+
+steady_clock::uptime_t virtual_steady_clock::driver_uptime()
+{
+  m_readings++;
+
+  auto reading = m_now;
+  if (m_jitter) {
+    const auto offset = m_jitter();
+    // Wraps around like the uptime itself would
+    reading = m_now + static_cast<std::uint64_t>(offset);
+  }
+  // Clamped to monotonic by distance, so a reading past the 64-bit limit is
+  // still later than one before it
+  if (static_cast<std::int64_t>(reading - m_last_reading) < 0) {
+    reading = m_last_reading;
+  }
+
+  if (m_counter_bits < 64) {
+    // Counts the counter wraps modulo the upper bits, which carries across
+    // the 64-bit limit too
+    const auto upper_mask = (std::uint64_t{ 1 } << (64 - m_counter_bits)) - 1;
+    const auto wraps =
+      ((reading >> m_counter_bits) - (m_last_reading >> m_counter_bits)) &
+      upper_mask;
+    for (std::uint64_t wrap = 0; wrap < wraps && m_on_overflow; wrap++) {
+      m_on_overflow();
+    }
+  }
+  m_last_reading = reading;
+
+  auto ticks = m_step;
+  if (m_skip_to_events && m_events != nullptr) {
+    ticks = std::max(ticks, ticks_due(*m_events));
+  }
+  advance_by(ticks);
+
+  if (m_counter_bits < 64) {
+    reading &= (std::uint64_t{ 1 } << m_counter_bits) - 1;
+  }
+  return uptime_t{ .ticks = reading };
+}
+}  // namespace hal
@@ -0,0 +1,128 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/worker_scheduler.hpp>
+
+#include <utility>
+
+#include <libhal-util/timeout.hpp>
+#include <libhal/error.hpp>
+#include <libhal/timeout.hpp>
+
+namespace hal {
+worker_scheduler::~worker_scheduler()
+{
+  while (m_head != nullptr) {
+    auto* next = m_head->m_next;
+    m_head->m_scheduler = nullptr;
+    m_head->m_next = nullptr;
+    m_head->m_link = nullptr;
+    m_head = next;
+  }
+}
+
+void worker_scheduler::add(task& p_task)
+{
+  p_task.cancel();
+
+  // Insert after every task of the same or higher priority
+  task** link = &m_head;
+  while (*link != nullptr && (*link)->m_priority >= p_task.m_priority) {
+    link = &(*link)->m_next;
+  }
+
+  p_task.m_next = *link;
+  p_task.m_link = link;
+  if (*link != nullptr) {
+    (*link)->m_link = &p_task.m_next;
+  }
+  *link = &p_task;
+
+  p_task.m_scheduler = this;
+  m_size++;
+  m_idle = false;
+}
+
+void worker_scheduler::remove(task& p_task)
+{
+  if (m_cursor == &p_task) {
+    m_cursor = p_task.m_next;
+  }
+
+  *p_task.m_link = p_task.m_next;
+  if (p_task.m_next != nullptr) {
+    p_task.m_next->m_link = p_task.m_link;
+  }
+
+  p_task.m_scheduler = nullptr;
+  p_task.m_next = nullptr;
+  p_task.m_link = nullptr;
+  m_size--;
+}
+
+void worker_scheduler::complete(task& p_task, result<work_state> p_result)
+{
+  remove(p_task);
+  if (p_task.m_on_complete) {
+    p_task.m_on_complete(std::move(p_result));
+  }
+}
+
+size_t worker_scheduler::run_once()
+{
+  size_t completed = 0;
+  bool progressed = false;
+  m_notified.store(false, std::memory_order_release);
+  m_cursor = m_head;
+
+  while (m_cursor != nullptr) {
+    auto& current = *m_cursor;
+    m_cursor = current.m_next;
+
+    current.m_progressed = false;
+    auto state = current.m_worker();
+    progressed = std::exchange(current.m_progressed, false) || progressed;
+    if (current.m_scheduler != this) {
+      // The worker cancelled its own task
+      continue;
+    }
+
+    if (!state || hal::terminated(state.value())) {
+      complete(current, std::move(state));
+      completed++;
+      continue;
+    }
+
+    if (current.m_deadline) {
+      auto deadline = current.m_deadline();
+      if (!deadline) {
+        complete(current, deadline.error());
+        completed++;
+      }
+    }
+  }
+
+  m_idle = (completed == 0 && !progressed);
+  return completed;
+}
+
+size_t worker_scheduler::run_until_idle()
+{
+  size_t completed = 0;
+  do {
+    completed += run_once();
+  } while (!idle());
+  return completed;
+}
+}  // namespace hal
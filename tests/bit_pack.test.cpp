@@ -0,0 +1,146 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/bit_pack.hpp>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+constexpr size_t sample_count = 37;
+
+/// Pack one bit at a time, as the reference for pack_bits
+template<size_t Width, bit_order Order>
+constexpr auto reference_pack(
+  const std::array<std::uint32_t, sample_count>& p_values)
+{
+  std::array<hal::byte, packed_size<Width>(sample_count)> packed{};
+  size_t bit = 0;
+  for (const auto value : p_values) {
+    for (size_t index = 0; index < Width; index++, bit++) {
+      const auto value_bit = Order == bit_order::msb_first
+                               ? (value >> (Width - 1 - index)) & 1
+                               : (value >> index) & 1;
+      const auto byte_bit =
+        Order == bit_order::msb_first ? 7 - bit % 8 : bit % 8;
+      packed[bit / 8] |= static_cast<hal::byte>(value_bit << byte_bit);
+    }
+  }
+  return packed;
+}
+
+template<size_t Width, bit_order Order>
+bool round_trips()
+{
+  std::array<std::uint32_t, sample_count> values{};
+  std::uint32_t state = 0x1234'5678;
+  for (auto& value : values) {
+    state = state * 1'664'525U + 1'013'904'223U;
+    const auto mask = (std::uint64_t{ 1 } << Width) - 1;
+    value = static_cast<std::uint32_t>(state & mask);
+  }
+
+  std::array<hal::byte, packed_size<Width>(sample_count)> packed{};
+  std::array<std::uint32_t, sample_count> unpacked{};
+  const auto bytes = pack_bits<Width, Order>(std::span(values), packed);
+  const auto count = unpack_bits<Width, Order>(packed, std::span(unpacked));
+
+  return bytes == packed.size() && count == sample_count &&
+         packed == reference_pack<Width, Order>(values) && unpacked == values;
+}
+
+template<bit_order Order, size_t... Widths>
+bool all_round_trip(std::index_sequence<Widths...>)
+{
+  return (round_trips<Widths + 1, Order>() && ...);
+}
+}  // namespace
+
+void bit_pack_test()
+{
+  using namespace boost::ut;
+
+  "hal::unpack_bits 12-bit samples"_test = []() {
+    // Setup
+    constexpr std::array<hal::byte, 6> packed{ 0xAB, 0xCD, 0xEF,
+                                               0x01, 0x23, 0x45 };
+    std::array<std::uint16_t, 4> msb_first{};
+    std::array<std::uint16_t, 4> lsb_first{};
+
+    // Exercise
+    const auto count = unpack_bits<12>(packed, std::span(msb_first));
+    unpack_bits<12, bit_order::lsb_first>(packed, std::span(lsb_first));
+
+    // Verify
+    expect(that % 4 == count);
+    expect(std::array<std::uint16_t, 4>{ 0xABC, 0xDEF, 0x012, 0x345 } ==
+           msb_first);
+    expect(std::array<std::uint16_t, 4>{ 0xDAB, 0xEFC, 0x301, 0x452 } ==
+           lsb_first);
+  };
+
+  "hal::unpack_bits 24-bit samples"_test = []() {
+    // Setup
+    constexpr std::array<hal::byte, 9> packed{ 0x12, 0x34, 0x56, 0x78, 0x9A,
+                                               0xBC, 0xDE, 0xF0, 0x11 };
+    std::array<std::uint32_t, 3> msb_first{};
+    std::array<std::uint32_t, 3> lsb_first{};
+
+    // Exercise
+    unpack_bits<24>(packed, std::span(msb_first));
+    unpack_bits<24, bit_order::lsb_first>(packed, std::span(lsb_first));
+
+    // Verify
+    expect(std::array<std::uint32_t, 3>{ 0x123456, 0x789ABC, 0xDEF011 } ==
+           msb_first);
+    expect(std::array<std::uint32_t, 3>{ 0x563412, 0xBC9A78, 0x11F0DE } ==
+           lsb_first);
+  };
+
+  "hal::pack_bits partial buffers"_test = []() {
+    // Setup
+    constexpr std::array<std::uint16_t, 3> values{ 0xFABC, 0x0DEF, 0x0123 };
+    std::array<hal::byte, 4> packed{};
+    std::array<hal::byte, 5> padded{};
+    std::array<std::uint16_t, 3> unpacked{};
+
+    // Exercise
+    const auto bytes = pack_bits<12>(std::span(values), packed);
+    const auto padded_bytes = pack_bits<12>(std::span(values), padded);
+    const auto count = unpack_bits<12>(std::span(packed).first(4),
+                                       std::span(unpacked));
+
+    // Verify
+    expect(that % 3 == bytes);
+    expect(std::array<hal::byte, 4>{ 0xAB, 0xCD, 0xEF, 0x00 } == packed);
+    expect(that % 5 == padded_bytes);
+    expect(that % 2 == count);
+    expect(that % 2 == count);
+    expect(that % 0xABC == unpacked[0]);
+    expect(that % 0xDEF == unpacked[1]);
+    expect(that % 0 == unpacked[2]);
+  };
+
+  "hal::pack_bits and hal::unpack_bits round trip every width"_test = []() {
+    // Exercise & Verify
+    constexpr auto widths = std::make_index_sequence<32>();
+    expect(all_round_trip<bit_order::msb_first>(widths));
+    expect(all_round_trip<bit_order::lsb_first>(widths));
+  };
+};
+}  // namespace hal
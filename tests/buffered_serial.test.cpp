@@ -0,0 +1,176 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/buffered_serial.hpp>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+struct recording_serial : public hal::serial
+{
+  status driver_configure(const settings&) override
+  {
+    return success();
+  }
+
+  result<write_t> driver_write(std::span<const hal::byte> p_data) override
+  {
+    m_writes.emplace_back(p_data.begin(), p_data.end());
+    return write_t{ p_data };
+  }
+
+  result<read_t> driver_read(std::span<hal::byte> p_data) override
+  {
+    return read_t{ .data = p_data.first(0), .available = 0, .capacity = 0 };
+  }
+
+  result<flush_t> driver_flush() override
+  {
+    m_flush_calls++;
+    return flush_t{};
+  }
+
+  std::vector<std::string> m_writes{};
+  int m_flush_calls = 0;
+};
+
+struct manual_steady_clock : public hal::steady_clock
+{
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = m_uptime };
+  }
+
+  std::uint64_t m_uptime = 0;
+};
+}  // namespace
+
+void buffered_serial_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::buffered_serial coalesces small writes"_test = []() {
+    // Setup
+    recording_serial serial;
+    buffered_serial<16> buffered(serial);
+
+    // Exercise
+    (void)hal::write(buffered, "abc"sv);
+    (void)hal::write(buffered, "def"sv);
+    const auto writes_before_flush = serial.m_writes.size();
+    auto flush_status = buffered.flush_writes();
+
+    // Verify
+    expect(bool{ flush_status });
+    expect(that % 0 == writes_before_flush);
+    expect(that % 1 == serial.m_writes.size());
+    expect(that % "abcdef"s == serial.m_writes[0]);
+    expect(that % 0 == buffered.pending());
+    expect(that % 2 == buffered.stats().write_calls);
+    expect(that % 6 == buffered.stats().bytes_written);
+    expect(that % 1 == buffered.stats().explicit_flushes);
+    expect(that % 6 == buffered.stats().high_water_mark);
+  };
+
+  "hal::buffered_serial flushes when full"_test = []() {
+    // Setup
+    recording_serial serial;
+    buffered_serial<8> buffered(serial);
+
+    // Exercise
+    (void)hal::write(buffered, "12345"sv);
+    (void)hal::write(buffered, "6789"sv);
+    (void)hal::write(buffered, "0123456789"sv);
+
+    // Verify
+    expect(that % 3 == serial.m_writes.size());
+    expect(that % "12345"s == serial.m_writes[0]);
+    expect(that % "6789"s == serial.m_writes[1]);
+    expect(that % "0123456789"s == serial.m_writes[2]);
+    expect(that % 2 == buffered.stats().full_flushes);
+    expect(that % 1 == buffered.stats().passthrough_writes);
+  };
+
+  "hal::buffered_serial byte threshold"_test = []() {
+    // Setup
+    recording_serial serial;
+    buffered_serial<32> buffered(serial, 4);
+
+    // Exercise
+    (void)hal::write(buffered, "ab"sv);
+    (void)hal::write(buffered, "cd"sv);
+    (void)hal::write(buffered, "e"sv);
+
+    // Verify
+    expect(that % 1 == serial.m_writes.size());
+    expect(that % "abcd"s == serial.m_writes[0]);
+    expect(that % 1 == buffered.pending());
+    expect(that % 1 == buffered.stats().threshold_flushes);
+  };
+
+  "hal::buffered_serial maximum latency"_test = []() {
+    // Setup
+    recording_serial serial;
+    manual_steady_clock clock;
+    buffered_serial<32> buffered(serial, clock, 100us);
+
+    // Exercise
+    clock.m_uptime = 1000;
+    (void)hal::write(buffered, "a"sv);
+    clock.m_uptime = 1050;
+    (void)hal::write(buffered, "b"sv);
+    auto early_poll = buffered.poll();
+    const auto writes_before_latency = serial.m_writes.size();
+    clock.m_uptime = 1100;
+    auto late_poll = buffered.poll();
+
+    // Verify
+    expect(bool{ early_poll });
+    expect(bool{ late_poll });
+    expect(that % 0 == writes_before_latency);
+    expect(that % 1 == serial.m_writes.size());
+    expect(that % "ab"s == serial.m_writes[0]);
+    expect(that % 1 == buffered.stats().latency_flushes);
+  };
+
+  "hal::buffered_serial forwards flush and sends on destruction"_test = []() {
+    // Setup
+    recording_serial serial;
+
+    // Exercise
+    {
+      buffered_serial<16> buffered(serial);
+      (void)hal::write(buffered, "xyz"sv);
+      (void)buffered.flush();
+    }
+
+    // Verify
+    expect(that % 1 == serial.m_flush_calls);
+    expect(that % 1 == serial.m_writes.size());
+    expect(that % "xyz"s == serial.m_writes[0]);
+  };
+}
+}  // namespace hal
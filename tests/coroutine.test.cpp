@@ -0,0 +1,284 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/coroutine.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <libhal-util/as_bytes.hpp>
+#include <libhal-util/serial_coroutines.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+/// Serial port that only lets a limited number of bytes through at a time
+class trickle_serial : public hal::serial
+{
+public:
+  explicit trickle_serial(std::string_view p_input)
+    : m_input(p_input)
+  {
+  }
+
+  status driver_configure(const settings&) override
+  {
+    return {};
+  }
+
+  result<write_t> driver_write(std::span<const hal::byte> p_data) override
+  {
+    return write_t{ p_data };
+  }
+
+  result<read_t> driver_read(std::span<hal::byte> p_data) override
+  {
+    const auto count = std::min({ p_data.size(), m_budget, m_input.size() });
+    for (size_t index = 0; index < count; index++) {
+      p_data[index] = static_cast<hal::byte>(m_input[index]);
+    }
+    m_input.remove_prefix(count);
+    m_budget -= count;
+    return read_t{
+      .data = p_data.first(count),
+      .available = std::min(m_budget, m_input.size()),
+      .capacity = 64,
+    };
+  }
+
+  result<flush_t> driver_flush() override
+  {
+    return flush_t{};
+  }
+
+  std::string_view m_input;
+  size_t m_budget = 0;
+};
+
+/// One tick per millisecond
+struct manual_clock : public hal::steady_clock
+{
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = m_uptime };
+  }
+
+  std::uint64_t m_uptime = 0;
+};
+
+task<std::uint32_t> read_reading(hal::serial& p_serial)
+{
+  using namespace std::literals;
+  auto found = co_await until_done(skip_past(p_serial, as_bytes("$"sv)));
+  if (!found) {
+    co_return found.error();
+  }
+
+  read_uint32 reader(p_serial);
+  auto parsed = co_await until_done(reader);
+  if (!parsed) {
+    co_return parsed.error();
+  }
+  co_return reader.get().value();
+}
+
+task<std::uint32_t> sum_readings(coroutine_arena& p_arena,
+                                 hal::serial& p_serial,
+                                 int p_count)
+{
+  (void)p_arena;
+  std::uint32_t sum = 0;
+  for (int index = 0; index < p_count; index++) {
+    auto reading = co_await read_reading(p_serial);
+    if (!reading) {
+      co_return reading.error();
+    }
+    sum += reading.value();
+  }
+  co_return sum;
+}
+
+task<void> fail_with(coroutine_arena& p_arena, std::errc p_error)
+{
+  (void)p_arena;
+  co_return new_error(p_error);
+}
+
+task<void> delayed_push(coroutine_arena& p_arena,
+                        hal::steady_clock& p_clock,
+                        hal::time_duration p_delay,
+                        std::string& p_log,
+                        char p_name)
+{
+  (void)p_arena;
+  co_await async_delay(p_clock, p_delay);
+  p_log.push_back(p_name);
+  co_return {};
+}
+}  // namespace
+
+void coroutine_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::task composes serial workers"_test = []() {
+    // Setup
+    alignas(std::max_align_t) std::array<hal::byte, 1024> memory{};
+    coroutine_arena arena(memory);
+    coroutine_executor executor(arena);
+    trickle_serial serial("xx$12,junk$30,$0,"sv);
+    auto sum = sum_readings(arena, serial, 3);
+
+    // Exercise
+    const auto spawned = executor.spawn(sum);
+    int rounds = 0;
+    while (!sum.done() && rounds < 100) {
+      serial.m_budget += 2;
+      executor.run_once();
+      rounds++;
+    }
+
+    // Verify
+    expect(that % spawned.has_value());
+    expect(that % sum.done());
+    expect(that % rounds > 5);
+    expect(that % 42 == sum.get().value());
+    expect(that % 0U == executor.size());
+    expect(that % arena.peak() > 0U);
+  };
+
+  "hal::task frames are returned to the arena"_test = []() {
+    // Setup
+    std::array<hal::byte, 1024> memory{};
+    coroutine_arena arena(memory);
+    coroutine_executor executor(arena);
+
+    // Exercise
+    auto first = fail_with(arena, std::errc::io_error);
+    auto second = fail_with(arena, std::errc::io_error);
+    const auto used_by_two = arena.used();
+    first = task<void>();
+    const auto used_after_out_of_order_free = arena.used();
+    second = task<void>();
+
+    // Verify
+    expect(that % used_by_two > 0U);
+    expect(that % used_by_two == used_after_out_of_order_free);
+    expect(that % 0U == arena.used());
+    expect(that % arena.capacity() <= memory.size());
+  };
+
+  "hal::task reports errors and allocation failure"_test = []() {
+    // Setup
+    alignas(std::max_align_t) std::array<hal::byte, 1024> memory{};
+    coroutine_arena arena(memory);
+    coroutine_executor executor(arena);
+    trickle_serial serial("$1,"sv);
+    serial.m_budget = 10;
+    size_t frame_size = 0;
+    {
+      auto probe = sum_readings(arena, serial, 1);
+      frame_size = arena.used();
+    }
+    // Only room for the outer frame, not the read_reading() it awaits
+    alignas(std::max_align_t) std::array<hal::byte, 1024> small_memory{};
+    coroutine_arena small_arena(
+      std::span<hal::byte>(small_memory).first(frame_size));
+    coroutine_executor small_executor(small_arena);
+
+    // Exercise
+    auto failing = fail_with(arena, std::errc::io_error);
+    const auto spawned = executor.spawn(failing);
+    executor.run_once();
+    auto outer_only = sum_readings(small_arena, serial, 1);
+    auto no_memory = sum_readings(small_arena, serial, 1);
+    const auto spawned_no_memory = small_executor.spawn(no_memory);
+    const auto spawned_outer_only = small_executor.spawn(outer_only);
+    small_executor.run_once();
+
+    // Verify
+    expect(that % spawned.has_value());
+    expect(that % failing.done());
+    expect(that % !failing.get().has_value());
+    expect(that % !no_memory.valid());
+    expect(that % !spawned_no_memory.has_value());
+    expect(that % spawned_outer_only.has_value());
+    expect(that % outer_only.done());
+    expect(that % !outer_only.get().has_value());
+  };
+
+  "hal::task delays interleave on one executor"_test = []() {
+    // Setup
+    std::array<hal::byte, 1024> memory{};
+    coroutine_arena arena(memory);
+    coroutine_executor executor(arena);
+    manual_clock clock;
+    std::string log;
+    auto slow = delayed_push(arena, clock, 10ms, log, 's');
+    auto fast = delayed_push(arena, clock, 5ms, log, 'f');
+
+    // Exercise
+    (void)executor.spawn(slow);
+    (void)executor.spawn(fast);
+    for (std::uint64_t tick = 0; tick < 20; tick++) {
+      clock.m_uptime = tick;
+      executor.run_once();
+    }
+
+    // Verify
+    expect(that % "fs"s == log);
+    expect(that % slow.done());
+    expect(that % fast.done());
+  };
+
+  "hal::until_done with timeout"_test = []() {
+    // Setup
+    std::array<hal::byte, 1024> memory{};
+    coroutine_arena arena(memory);
+    coroutine_executor executor(arena);
+    manual_clock clock;
+    trickle_serial serial("never a dollar sign"sv);
+    serial.m_budget = 100;
+    auto wait_for_dollar = [](coroutine_arena&,
+                              hal::serial& p_serial,
+                              hal::steady_clock& p_clock) -> task<work_state> {
+      co_return co_await until_done(skip_past(p_serial, as_bytes("$"sv)),
+                                    create_timeout(p_clock, 5ms));
+    };
+    auto waiting = wait_for_dollar(arena, serial, clock);
+
+    // Exercise
+    (void)executor.spawn(waiting);
+    for (std::uint64_t tick = 0; tick < 10; tick++) {
+      clock.m_uptime = tick;
+      executor.run_once();
+    }
+
+    // Verify
+    expect(that % waiting.done());
+    expect(that % !waiting.get().has_value());
+  };
+}
+}  // namespace hal
@@ -0,0 +1,103 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/endian.hpp>
+
+#include <array>
+#include <cstdint>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+void endian_test()
+{
+  using namespace boost::ut;
+
+  "hal::byteswap"_test = []() {
+    // Exercise & Verify
+    static_assert(byteswap(std::uint8_t{ 0x12 }) == 0x12);
+    static_assert(byteswap(std::uint16_t{ 0x1234 }) == 0x3412);
+    static_assert(byteswap(std::uint32_t{ 0x1234'5678 }) == 0x7856'3412);
+    static_assert(byteswap(std::uint64_t{ 0x0102'0304'0506'0708 }) ==
+                  0x0807'0605'0403'0201);
+    static_assert(byteswap(std::int16_t{ -2 }) == std::int16_t{ -257 });
+  };
+
+  "hal::load_be/load_le/store_be/store_le single values"_test = []() {
+    // Setup
+    constexpr std::array<hal::byte, 4> block{ 0xFF, 0xFE, 0x12, 0x34 };
+    std::array<hal::byte, 4> big{};
+    std::array<hal::byte, 4> little{};
+
+    // Exercise
+    const auto signed_big = load_be<std::int16_t>(block);
+    const auto unsigned_big = load_be<std::uint32_t>(block);
+    const auto unsigned_little = load_le<std::uint16_t>(block);
+    store_be(std::uint32_t{ 0xDEAD'BEEF }, big);
+    store_le(std::int32_t{ -2 }, little);
+
+    // Verify
+    expect(that % -2 == signed_big);
+    expect(that % 0xFFFE'1234 == unsigned_big);
+    expect(that % 0xFEFF == unsigned_little);
+    expect(std::array<hal::byte, 4>{ 0xDE, 0xAD, 0xBE, 0xEF } == big);
+    expect(std::array<hal::byte, 4>{ 0xFE, 0xFF, 0xFF, 0xFF } == little);
+    static_assert(load_be<std::uint16_t>(block) == 0xFFFE);
+  };
+
+  "hal::load_be/store_be arrays"_test = []() {
+    // Setup
+    constexpr std::array<hal::byte, 7> block{ 0x00, 0x10, 0xFF,
+                                              0xF0, 0x80, 0x00, 0xAA };
+    std::array<std::int16_t, 4> values{};
+    std::array<hal::byte, 6> stored{};
+    std::array<hal::byte, 6> stored_little{};
+
+    // Exercise
+    const auto loaded = load_be<std::int16_t>(block, values);
+    const auto written =
+      store_be<std::int16_t>(std::span(values).first(3), stored);
+    store_le<std::int16_t>(std::span(values).first(3), stored_little);
+
+    // Verify
+    expect(that % 3 == loaded);
+    expect(std::array<std::int16_t, 4>{ 16, -16, -32768, 0 } == values);
+    expect(that % 3 == written);
+    expect(std::array<hal::byte, 6>{ 0x00, 0x10, 0xFF, 0xF0, 0x80, 0x00 } ==
+           stored);
+    expect(std::array<hal::byte, 6>{ 0x10, 0x00, 0xF0, 0xFF, 0x00, 0x80 } ==
+           stored_little);
+  };
+
+  "hal::byteswap_copy"_test = []() {
+    // Setup
+    constexpr std::array<std::uint32_t, 3> input{ 0x1122'3344,
+                                                  0x5566'7788,
+                                                  0x99AA'BBCC };
+    std::array<std::uint32_t, 2> output{};
+    std::array<std::uint64_t, 2> in_place{ 0x0102'0304'0506'0708, 0xFF };
+
+    // Exercise
+    const auto copied = byteswap_copy<std::uint32_t>(input, output);
+    byteswap_copy<std::uint64_t>(in_place, in_place);
+
+    // Verify
+    expect(that % 2 == copied);
+    expect(std::array<std::uint32_t, 2>{ 0x4433'2211, 0x8877'6655 } ==
+           output);
+    expect(std::array<std::uint64_t, 2>{ 0x0807'0605'0403'0201,
+                                         0xFF00'0000'0000'0000 } == in_place);
+  };
+};
+}  // namespace hal
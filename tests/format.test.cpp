@@ -0,0 +1,80 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/format.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+template<typename... Args>
+std::string format_string_test(format_string<Args...> p_format,
+                               const Args&... p_args)
+{
+  std::string output;
+  format_to([&output](std::string_view p_text) { output += p_text; },
+            p_format,
+            p_args...);
+  return output;
+}
+}  // namespace
+
+void format_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::format_to() no arguments"_test = []() {
+    expect(that % "hello, world"s == format_string_test("hello, world"));
+  };
+
+  "hal::format_to() integers"_test = []() {
+    expect(that % "5 -7 0"s == format_string_test("{} {} {}", 5, -7, 0U));
+    expect(that % "-9223372036854775808"s ==
+           format_string_test("{}", std::numeric_limits<std::int64_t>::min()));
+    expect(that % "ff ABC 10 101"s ==
+           format_string_test("{:x} {:X} {:o} {:b}", 255, 0xABC, 8, 5));
+  };
+
+  "hal::format_to() width and fill"_test = []() {
+    expect(that % "-0042|   42|00042|0x00FF"s ==
+           format_string_test("{:05}|{:5}|{:05}|0x{:04X}", -42, 42, 42, 255));
+    expect(that % "    hi|"s == format_string_test("{:6}|", "hi"sv));
+    expect(that % "[00000]"s == format_string_test("[{:05}]", ""sv));
+  };
+
+  "hal::format_to() bool, char and strings"_test = []() {
+    expect(
+      that % "true false c 65 text"s ==
+      format_string_test("{} {} {} {:d} {}", true, false, 'c', 'A', "text"));
+  };
+
+  "hal::format_to() floating point"_test = []() {
+    expect(that % "3.14 2.500000 -0.001 10.00"s ==
+           format_string_test(
+             "{:.2f} {} {:.3f} {:.2f}", 3.14159, 2.5f, -0.0005, 9.999));
+    expect(that % "1.235e+04 1.000000e+300"s ==
+           format_string_test("{:.3e} {}", 12345.678, 1e300));
+  };
+
+  "hal::format_to() escaped braces"_test = []() {
+    expect(that % "{} 1 }"s == format_string_test("{{}} {} }}", 1));
+  };
+};
+}  // namespace hal
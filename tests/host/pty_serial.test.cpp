@@ -0,0 +1,144 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/host/pty_serial.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <libhal-util/serial.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+using namespace std::literals;
+
+/// Read until p_buffer is full, or until nothing arrives within a second
+result<size_t> read_all(pty_serial& p_serial, std::span<hal::byte> p_buffer)
+{
+  size_t received = 0;
+  while (received < p_buffer.size()) {
+    const auto read = HAL_CHECK(p_serial.read(p_buffer.subspan(received)));
+    received += read.data.size();
+    if (read.data.empty() && !HAL_CHECK(p_serial.wait_readable(1s))) {
+      break;
+    }
+  }
+  return received;
+}
+
+struct pty_pair
+{
+  pty_serial controller;
+  pty_serial device;
+};
+
+result<pty_pair> open_pair()
+{
+  auto controller = HAL_CHECK(pty_serial::create());
+  auto device = HAL_CHECK(controller.open_peer());
+  return pty_pair{ std::move(controller), std::move(device) };
+}
+
+std::vector<hal::byte> every_byte_value()
+{
+  std::vector<hal::byte> bytes(256);
+  for (size_t index = 0; index < bytes.size(); index++) {
+    bytes[index] = static_cast<hal::byte>(index);
+  }
+  return bytes;
+}
+}  // namespace
+
+void pty_serial_test()
+{
+  using namespace boost::ut;
+
+  "hal::pty_serial passes every byte value in both directions"_test = []() {
+    // Setup
+    auto pair = open_pair();
+    auto& [controller, device] = pair.value();
+    const auto sent = every_byte_value();
+    std::vector<hal::byte> at_device(sent.size());
+    std::vector<hal::byte> at_controller(sent.size());
+
+    // Exercise
+    const auto to_device = hal::write(controller, sent);
+    auto device_received = read_all(device, at_device);
+    const auto to_controller = hal::write(device, sent);
+    auto controller_received = read_all(controller, at_controller);
+
+    // Verify
+    expect(that % static_cast<bool>(to_device));
+    expect(that % static_cast<bool>(to_controller));
+    expect(that % sent.size() == device_received.value());
+    expect(that % sent.size() == controller_received.value());
+    expect(sent == at_device);
+    expect(sent == at_controller);
+  };
+
+  "hal::pty_serial transfer larger than the kernel buffer"_test = []() {
+    // Setup
+    // The writer blocks in driver_write() until the reader drains the
+    // buffer, so both ends must run at once
+    constexpr size_t transfer_size = 256 * 1024;
+    auto pair = open_pair();
+    auto& [controller, device] = pair.value();
+    std::vector<hal::byte> sent(transfer_size);
+    for (size_t index = 0; index < sent.size(); index++) {
+      sent[index] = static_cast<hal::byte>(index * 7 + index / 256);
+    }
+    std::vector<hal::byte> received(transfer_size);
+    bool write_succeeded = false;
+
+    // Exercise
+    std::thread writer([&]() {
+      write_succeeded = static_cast<bool>(hal::write(device, sent));
+    });
+    auto received_size = read_all(controller, received);
+    writer.join();
+
+    // Verify
+    expect(that % write_succeeded);
+    expect(that % transfer_size == received_size.value());
+    expect(sent == received);
+  };
+
+  "hal::pty_serial wait_readable() and read() without data"_test = []() {
+    // Setup
+    auto pair = open_pair();
+    auto& [controller, device] = pair.value();
+    std::array<hal::byte, 16> buffer{};
+
+    // Exercise
+    const auto readable = device.wait_readable(10ms).value();
+    const auto read = device.read(buffer).value();
+    const auto peer_of_device = device.open_peer();
+
+    // Verify
+    expect(that % !readable);
+    expect(that % 0 == read.data.size());
+    expect(that % 0 == read.available);
+    expect(that % !controller.peer_path().empty());
+    expect(that % device.peer_path().empty());
+    expect(that % !static_cast<bool>(peer_of_device));
+  };
+};
+}  // namespace hal
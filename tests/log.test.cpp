@@ -0,0 +1,135 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/log.hpp>
+#include <libhal-util/log_decoder.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+struct log_test_serial : public hal::serial
+{
+  status driver_configure(const settings&) override
+  {
+    return success();
+  }
+
+  result<write_t> driver_write(std::span<const hal::byte> p_data) override
+  {
+    m_out.insert(m_out.end(), p_data.begin(), p_data.end());
+    return write_t{ p_data };
+  }
+
+  result<read_t> driver_read(std::span<hal::byte> p_data) override
+  {
+    return read_t{ .data = p_data.first(0), .available = 0, .capacity = 0 };
+  }
+
+  result<flush_t> driver_flush() override
+  {
+    return flush_t{};
+  }
+
+  std::vector<hal::byte> m_out{};
+};
+}  // namespace
+
+void log_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::log_varint_encode()"_test = []() {
+    std::array<hal::byte, 10> buffer{};
+
+    expect(that % 1 == log_varint_size(0));
+    expect(that % 1 == log_varint_size(127));
+    expect(that % 2 == log_varint_size(128));
+    expect(that % 10 == log_varint_size(UINT64_MAX));
+
+    auto* end = log_varint_encode(300, buffer.data());
+    expect(that % 2 == end - buffer.data());
+    expect(that % 0xAC == buffer[0]);
+    expect(that % 0x02 == buffer[1]);
+  };
+
+  "hal::log() encoding"_test = []() {
+    // Setup
+    log_test_serial serial;
+    constexpr auto id = log_id<"{} {}", std::int32_t, std::uint8_t>;
+
+    // Exercise
+    hal::log<"{} {}">(serial, std::int32_t{ -1 }, std::uint8_t{ 200 });
+
+    // Verify
+    const std::vector<hal::byte> expected = {
+      7,
+      static_cast<hal::byte>(id),
+      static_cast<hal::byte>(id >> 8),
+      static_cast<hal::byte>(id >> 16),
+      static_cast<hal::byte>(id >> 24),
+      0x01,  // zigzag(-1)
+      0xC8,  // 200
+      0x01,
+    };
+    expect(expected == serial.m_out);
+  };
+
+  "hal::log() round trip"_test = []() {
+    // Setup
+    log_test_serial serial;
+    log_decoder decoder;
+    const auto first = make_log_record<"x={} y={:04X} {{}}!", int, unsigned>();
+    const auto second = make_log_record<"{{{:.2f}}} {:4} {} {}",
+                                        float,
+                                        const char*,
+                                        bool,
+                                        char>();
+
+    // Exercise
+    // Records are found wherever they are placed in the image
+    std::vector<hal::byte> image(37, 0xFF);
+    image.insert(image.end(), first.begin(), first.end());
+    image.insert(image.end(), 11, 0x00);
+    image.insert(image.end(), second.begin(), second.end());
+    const auto loaded = decoder.load_records(image);
+
+    hal::log<"x={} y={:04X} {{}}!">(serial, -42, 0xBEEFU);
+    hal::log<"{{{:.2f}}} {:4} {} {}">(serial, 2.5f, "on", true, 'q');
+    hal::log<"not in image {}">(serial, 'q');
+
+    // Feed the decoder one byte at a time to exercise partial messages
+    std::vector<std::string> messages;
+    for (const auto& received : serial.m_out) {
+      decoder.feed(std::span(&received, 1));
+      while (auto message = decoder.next()) {
+        messages.push_back(*message);
+      }
+    }
+
+    // Verify
+    expect(that % 2 == loaded);
+    expect(that % 3 == messages.size());
+    expect(that % "x=-42 y=BEEF {}!"s == messages[0]);
+    expect(that % "{2.50}   on true q"s == messages[1]);
+    expect(that % "<unknown log id 0x"s == messages[2].substr(0, 18));
+  };
+}
+}  // namespace hal
@@ -15,28 +15,46 @@
 namespace hal {
 extern void as_bytes_test();
 extern void bit_test();
+extern void bit_pack_test();
+extern void buffered_serial_test();
 extern void can_test();
+extern void coroutine_test();
+extern void endian_test();
 extern void enum_test();
+extern void format_test();
 extern void i2c_util_test();
 extern void input_pin_util_test();
 extern void interrupt_pin_util_test();
+extern void log_test();
 extern void map_test();
 extern void math_test();
 extern void move_interceptor_test();
+extern void object_pool_test();
 extern void output_pin_util_test();
 extern void overflow_counter_test();
+extern void profile_disabled_test();
+extern void profile_test();
+extern void register_test();
 extern void serial_util_test();
+extern void serializer_test();
 extern void spi_util_test();
+extern void spsc_ring_test();
 extern void static_callable_test();
 extern void static_list_test();
 extern void steady_clock_utility_test();
 extern void timeout_test();
+extern void timer_wheel_test();
 extern void units_test();
+extern void virtual_steady_clock_test();
+extern void worker_scheduler_test();
 
 extern void stream_terminated_test();
 extern void parse_stream_test();
+extern void parse_number_stream_test();
 extern void find_stream_test();
+extern void find_any_stream_test();
 extern void fill_upto_stream_test();
+extern void pipeline_stream_test();
 extern void multi_stream_test();
 }  // namespace hal
 
@@ -44,27 +62,45 @@ int main()
 {
   hal::as_bytes_test();
   hal::bit_test();
+  hal::bit_pack_test();
+  hal::buffered_serial_test();
   hal::can_test();
+  hal::coroutine_test();
+  hal::endian_test();
   hal::enum_test();
+  hal::format_test();
   hal::i2c_util_test();
   hal::input_pin_util_test();
   hal::interrupt_pin_util_test();
+  hal::log_test();
   hal::map_test();
   hal::math_test();
   hal::move_interceptor_test();
+  hal::object_pool_test();
   hal::output_pin_util_test();
   hal::overflow_counter_test();
+  hal::profile_disabled_test();
+  hal::profile_test();
+  hal::register_test();
   hal::serial_util_test();
+  hal::serializer_test();
   hal::spi_util_test();
+  hal::spsc_ring_test();
   hal::static_callable_test();
   hal::static_list_test();
   hal::steady_clock_utility_test();
   hal::timeout_test();
+  hal::timer_wheel_test();
   hal::units_test();
+  hal::virtual_steady_clock_test();
+  hal::worker_scheduler_test();
 
   hal::stream_terminated_test();
   hal::parse_stream_test();
+  hal::parse_number_stream_test();
   hal::find_stream_test();
+  hal::find_any_stream_test();
   hal::fill_upto_stream_test();
+  hal::pipeline_stream_test();
   hal::multi_stream_test();
 }
@@ -0,0 +1,174 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/object_pool.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+struct tracked
+{
+  tracked(int p_value, int& p_live)
+    : value(p_value)
+    , live(&p_live)
+  {
+    (*live)++;
+  }
+
+  tracked(const tracked&) = delete;
+  tracked& operator=(const tracked&) = delete;
+
+  ~tracked()
+  {
+    (*live)--;
+  }
+
+  int value;
+  int* live;
+};
+}  // namespace
+
+void object_pool_test()
+{
+  using namespace boost::ut;
+
+  "hal::object_pool::emplace constructs and handle destroys"_test = []() {
+    // Setup
+    int live = 0;
+    object_pool<tracked, 4> pool;
+
+    {
+      // Exercise
+      auto first = pool.emplace(5, live);
+      auto second = pool.emplace(7, live);
+
+      // Verify
+      expect(static_cast<bool>(first));
+      expect(that % 5 == first->value);
+      expect(that % 7 == (*second).value);
+      expect(that % 2 == live);
+      expect(that % 2 == pool.available());
+    }
+
+    // Verify
+    expect(that % 0 == live);
+    expect(that % 4 == pool.available());
+  };
+
+  "hal::object_pool exhaustion and reuse"_test = []() {
+    // Setup
+    int live = 0;
+    object_pool<tracked, 40> pool;
+    std::vector<object_pool<tracked, 40>::handle> handles;
+
+    // Exercise
+    for (int index = 0; index < 40; index++) {
+      handles.push_back(pool.emplace(index, live));
+    }
+    auto overflow = pool.emplace(-1, live);
+    const auto* freed = handles[33].get();
+    handles[33].reset();
+    auto reused = pool.emplace(100, live);
+
+    // Verify
+    expect(!overflow);
+    expect(that % 40 == live);
+    expect(that % 0 == pool.available());
+    expect(!handles[33]);
+    expect(freed == reused.get());
+    expect(that % 100 == reused->value);
+  };
+
+  "hal::object_pool reuses the lowest free slot"_test = []() {
+    // Setup
+    object_pool<std::uint32_t, 8> pool;
+    auto first = pool.emplace(1U);
+    auto second = pool.emplace(2U);
+    auto third = pool.emplace(3U);
+    const auto* second_address = second.get();
+
+    // Exercise
+    second.reset();
+    third.reset();
+    auto fourth = pool.emplace(4U);
+
+    // Verify
+    expect(second_address == fourth.get());
+    expect(that % 6 == pool.available());
+  };
+
+  "hal::pool_ptr move"_test = []() {
+    // Setup
+    int live = 0;
+    object_pool<tracked, 2> pool;
+    auto first = pool.emplace(1, live);
+    auto second = pool.emplace(2, live);
+
+    // Exercise
+    object_pool<tracked, 2>::handle moved(std::move(first));
+    second = std::move(moved);
+
+    // Verify
+    expect(!first);
+    expect(!moved);
+    expect(that % 1 == second->value);
+    expect(that % 1 == live);
+    expect(that % 1 == pool.available());
+  };
+
+  "hal::atomic_object_pool shared between threads"_test = []() {
+    // Setup
+    constexpr int thread_count = 4;
+    constexpr int iterations = 20'000;
+    static atomic_object_pool<std::array<std::uint32_t, 4>, 8> pool;
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+
+    // Exercise
+    for (int id = 0; id < thread_count; id++) {
+      threads.emplace_back([id, &failures]() {
+        const auto tag = static_cast<std::uint32_t>(id);
+        for (int index = 0; index < iterations; index++) {
+          auto object = pool.emplace();
+          if (!object) {
+            continue;
+          }
+          object->fill(tag);
+          std::this_thread::yield();
+          for (const auto value : *object) {
+            if (value != tag) {
+              failures++;
+            }
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    // Verify
+    expect(that % 0 == failures.load());
+    expect(that % 8 == pool.available());
+  };
+};
+}  // namespace hal
@@ -14,6 +14,12 @@
 
 #include <libhal-util/overflow_counter.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
 #include <boost/ut.hpp>
 
 namespace hal {
@@ -121,5 +127,120 @@ void overflow_counter_test()
 
     expect(that % 0x00A == counter.update(0xA));
   };
+
+  "concurrent_overflow_counter::update() overflow w/ 8 bits"_test = []() {
+    // Setup
+    concurrent_overflow_counter<8> counter;
+
+    // Exercise & Verify
+    expect(that % 0x00A == counter.update(0xA));
+    expect(that % 0x070 == counter.update(0x70));
+    expect(that % 0x0E0 == counter.update(0xE0));
+    expect(that % 0x105 == counter.update(0x105));
+    expect(that % 0x150 == counter.update(0x50));
+    expect(that % 0x1C0 == counter.update(0xC0));
+    expect(that % 0x200 == counter.update(0x0));
+    expect(that % 0x200 == counter.update(0x0));
+    expect(that % 0x200 == counter.value());
+
+    counter.reset(0xF0);
+
+    expect(that % 0x0F0 == counter.value());
+    expect(that % 0x10A == counter.update(0xA));
+  };
+
+  "concurrent_overflow_counter::update() ignores stale readings"_test = []() {
+    // Setup
+    concurrent_overflow_counter<8> counter(0xF0);
+    counter.update(0x02);
+
+    // Exercise
+    // A context read 0xFE before an interrupt recorded 0x02
+    const auto stale = counter.update(0xFE);
+    const auto next = counter.update(0x03);
+
+    // Verify
+    expect(that % 0x102 == stale);
+    expect(that % 0x103 == next);
+  };
+
+  "concurrent_overflow_counter::update() past 32 bits"_test = []() {
+    // Setup
+    concurrent_overflow_counter<32> counter(0x7FFF'FFF0);
+
+    // Exercise & Verify
+    expect(that % 0x0'8000'0010ULL == counter.update(0x8000'0010));
+    expect(that % 0x0'FFFF'FFF0ULL == counter.update(0xFFFF'FFF0));
+    expect(that % 0x1'0000'0010ULL == counter.update(0x0000'0010));
+    expect(that % 0x1'0000'0010ULL == counter.update(0xFFFF'FFFF));
+    expect(that % 0x1'7FFF'FFFFULL == counter.update(0x7FFF'FFFF));
+    expect(that % 0x1'8000'0000ULL == counter.update(0x8000'0000));
+    expect(that % 0x1'C000'0000ULL == counter.update(0xC000'0000));
+    expect(that % 0x2'0000'0005ULL == counter.update(0x0000'0005));
+    expect(that % 0x2'0000'0005ULL == counter.value());
+
+    counter.reset(0xFFFF'FFF0);
+
+    expect(that % 0x0'FFFF'FFF0ULL == counter.value());
+    expect(that % 0x1'0000'000AULL == counter.update(0xA));
+  };
+
+  "concurrent_overflow_counter multi-threaded stress"_test = []() {
+    // Setup
+    // Each thread plays both the hardware counter, by incrementing it, and a
+    // context reading it. The count starts just below the 32-bit limit so
+    // that it overflows during the test.
+    static constexpr std::uint64_t start = 0xFFF8'0000;
+    static constexpr std::uint32_t increments_per_thread = 250'000;
+    static constexpr size_t thread_count = 4;
+    concurrent_overflow_counter<32> counter(static_cast<std::uint32_t>(start));
+    std::atomic<std::uint64_t> hardware_count = start;
+    std::atomic<bool> done = false;
+    std::array<bool, thread_count> monotonic{};
+    std::array<bool, thread_count> up_to_date{};
+    bool reader_monotonic = true;
+
+    // Exercise
+    std::thread reader([&]() {
+      std::uint64_t previous = 0;
+      while (!done.load()) {
+        const auto current = counter.value();
+        reader_monotonic = reader_monotonic && current >= previous;
+        previous = current;
+      }
+    });
+
+    std::vector<std::thread> threads;
+    for (size_t index = 0; index < thread_count; index++) {
+      threads.emplace_back([&, index]() {
+        monotonic[index] = true;
+        up_to_date[index] = true;
+        std::uint64_t previous = 0;
+        for (std::uint32_t i = 0; i < increments_per_thread; i++) {
+          const auto actual = hardware_count.fetch_add(1) + 1;
+          const auto extended = counter.update(static_cast<uint32_t>(actual));
+          monotonic[index] = monotonic[index] && extended >= previous;
+          up_to_date[index] = up_to_date[index] && extended >= actual;
+          previous = extended;
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    done = true;
+    reader.join();
+
+    // Verify
+    const std::uint64_t expected_total =
+      start + thread_count * increments_per_thread;
+    for (size_t index = 0; index < thread_count; index++) {
+      expect(that % monotonic[index]);
+      expect(that % up_to_date[index]);
+    }
+    expect(that % reader_monotonic);
+    expect(that % expected_total == counter.value());
+    expect(that % expected_total == hardware_count.load());
+  };
 };
 }  // namespace hal
@@ -0,0 +1,190 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/profile.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+struct profile_test_serial : public hal::serial
+{
+  status driver_configure(const settings&) override
+  {
+    return success();
+  }
+
+  result<write_t> driver_write(std::span<const hal::byte> p_data) override
+  {
+    m_out.append(p_data.begin(), p_data.end());
+    return write_t{ p_data };
+  }
+
+  result<read_t> driver_read(std::span<hal::byte> p_data) override
+  {
+    return read_t{ .data = p_data.first(0), .available = 0, .capacity = 0 };
+  }
+
+  result<flush_t> driver_flush() override
+  {
+    return flush_t{};
+  }
+
+  std::string m_out{};
+};
+
+/// Advances by a fixed number of ticks on every uptime() call
+struct stepping_clock : public hal::steady_clock
+{
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    const auto now = m_uptime;
+    m_uptime += m_step;
+    return uptime_t{ .ticks = now };
+  }
+
+  std::uint64_t m_uptime = 0;
+  std::uint64_t m_step = 1;
+};
+}  // namespace
+
+void profile_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::latency_histogram buckets"_test = []() {
+    using histogram = latency_histogram<3, 32>;
+
+    // Verify: every value falls within the bounds of its bucket
+    for (std::uint64_t value = 0; value < 5'000; value++) {
+      const auto bucket = histogram::bucket_of(value);
+      expect(that % histogram::lowest_in(bucket) <= value);
+      expect(that % value <= histogram::highest_in(bucket));
+    }
+
+    // Verify: the first buckets are exact, later ones are within 12.5%
+    static_assert(histogram::bucket_of(7) == 7);
+    static_assert(histogram::bucket_of(8) == 8);
+    static_assert(histogram::lowest_in(histogram::bucket_of(1000)) == 960);
+    static_assert(histogram::highest_in(histogram::bucket_of(1000)) == 1023);
+    static_assert(histogram::bucket_of(UINT64_MAX) ==
+                  histogram::bucket_count - 1);
+    static_assert(histogram::bucket_of(std::uint64_t{ 1 } << 32) ==
+                  histogram::bucket_count - 1);
+    expect(that % 240 == histogram::bucket_count);
+  };
+
+  "hal::latency_histogram statistics"_test = []() {
+    // Setup
+    latency_histogram<> histogram;
+    latency_histogram<> empty;
+
+    // Exercise
+    for (std::uint64_t value = 1; value <= 100; value++) {
+      histogram.record(value);
+    }
+    histogram.record(10'000);
+
+    // Verify
+    expect(that % 101 == histogram.count());
+    expect(that % 1 == histogram.min());
+    expect(that % 10'000 == histogram.max());
+    expect(that % 149 == histogram.mean());
+    expect(that % 51 == histogram.percentile(500));
+    expect(that % 95 == histogram.percentile(900));
+    expect(that % 10'000 == histogram.percentile(1000));
+    expect(that % 10'000 == histogram.percentile(5000));
+    expect(that % 1 == histogram.percentile(0));
+    expect(that % 0 == empty.percentile(500));
+    expect(that % 0 == empty.min());
+    expect(that % 0 == empty.mean());
+
+    // Exercise
+    histogram.reset();
+
+    // Verify
+    expect(that % 0 == histogram.count());
+    expect(that % 0 == histogram.max());
+  };
+
+  "hal::stopwatch"_test = []() {
+    // Setup
+    stepping_clock clock;
+    clock.m_step = 10;
+
+    // Exercise
+    stopwatch watch(clock);
+    const auto first = watch.elapsed();
+    const auto lap = watch.lap();
+    const auto after_lap = watch.elapsed();
+    watch.restart();
+    const auto after_restart = watch.elapsed();
+
+    // Verify
+    expect(that % 10 == first);
+    expect(that % 20 == lap);
+    expect(that % 10 == after_lap);
+    expect(that % 10 == after_restart);
+  };
+
+  "hal::scoped_probe and HAL_PROBE"_test = []() {
+    // Setup
+    stepping_clock clock;
+    clock.m_step = 40;
+    latency_histogram<> histogram;
+
+    // Exercise
+    {
+      scoped_probe probe(histogram, clock);
+    }
+    for (int call = 0; call < 3; call++) {
+      HAL_PROBE(histogram, clock);
+      clock.m_uptime += 2;
+    }
+
+    // Verify
+    expect(that % 4 == histogram.count());
+    expect(that % 40 == histogram.min());
+    expect(that % 42 == histogram.max());
+  };
+
+  "hal::dump_histogram()"_test = []() {
+    // Setup
+    profile_test_serial serial;
+    latency_histogram<> histogram;
+    histogram.record(3);
+    histogram.record(3);
+    histogram.record(1000);
+
+    // Exercise
+    dump_histogram(serial, "write", histogram);
+
+    // Verify
+    expect(that % "write: count=3 min=3 mean=335 p50=3 p90=1000 p99=1000 "
+                  "max=1000 ticks\n"
+                  "  [3, 3] 2\n"
+                  "  [960, 1000] 1\n"sv == serial.m_out);
+  };
+}
+}  // namespace hal
@@ -0,0 +1,81 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Must come before any include so HAL_PROBE expands to its disabled form
+#define LIBHAL_UTIL_DISABLE_PROBES
+
+#include <libhal-util/profile.hpp>
+
+#include <cstdint>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+/// Counts every read so a probe that touches the clock is caught
+struct counting_clock : public hal::steady_clock
+{
+  frequency_t driver_frequency() override
+  {
+    m_frequency_reads++;
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    m_uptime_reads++;
+    return uptime_t{ .ticks = m_uptime_reads * 40 };
+  }
+
+  std::uint64_t m_frequency_reads = 0;
+  std::uint64_t m_uptime_reads = 0;
+};
+
+/// Parameters only named by HAL_PROBE must not trip -Wunused-parameter
+void probed_function(latency_histogram<>& p_histogram,
+                     hal::steady_clock& p_clock)
+{
+  HAL_PROBE(p_histogram, p_clock);
+}
+}  // namespace
+
+void profile_disabled_test()
+{
+  using namespace boost::ut;
+
+  "HAL_PROBE with LIBHAL_UTIL_DISABLE_PROBES"_test = []() {
+    // Setup
+    counting_clock clock;
+    latency_histogram<> histogram;
+    int evaluations = 0;
+    auto counted_clock = [&clock, &evaluations]() -> hal::steady_clock& {
+      evaluations++;
+      return clock;
+    };
+
+    // Exercise
+    for (int call = 0; call < 3; call++) {
+      HAL_PROBE(histogram, clock);
+      HAL_PROBE(histogram, counted_clock());
+      probed_function(histogram, clock);
+    }
+
+    // Verify
+    expect(that % 0 == histogram.count());
+    expect(that % 0 == evaluations);
+    expect(that % 0 == clock.m_uptime_reads);
+    expect(that % 0 == clock.m_frequency_reads);
+  };
+};
+}  // namespace hal
@@ -0,0 +1,144 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/register.hpp>
+
+#include <cstdint>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+/// Register that counts the volatile reads and writes made to it
+struct counting_register
+{
+  operator std::uint32_t() const volatile
+  {
+    reads = reads + 1;
+    return value;
+  }
+
+  void operator=(std::uint32_t p_value) volatile
+  {
+    writes = writes + 1;
+    value = p_value;
+  }
+
+  std::uint32_t value = 0;
+  mutable int reads = 0;
+  int writes = 0;
+};
+
+constexpr field enable{ bit_mask::from<0>() };
+constexpr field mode{ bit_mask::from<1, 2>() };
+constexpr field divider{ bit_mask::from<4, 7>() };
+constexpr field busy{ bit_mask::from<8>(), field_access::read_only };
+constexpr field trigger{ bit_mask::from<9>(), field_access::write_only };
+constexpr field done{ bit_mask::from<31>(), field_access::write_one_to_clear };
+
+using control =
+  register_layout<std::uint32_t, enable, mode, divider, busy, trigger, done>;
+}  // namespace
+
+void register_test()
+{
+  using namespace boost::ut;
+
+  "hal::modify folds fields into one read and one write"_test = []() {
+    // Setup
+    volatile counting_register control_register{ .value = 0x8000'F1F6 };
+
+    // Exercise
+    modify<control>(control_register)
+      .set<enable>()
+      .insert<divider>(0x5U)
+      .clear<mode>()
+      .set<trigger>();
+    const std::uint32_t value = control_register.value;
+    const int reads = control_register.reads;
+    const int writes = control_register.writes;
+
+    // Verify
+    expect(that % 0x0000'F351 == value);
+    expect(that % 1 == reads);
+    expect(that % 1 == writes);
+  };
+
+  "hal::modify clears write-one-to-clear flags only when asked"_test = []() {
+    // Setup
+    volatile std::uint32_t untouched = 0x8000'0100;
+    volatile std::uint32_t acknowledged = 0x8000'0100;
+
+    // Exercise
+    modify<control>(untouched).set<enable>();
+    modify<control>(acknowledged).clear<done>().set<enable>();
+
+    // Verify
+    expect(that % 0x0000'0101 == untouched);
+    expect(that % 0x8000'0101 == acknowledged);
+  };
+
+  "hal::modify later operations win"_test = []() {
+    // Setup
+    volatile std::uint32_t control_register = 0x0000'0006;
+
+    // Exercise
+    modify<control>(control_register)
+      .insert<divider>(0xFFU)
+      .clear<divider>()
+      .insert<mode>(0x1U)
+      .set<mode>()
+      .set<enable>()
+      .clear<enable>();
+
+    // Verify
+    expect(that % 0x0000'0006 == control_register);
+  };
+
+  "hal::modify skips the read when every bit is written"_test = []() {
+    // Setup
+    constexpr field low{ bit_mask::from<0, 15>() };
+    constexpr field high{ bit_mask::from<16, 31>() };
+    volatile counting_register data_register;
+
+    // Exercise
+    modify<register_layout<std::uint32_t>>(data_register)
+      .insert<low>(0x1234U)
+      .insert<high>(0xABCDU);
+    const std::uint32_t value = data_register.value;
+    const int reads = data_register.reads;
+    const int writes = data_register.writes;
+
+    // Verify
+    expect(that % 0xABCD'1234 == value);
+    expect(that % 0 == reads);
+    expect(that % 1 == writes);
+  };
+
+  "hal::modify without a layout and hal::extract"_test = []() {
+    // Setup
+    volatile std::uint8_t status_register = 0b1000'0001;
+
+    // Exercise
+    modify(status_register).insert<field{ bit_mask::from<4, 6>() }>(0x6U);
+    const auto divided = extract<divider>(status_register);
+    const auto is_busy = extract<field{ bit_mask::from<7>() }>(status_register);
+
+    // Verify
+    expect(that % 0b1110'0001 == status_register);
+    expect(that % 0xE == divided);
+    expect(that % 1 == is_busy);
+  };
+};
+}  // namespace hal
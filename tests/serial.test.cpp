@@ -16,16 +16,107 @@
 
 #include <algorithm>
 #include <array>
+#include <limits>
 #include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <libhal-util/comparison.hpp>
+#include <libhal-util/serial_coroutines.hpp>
 
 #include <boost/ut.hpp>
 
 namespace hal {
+namespace {
+/// Serial port that receives a scripted list of chunks. Each read returns
+/// bytes from the current chunk only, as if the rest had not arrived yet.
+class scripted_serial : public hal::serial
+{
+public:
+  explicit scripted_serial(std::vector<std::string_view> p_chunks)
+    : m_chunks(std::move(p_chunks))
+  {
+  }
+
+  /// Bytes of the current chunk not read yet, or the next chunk if the
+  /// current one has been read completely
+  std::string_view unread() const
+  {
+    if (m_chunk >= m_chunks.size()) {
+      return {};
+    }
+    const auto pending = m_chunks[m_chunk].substr(m_offset);
+    if (pending.empty() && m_chunk + 1 < m_chunks.size()) {
+      return m_chunks[m_chunk + 1];
+    }
+    return pending;
+  }
+
+  int m_read_count = 0;
+
+private:
+  status driver_configure(const settings&) override
+  {
+    return {};
+  }
+
+  result<write_t> driver_write(std::span<const hal::byte> p_data) override
+  {
+    return write_t{ p_data };
+  }
+
+  result<read_t> driver_read(std::span<hal::byte> p_data) override
+  {
+    m_read_count++;
+    if (m_chunk < m_chunks.size() && m_offset == m_chunks[m_chunk].size()) {
+      m_chunk++;
+      m_offset = 0;
+    }
+
+    const auto pending = unread();
+    const auto count = std::min(p_data.size(), pending.size());
+    std::copy_n(pending.begin(), count, p_data.begin());
+    m_offset += count;
+
+    return read_t{
+      .data = p_data.first(count),
+      .available = pending.size() - count,
+      .capacity = 64,
+    };
+  }
+
+  result<flush_t> driver_flush() override
+  {
+    return flush_t{};
+  }
+
+  std::vector<std::string_view> m_chunks;
+  size_t m_chunk = 0;
+  size_t m_offset = 0;
+};
+
+std::string_view to_string_view(std::span<const hal::byte> p_bytes)
+{
+  return { reinterpret_cast<const char*>(p_bytes.data()), p_bytes.size() };
+}
+
+template<size_t N>
+constexpr auto to_bytes(const char (&p_string)[N])
+{
+  std::array<hal::byte, N - 1> bytes{};
+  for (size_t index = 0; index < bytes.size(); index++) {
+    bytes[index] = static_cast<hal::byte>(p_string[index]);
+  }
+  return bytes;
+}
+}  // namespace
+
 void serial_util_test()
 {
   using namespace boost::ut;
+  using namespace std::literals;
 
   static constexpr hal::byte write_failure_byte{ 'C' };
   static constexpr hal::byte filler_byte{ 'A' };
@@ -377,8 +468,10 @@ void serial_util_test()
 
     result<write_t> driver_write(std::span<const hal::byte> p_data) override
     {
-      m_out.assign(p_data.begin(), p_data.end());
-      return write_t{ p_data };
+      const auto accepted = p_data.first(std::min(p_data.size(), m_max_write));
+      m_out.insert(m_out.end(), accepted.begin(), accepted.end());
+      m_write_call_count++;
+      return write_t{ accepted };
     }
 
     result<read_t> driver_read(std::span<hal::byte>) override
@@ -394,6 +487,55 @@ void serial_util_test()
     ~save_serial_write() override = default;
 
     std::vector<hal::byte> m_out{};
+    size_t m_max_write = std::numeric_limits<size_t>::max();
+    int m_write_call_count = 0;
+  };
+
+  "write(serial, segments...)"_test = []() {
+    "[gathered] write(serial, segments...)"_test = []() {
+      // Setup
+      save_serial_write serial;
+      const std::array<hal::byte, 2> header{ 'h', 'd' };
+      const std::array<hal::byte, 3> payload{ 'a', 'b', 'c' };
+      const std::array<hal::byte, 1> crc{ 'z' };
+
+      // Exercise
+      auto result = write(serial, header, payload, crc);
+
+      // Verify
+      expect(bool{ result });
+      expect(that % 1 == serial.m_write_call_count);
+      expect(
+        that % "hdabcz"sv ==
+        std::string_view(reinterpret_cast<const char*>(serial.m_out.data()),
+                         serial.m_out.size()));
+    };
+
+    "[large and partial] write(serial, segments...)"_test = []() {
+      // Setup
+      save_serial_write serial;
+      serial.m_max_write = 7;
+      const std::array<hal::byte, 2> header{ 'h', 'd' };
+      std::array<hal::byte, write_gather_size + 3> payload{};
+      payload.fill('p');
+      const std::array<hal::byte, 2> crc{ 'c', 'c' };
+      const std::array<std::span<const hal::byte>, 3> segments{ header,
+                                                                payload,
+                                                                crc };
+      std::vector<hal::byte> expected(header.begin(), header.end());
+      expected.insert(expected.end(), payload.begin(), payload.end());
+      expected.insert(expected.end(), crc.begin(), crc.end());
+
+      // Exercise
+      auto result = write(serial, segments);
+
+      // Verify
+      // 1 call for the header, 5 calls to drain the 35 byte payload 7 bytes
+      // at a time, then 1 call for the crc
+      expect(bool{ result });
+      expect(that % 7 == serial.m_write_call_count);
+      expect(expected == serial.m_out);
+    };
   };
 
   "print()"_test = []() {
@@ -456,6 +598,278 @@ void serial_util_test()
         std::string_view(reinterpret_cast<const char*>(serial.m_out.data()),
                          serial.m_out.size()));
     };
+
+    "[format string] print()"_test = []() {
+      // Setup
+      save_serial_write serial;
+      const std::string_view expected_payload = "hello 5 0xABCDEF 2.50";
+
+      // Exercise
+      print(serial, "hello {} 0x{:06X} {:.2f}", 5, 0xABCDEF, 2.5);
+
+      // Verify
+      expect(that % 1 == serial.m_write_call_count);
+      expect(
+        that % expected_payload ==
+        std::string_view(reinterpret_cast<const char*>(serial.m_out.data()),
+                         serial.m_out.size()));
+    };
+
+    "[format string longer than a chunk] print()"_test = []() {
+      // Setup
+      save_serial_write serial;
+      std::string expected_payload;
+      for (int index = 0; index < 20; index++) {
+        expected_payload += "id=" + std::to_string(index) + ";";
+      }
+      expected_payload += std::string(print_chunk_size, 'z');
+
+      // Exercise
+      print(serial,
+            "id={};id={};id={};id={};id={};id={};id={};id={};id={};id={};"
+            "id={};id={};id={};id={};id={};id={};id={};id={};id={};id={};{}",
+            0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+            10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+            std::string_view(expected_payload).substr(expected_payload.size() -
+                                                      print_chunk_size));
+
+      // Verify
+      // The first 64 bytes fill the chunk, the remaining text is flushed
+      // before the long argument, which is written in place.
+      expect(that % 3 == serial.m_write_call_count);
+      expect(
+        that % std::string_view(expected_payload) ==
+        std::string_view(reinterpret_cast<const char*>(serial.m_out.data()),
+                         serial.m_out.size()));
+    };
+  };
+
+  "skip_past(serial, sequence, prefix_table, scratch)"_test = []() {
+    "[prefix table] self-overlapping sequence"_test = []() {
+      // Exercise & Verify
+      static_assert(make_prefix_table(to_bytes("abab")) ==
+                    std::array<size_t, 4>{ 0, 0, 1, 2 });
+      static_assert(make_prefix_table(to_bytes("aabaaab")) ==
+                    std::array<size_t, 7>{ 0, 1, 0, 1, 2, 2, 3 });
+    };
+
+    "[overlapping] skip_past finds aab in aaab"_test = []() {
+      // Setup
+      static constexpr auto sequence = to_bytes("aab");
+      static constexpr auto table = make_prefix_table(sequence);
+      std::array<hal::byte, 16> scratch{};
+      scripted_serial serial({ "aaabXYZ" });
+      skip_past skip(serial, sequence, table, scratch);
+
+      // Exercise
+      auto result = skip();
+
+      // Verify
+      expect(bool{ result });
+      expect(that % work_state::finished == result.value());
+      expect(that % "XYZ"sv == to_string_view(skip.remaining()));
+    };
+
+    "[split] skip_past finds a sequence across two reads"_test = []() {
+      // Setup
+      static constexpr auto sequence = to_bytes("SYNC");
+      static constexpr auto table = make_prefix_table(sequence);
+      std::array<hal::byte, 16> scratch{};
+      scripted_serial serial({ "xxSY", "NCtail" });
+      skip_past skip(serial, sequence, table, scratch);
+
+      // Exercise
+      auto first = skip();
+      auto second = skip();
+
+      // Verify
+      expect(that % work_state::in_progress == first.value());
+      expect(that % work_state::finished == second.value());
+      expect(that % "tail"sv == to_string_view(skip.remaining()));
+      expect(that % 2 == serial.m_read_count);
+    };
+
+    "[remaining] skip_past keeps bytes read past the sequence"_test = []() {
+      // Setup
+      static constexpr auto sequence = to_bytes("\r\n");
+      static constexpr auto table = make_prefix_table(sequence);
+      std::array<hal::byte, 4> scratch{};
+      scripted_serial serial({ "abcd", "e\r\nf", "gh" });
+      skip_past skip(serial, sequence, table, scratch);
+
+      // Exercise
+      auto result = skip();
+      auto remaining = to_string_view(skip.remaining());
+      auto repeat = skip();
+
+      // Verify
+      expect(that % work_state::finished == result.value());
+      expect(that % "f"sv == remaining);
+      expect(that % work_state::finished == repeat.value());
+      expect(that % "gh"sv == serial.unread());
+    };
+
+    "[read limit] skip_past stops after the read limit"_test = []() {
+      // Setup
+      static constexpr auto sequence = to_bytes("!");
+      static constexpr auto table = make_prefix_table(sequence);
+      std::array<hal::byte, 2> scratch{};
+      scripted_serial serial({ "abcdefgh!" });
+      skip_past skip(serial, sequence, table, scratch, 3);
+
+      // Exercise
+      auto first = skip();
+      auto first_read_count = serial.m_read_count;
+      auto unread = serial.unread();
+      auto second = skip();
+
+      // Verify
+      expect(that % work_state::in_progress == first.value());
+      expect(that % 3 == first_read_count);
+      expect(that % "gh!"sv == unread);
+      expect(that % work_state::finished == second.value());
+      expect(that % 0 == skip.remaining().size());
+    };
+  };
+
+  "read_upto_chunked(serial, sequence, buffer)"_test = []() {
+    "[split] terminator across two reads"_test = []() {
+      // Setup
+      static constexpr auto terminator = to_bytes("\r\n");
+      std::array<hal::byte, 32> buffer{};
+      scripted_serial serial({ "hello\r", "\nworld" });
+      read_upto_chunked read_line(serial, terminator, buffer);
+
+      // Exercise
+      auto first = read_line();
+      auto first_span = to_string_view(read_line.span());
+      auto second = read_line();
+
+      // Verify
+      expect(that % work_state::in_progress == first.value());
+      expect(that % "hello\r"sv == first_span);
+      expect(that % work_state::finished == second.value());
+      expect(that % "hello\r\n"sv == to_string_view(read_line.span()));
+      expect(that % "world"sv == to_string_view(read_line.remaining()));
+    };
+
+    "[overshoot] span and remaining after one read"_test = []() {
+      // Setup
+      static constexpr auto terminator = to_bytes("\n");
+      std::array<hal::byte, 32> buffer{};
+      scripted_serial serial({ "a\nb\nc" });
+      read_upto_chunked read_line(serial, terminator, buffer);
+
+      // Exercise
+      auto result = read_line();
+
+      // Verify
+      expect(that % work_state::finished == result.value());
+      expect(that % "a\n"sv == to_string_view(read_line.span()));
+      expect(that % "b\nc"sv == to_string_view(read_line.remaining()));
+      expect(that % 1 == serial.m_read_count);
+    };
+
+    "[failure] full buffer without terminator"_test = []() {
+      // Setup
+      static constexpr auto terminator = to_bytes("\n");
+      std::array<hal::byte, 4> buffer{};
+      scripted_serial serial({ "abcdefgh" });
+      read_upto_chunked read_line(serial, terminator, buffer);
+
+      // Exercise
+      auto result = read_line();
+      auto repeat = read_line();
+
+      // Verify
+      expect(that % work_state::failed == result.value());
+      expect(that % work_state::failed == repeat.value());
+      expect(that % "abcd"sv == to_string_view(read_line.span()));
+      expect(that % 0 == read_line.remaining().size());
+      expect(that % 1 == serial.m_read_count);
+    };
+
+    "[in progress] nothing more available"_test = []() {
+      // Setup
+      static constexpr auto terminator = to_bytes("\n");
+      std::array<hal::byte, 32> buffer{};
+      scripted_serial serial({ "abc" });
+      read_upto_chunked read_line(serial, terminator, buffer);
+
+      // Exercise
+      auto result = read_line();
+
+      // Verify
+      expect(that % work_state::in_progress == result.value());
+      expect(that % 1 == serial.m_read_count);
+      expect(that % "abc"sv == to_string_view(read_line.span()));
+      expect(that % 0 == read_line.remaining().size());
+    };
+  };
+
+  "read_number<T>(serial)"_test = []() {
+    "[single byte] stops after the terminating byte"_test = []() {
+      // Setup
+      scripted_serial serial({ "x-42,rest" });
+      read_number<std::int32_t> read_int(serial);
+
+      // Exercise
+      auto result = read_int();
+
+      // Verify
+      expect(that % work_state::finished == result.value());
+      expect(that % -42 == read_int.get().value());
+      expect(that % "rest"sv == serial.unread());
+      expect(that % 0 == read_int.remaining().size());
+    };
+
+    "[bulk] number across two reads"_test = []() {
+      // Setup
+      std::array<hal::byte, 16> scratch{};
+      scripted_serial serial({ "12345", "6789012,tail" });
+      read_number<std::uint64_t> read_int(serial, scratch);
+
+      // Exercise
+      auto first = read_int();
+      auto pending = read_int.get();
+      auto second = read_int();
+
+      // Verify
+      expect(that % work_state::in_progress == first.value());
+      expect(!pending.has_value());
+      expect(that % work_state::finished == second.value());
+      expect(that % 123456789012ULL == read_int.get().value());
+      expect(that % ",tail"sv == to_string_view(read_int.remaining()));
+    };
+
+    "[overflow] at the 64-bit limit across two reads"_test = []() {
+      // Setup
+      std::array<hal::byte, 32> scratch{};
+      scripted_serial serial({ "1844", "6744073799999999x" });
+      read_number<std::uint64_t> read_int(serial, scratch);
+
+      // Exercise
+      auto first = read_int();
+      auto second = read_int();
+
+      // Verify
+      expect(that % work_state::in_progress == first.value());
+      expect(that % work_state::failed == second.value());
+      expect(!read_int.get().has_value());
+    };
+
+    "[hex] base 16"_test = []() {
+      // Setup
+      scripted_serial serial({ "n=0x1F;" });
+      read_number<std::uint16_t, 16> read_hex(serial);
+
+      // Exercise
+      auto result = read_hex();
+
+      // Verify
+      expect(that % work_state::finished == result.value());
+      expect(that % 0x1F == read_hex.get().value());
+    };
   };
 };
 }  // namespace hal
@@ -0,0 +1,140 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/serializer.hpp>
+
+#include <array>
+#include <cstdint>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+enum class sensor_mode : std::uint8_t
+{
+  sleep = 0,
+  single = 1,
+  continuous = 3,
+};
+
+struct reading
+{
+  std::int16_t temperature;
+  std::uint32_t pressure;
+  sensor_mode mode;
+  bool ready;
+  std::int16_t offset;
+  float gain;
+
+  constexpr bool operator==(const reading&) const = default;
+};
+
+using reading_format = serializer<
+  reading,
+  field_at<&reading::temperature, 0>,
+  field_at<&reading::pressure, 2, std::endian::little>,
+  bits_at<&reading::mode, 6, bit_mask::from<0, 1>()>,
+  bits_at<&reading::ready, 6, bit_mask::from<7>()>,
+  bits_at<&reading::offset,
+          7,
+          bit_mask::from<4, 15>(),
+          std::uint16_t,
+          std::endian::little>,
+  field_at<&reading::gain, 9>>;
+
+constexpr reading example{
+  .temperature = -2,
+  .pressure = 0x0001'86A0,
+  .mode = sensor_mode::continuous,
+  .ready = true,
+  .offset = -100,
+  .gain = 1.5f,
+};
+}  // namespace
+
+void serializer_test()
+{
+  using namespace boost::ut;
+
+  "hal::serializer size"_test = []() {
+    // Verify
+    static_assert(reading_format::size == 13);
+    static_assert(serializer<reading>::size == 0);
+    static_assert(
+      serializer<reading, field_at<&reading::pressure, 4>>::size == 8);
+  };
+
+  "hal::serializer::pack"_test = []() {
+    // Setup
+    constexpr std::array<hal::byte, 13> expected{
+      0xFF, 0xFE,             // temperature, big endian
+      0xA0, 0x86, 0x01, 0x00, // pressure, little endian
+      0x83,                   // ready in bit 7, mode in bits 0-1
+      0xC0, 0xF9,             // -100 in bits 4-15, little endian
+      0x3F, 0xC0, 0x00, 0x00, // 1.5f, big endian
+    };
+
+    // Exercise
+    constexpr auto packed = reading_format::pack(example);
+
+    // Verify
+    static_assert(packed == expected);
+  };
+
+  "hal::serializer::unpack"_test = []() {
+    // Exercise
+    constexpr auto unpacked =
+      reading_format::unpack(reading_format::pack(example));
+
+    // Verify
+    static_assert(unpacked == example);
+  };
+
+  "hal::serializer::unpack ignores bits outside fields"_test = []() {
+    // Setup
+    reading_format::buffer_t buffer{};
+    buffer.fill(0xFF);
+
+    // Exercise
+    const auto unpacked = reading_format::unpack(buffer);
+
+    // Verify
+    expect(that % -1 == unpacked.temperature);
+    expect(that % 0xFFFF'FFFF == unpacked.pressure);
+    expect(sensor_mode::continuous == unpacked.mode);
+    expect(unpacked.ready);
+    expect(that % -1 == unpacked.offset);
+  };
+
+  "hal::serializer round trips at runtime"_test = []() {
+    // Setup
+    reading value{
+      .temperature = 12345,
+      .pressure = 0xDEAD'BEEF,
+      .mode = sensor_mode::single,
+      .ready = false,
+      .offset = 2047,
+      .gain = -0.25f,
+    };
+
+    // Exercise
+    const auto packed = reading_format::pack(value);
+    const auto unpacked = reading_format::unpack(packed);
+
+    // Verify
+    expect(value == unpacked);
+    expect(that % 0x01 == packed[6]);
+  };
+};
+}  // namespace hal
@@ -0,0 +1,155 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/spsc_ring.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <thread>
+
+#include <libhal-util/as_bytes.hpp>
+#include <libhal-util/streams.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+void spsc_ring_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::spsc_ring push/pop single elements"_test = []() {
+    // Setup
+    spsc_ring<int, 4> ring;
+
+    // Exercise
+    const bool pushed = ring.push(1) && ring.push(2) && ring.push(3) &&
+                        ring.push(4);
+    const bool overflowed = ring.push(5);
+    const auto first = ring.pop();
+    const auto second = ring.pop();
+
+    // Verify
+    expect(that % pushed);
+    expect(that % !overflowed);
+    expect(that % 1 == first.value());
+    expect(that % 2 == second.value());
+    expect(that % 2 == ring.size());
+    expect(that % 4 == ring.capacity());
+  };
+
+  "hal::spsc_ring bulk push/pop across the wrap point"_test = []() {
+    // Setup
+    spsc_ring<hal::byte, 8> ring;
+    const std::array<hal::byte, 6> first_batch{ 1, 2, 3, 4, 5, 6 };
+    const std::array<hal::byte, 6> second_batch{ 7, 8, 9, 10, 11, 12 };
+    std::array<hal::byte, 8> output{};
+
+    // Exercise
+    const auto pushed_first = ring.push(first_batch);
+    const auto popped_first = ring.pop(std::span(output).first(5));
+    const auto pushed_second = ring.push(second_batch);
+    const auto view = ring.peek();
+    const auto popped_second = ring.pop(output);
+
+    // Verify
+    expect(that % 6 == pushed_first);
+    expect(that % 5 == popped_first);
+    expect(that % 6 == pushed_second);
+    expect(that % 3 == view.first.size());
+    expect(that % 4 == view.second.size());
+    expect(that % 7 == popped_second);
+    expect(that % 6 == output[0]);
+    expect(that % 12 == output[6]);
+    expect(that % ring.empty());
+  };
+
+  "hal::spsc_ring push stops when full"_test = []() {
+    // Setup
+    spsc_ring<hal::byte, 4> ring;
+    const std::array<hal::byte, 6> input{ 1, 2, 3, 4, 5, 6 };
+
+    // Exercise
+    const auto pushed = ring.push(input);
+
+    // Verify
+    expect(that % 4 == pushed);
+    expect(that % ring.full());
+    expect(that % 0 == ring.push(input));
+  };
+
+  "hal::spsc_ring peek feeds stream stages"_test = []() {
+    // Setup
+    spsc_ring<hal::byte, 16> ring;
+    stream_find find(as_bytes("OK"sv));
+    (void)ring.push(as_bytes("xxOKyy"sv));
+
+    // Exercise
+    const auto view = ring.peek();
+    const auto remaining = view.first | find;
+    ring.consume(view.first.size() - remaining.size());
+
+    // Verify
+    expect(that % work_state::finished == find.state());
+    expect(that % remaining.size() == ring.size());
+  };
+
+  "hal::spsc_ring multi-threaded stress"_test = []() {
+    // Setup
+    static constexpr std::uint32_t element_count = 1'000'000;
+    static spsc_ring<std::uint32_t, 256> ring;
+    bool in_order = true;
+
+    // Exercise
+    std::thread producer([]() {
+      std::array<std::uint32_t, 7> batch{};
+      std::uint32_t next = 0;
+      while (next < element_count) {
+        const auto amount =
+          std::min<std::uint32_t>(batch.size(), element_count - next);
+        for (std::uint32_t index = 0; index < amount; index++) {
+          batch[index] = next + index;
+        }
+        const auto pushed = ring.push(std::span(batch).first(amount));
+        if (pushed == 0) {
+          std::this_thread::yield();
+        }
+        next += static_cast<std::uint32_t>(pushed);
+      }
+    });
+
+    std::uint32_t expected = 0;
+    std::array<std::uint32_t, 13> output{};
+    while (expected < element_count) {
+      const auto popped = ring.pop(output);
+      if (popped == 0) {
+        std::this_thread::yield();
+      }
+      for (size_t index = 0; index < popped; index++) {
+        if (output[index] != expected++) {
+          in_order = false;
+        }
+      }
+    }
+    producer.join();
+
+    // Verify
+    expect(that % in_order);
+    expect(that % element_count == expected);
+    expect(that % ring.empty());
+  };
+}
+}  // namespace hal
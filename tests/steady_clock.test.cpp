@@ -14,6 +14,9 @@
 
 #include <libhal-util/steady_clock.hpp>
 
+#include <array>
+#include <cstdint>
+
 #include <boost/ut.hpp>
 
 // #include <libhal/testing.hpp>
@@ -234,5 +237,240 @@ void steady_clock_utility_test()
     expect(that % expected_frequency ==
            test_steady_clock.frequency().operating_frequency);
   };
-};
+
+  // =============== tick_converter ===============
+
+  "hal::tick_converter conversions are exact"_test = []() {
+    __extension__ using uint128 = unsigned __int128;
+    static constexpr std::uint64_t ns_per_second = 1'000'000'000;
+    static constexpr std::array<hal::hertz, 6> frequencies{
+      1.0f, 32'768.0f, 12'000'000.0f, 48'000'000.0f, 1e9f, 3.6e9f
+    };
+    static constexpr std::array<std::int64_t, 8> durations{
+      1, 7, 999, 1'000'000, 20'833, 1'000'000'007, 86'400'000'000'000, 1LL << 53
+    };
+
+    for (const auto frequency : frequencies) {
+      const tick_converter converter(frequency);
+      const auto whole_hertz = static_cast<std::uint64_t>(frequency);
+
+      for (const auto duration : durations) {
+        // Verify: duration -> ticks
+        const auto expected_ticks = static_cast<std::uint64_t>(
+          uint128(duration) * whole_hertz / ns_per_second);
+        expect(that % expected_ticks ==
+               converter.to_ticks(hal::time_duration(duration)))
+          << "frequency = " << frequency << ", duration = " << duration;
+
+        // Verify: ticks -> duration
+        const auto ticks = static_cast<std::uint64_t>(duration);
+        const auto expected_ns = static_cast<std::int64_t>(
+          uint128(ticks) * ns_per_second / whole_hertz);
+        if (uint128(ticks) * ns_per_second / whole_hertz < (1ULL << 63)) {
+          expect(that % expected_ns == converter.to_duration(ticks).count())
+            << "frequency = " << frequency << ", ticks = " << ticks;
+        }
+      }
+    }
+  };
+
+  "hal::tick_converter::to_ticks(frequency, duration) matches converter"_test =
+    []() {
+      static constexpr std::array<hal::hertz, 8> frequencies{
+        0.0f, 1.0f, 32'768.0f, 12'000'000.0f, 48'000'000.0f,
+        999'999'999.0f, 1e9f, 3.6e9f
+      };
+      static constexpr std::array<std::int64_t, 11> durations{
+        -5,
+        0,
+        1,
+        999'999'999,
+        1'000'000'000,
+        1'000'000'001,
+        20'833,
+        86'400'000'000'000,
+        1LL << 53,
+        1LL << 62,
+        // Largest duration whose tick count fits in 64 bits at 3.6GHz
+        5'000'000'000'000'000'000,
+      };
+
+      // Verify: usable at compile time
+      static_assert(tick_converter::to_ticks(48'000'000.0f,
+                                             hal::time_duration(1'000)) == 48);
+
+      for (const auto frequency : frequencies) {
+        const tick_converter converter(frequency);
+        for (const auto duration : durations) {
+          // Verify
+          expect(that % converter.to_ticks(hal::time_duration(duration)) ==
+                 tick_converter::to_ticks(frequency,
+                                          hal::time_duration(duration)))
+            << "frequency = " << frequency << ", duration = " << duration;
+        }
+      }
+    };
+
+  "hal::tick_converter edge cases"_test = []() {
+    constexpr tick_converter converter(48'000'000.0f);
+    constexpr tick_converter stopped(0.0f);
+
+    // Verify: usable at compile time
+    static_assert(converter.to_ticks(hal::time_duration(1'000)) == 48);
+    expect(that % 48'000'000 == converter.frequency());
+    expect(that % 0 == converter.to_ticks(hal::time_duration(-5)));
+    expect(that % 0 == converter.to_ticks(hal::time_duration(20)));
+    expect(that % 0 == stopped.to_ticks(hal::time_duration(1'000)));
+    expect(that % 0 == stopped.to_duration(1'000).count());
+  };
+
+  "hal::create_timeout(hal::steady_clock, tick_converter, 50ns)"_test = []() {
+    // Setup
+    static constexpr hal::time_duration expected(50);
+    dummy_steady_clock test_steady_clock;
+    const tick_converter converter(test_steady_clock);
+
+    // Exercise
+    auto timeout_object =
+      create_timeout(test_steady_clock, converter, expected);
+    while (timeout_object()) {
+      continue;
+    }
+
+    // Verify
+    expect(that % expected.count() == test_steady_clock.m_uptime - 1);
+  };
+
+  // =============== adaptive timeout ===============
+
+  /// One tick per microsecond, advanced by the test instead of by reads
+  class manual_steady_clock : public hal::steady_clock
+  {
+  public:
+    std::uint64_t m_uptime = 0;
+    int m_reads = 0;
+
+  private:
+    frequency_t driver_frequency() override
+    {
+      return frequency_t{ .operating_frequency = 1'000'000.0f };
+    }
+
+    uptime_t driver_uptime() override
+    {
+      m_reads++;
+      return uptime_t{ .ticks = m_uptime };
+    }
+  };
+
+  "hal::create_adaptive_timeout() bounds the overshoot"_test = []() {
+    using namespace std::literals;
+    // Setup
+    manual_steady_clock test_steady_clock;
+    test_steady_clock.m_uptime = 500;
+    constexpr std::uint64_t deadline = 500 + 10'000;
+    constexpr std::uint64_t max_overshoot = 100;
+
+    // Exercise: each poll takes one microsecond
+    auto timeout_object =
+      create_adaptive_timeout(test_steady_clock, 10ms, 100us);
+    int polls = 0;
+    while (timeout_object()) {
+      test_steady_clock.m_uptime++;
+      polls++;
+    }
+    const auto overshoot = test_steady_clock.m_uptime - deadline;
+
+    // Verify
+    expect(that % test_steady_clock.m_uptime >= deadline);
+    expect(that % overshoot <= max_overshoot);
+    expect(that % polls >= 10'000);
+    expect(that % test_steady_clock.m_reads < polls / 50);
+    expect(that % 100 == timeout_object.interval());
+  };
+
+  "hal::create_adaptive_timeout() adapts to the poll rate"_test = []() {
+    using namespace std::literals;
+    // Setup
+    manual_steady_clock test_steady_clock;
+    const tick_converter converter(test_steady_clock);
+    auto precise = create_adaptive_timeout(test_steady_clock, 1s, 0us);
+    auto coarse = create_adaptive_timeout(test_steady_clock, converter, 1s, 1s);
+
+    // Exercise: polls are slower than the overshoot, then the clock stalls
+    for (int poll = 0; poll < 10; poll++) {
+      test_steady_clock.m_uptime += 10;
+      (void)precise();
+    }
+    const auto precise_reads = test_steady_clock.m_reads;
+    for (int poll = 0; poll < 1'000'000; poll++) {
+      (void)coarse();
+    }
+    const auto coarse_reads = test_steady_clock.m_reads - precise_reads;
+
+    // Verify
+    expect(that % 1 == precise.interval());
+    expect(that % 12 == precise_reads);
+    expect(that % adaptive_steady_clock_timeout::max_interval ==
+           coarse.interval());
+    expect(that % coarse_reads < 40);
+  };
+
+  // =============== deadline ===============
+
+  "hal::deadline narrows for sub-operations"_test = []() {
+    using namespace std::literals;
+    // Setup
+    manual_steady_clock test_steady_clock;
+    test_steady_clock.m_uptime = 1'000;
+    const tick_converter converter(test_steady_clock);
+    auto outer = create_deadline(test_steady_clock, converter, 10ms);
+
+    // Exercise
+    const auto first_half = outer.split(1, 2);
+    const auto short_step = outer.within(converter, 2ms);
+    const auto long_step = outer.within(1s);
+    const auto whole = outer.split(3, 2);
+    const auto unchanged = outer.split(1, 0);
+    test_steady_clock.m_uptime = 12'000;
+    const auto after_expired = outer.split(1, 2);
+
+    // Verify
+    expect(that % 11'000 == outer.ticks());
+    expect(that % 6'000 == first_half.ticks());
+    expect(that % 3'000 == short_step.ticks());
+    expect(that % 11'000 == long_step.ticks());
+    expect(that % 11'000 == whole.ticks());
+    expect(that % 11'000 == unchanged.ticks());
+    expect(that % 11'000 == after_expired.ticks());
+    expect(that % &test_steady_clock == &first_half.clock());
+  };
+
+  "hal::deadline reads the clock once per check"_test = []() {
+    using namespace std::literals;
+    // Setup
+    manual_steady_clock test_steady_clock;
+    auto outer = create_deadline(test_steady_clock, 10ms);
+    auto inner = earliest(outer.split(1, 2), outer.within(8ms), outer);
+    const auto reads_before = test_steady_clock.m_reads;
+
+    // Exercise
+    int checks = 0;
+    while (inner()) {
+      test_steady_clock.m_uptime += 1'000;
+      checks++;
+    }
+    const auto reads = test_steady_clock.m_reads - reads_before;
+    const auto remaining_after = inner.remaining();
+    test_steady_clock.m_uptime = 9'500;
+    const auto remaining_outer = outer.remaining();
+
+    // Verify
+    expect(that % 5'000 == inner.ticks());
+    expect(that % 5 == checks);
+    expect(that % 6 == reads);
+    expect(that % 0 == remaining_after);
+    expect(that % 500 == remaining_outer);
+  };
+}
 }  // namespace hal
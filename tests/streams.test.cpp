@@ -14,6 +14,8 @@
 
 #include <libhal-util/streams.hpp>
 
+#include <limits>
+
 #include <libhal-util/as_bytes.hpp>
 #include <libhal-util/timeout.hpp>
 
@@ -259,6 +261,184 @@ void parse_stream_test()
   };
 };
 
+// =============================================================================
+//
+//                          |  parse_number<T> Stream  |
+//
+// =============================================================================
+void parse_number_stream_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "[parse_number<std::int32_t>] negative number"_test = []() {
+    // Setup
+    std::string_view digits_in_between = "temp=-273x";
+    auto digits_span = hal::as_bytes(digits_in_between);
+    hal::stream_parse_number<std::int32_t> parse_int;
+
+    // Exercise
+    auto remaining = digits_span | parse_int;
+
+    // Verify
+    expect(that % work_state::finished == parse_int.state());
+    expect(that % -273 == parse_int.value());
+    expect(that % digits_span.subspan(digits_in_between.find('x')).data() ==
+           remaining.data());
+  };
+
+  "[parse_number<std::uint64_t>] long number across two blocks"_test = []() {
+    // Setup
+    std::array<std::string_view, 2> halves = { "ab123456789", "0123456789c" };
+    auto span0 = hal::as_bytes(halves[0]);
+    auto span1 = hal::as_bytes(halves[1]);
+    hal::stream_parse_number<std::uint64_t> parse_int;
+
+    // Exercise
+    auto remaining0 = span0 | parse_int;
+    auto remaining1 = span1 | parse_int;
+
+    // Verify
+    expect(that % work_state::finished == parse_int.state());
+    expect(that % 1234567890123456789ULL == parse_int.value());
+    expect(that % 0 == remaining0.size());
+    expect(that % 1 == remaining1.size());
+    expect(that % &span1.back() == remaining1.data());
+  };
+
+  "[parse_number<std::uint8_t>] overflow"_test = []() {
+    // Setup
+    std::string_view digits_in_between = "a256b";
+    auto digits_span = hal::as_bytes(digits_in_between);
+    hal::stream_parse_number<std::uint8_t> parse_int;
+
+    // Exercise
+    auto remaining = digits_span | parse_int;
+
+    // Verify
+    expect(that % work_state::failed == parse_int.state());
+    expect(that % digits_span.subspan(digits_in_between.find('6')).data() ==
+           remaining.data());
+  };
+
+  "[parse_number<std::uint64_t>] maximum value across two blocks"_test =
+    []() {
+      // Setup
+      std::array<std::string_view, 2> halves = { "1844", "6744073709551615x" };
+      auto span0 = hal::as_bytes(halves[0]);
+      auto span1 = hal::as_bytes(halves[1]);
+      hal::stream_parse_number<std::uint64_t> parse_int;
+
+      // Exercise
+      [[maybe_unused]] auto remaining0 = span0 | parse_int;
+      auto remaining1 = span1 | parse_int;
+
+      // Verify
+      expect(that % work_state::finished == parse_int.state());
+      expect(that % std::numeric_limits<std::uint64_t>::max() ==
+             parse_int.value());
+      expect(that % &span1.back() == remaining1.data());
+    };
+
+  "[parse_number<std::uint64_t>] overflow across two blocks"_test = []() {
+    // Setup
+    std::array<std::string_view, 2> wrapping = { "1844", "6744073799999999x" };
+    std::array<std::string_view, 2> one_past = { "1844", "6744073709551616x" };
+    hal::stream_parse_number<std::uint64_t> parse_wrapping;
+    hal::stream_parse_number<std::uint64_t> parse_one_past;
+    auto one_past_span = hal::as_bytes(one_past[1]);
+
+    // Exercise
+    [[maybe_unused]] auto remaining0 =
+      hal::as_bytes(wrapping[0]) | parse_wrapping;
+    [[maybe_unused]] auto remaining1 =
+      hal::as_bytes(wrapping[1]) | parse_wrapping;
+    [[maybe_unused]] auto remaining2 =
+      hal::as_bytes(one_past[0]) | parse_one_past;
+    auto remaining3 = one_past_span | parse_one_past;
+
+    // Verify
+    expect(that % work_state::failed == parse_wrapping.state());
+    expect(that % work_state::failed == parse_one_past.state());
+    expect(that % &one_past_span[one_past[1].size() - 2] ==
+           remaining3.data());
+  };
+
+  "[parse_number<std::int64_t>] minimum value"_test = []() {
+    // Setup
+    std::string_view digits_in_between = "-9223372036854775808,";
+    auto digits_span = hal::as_bytes(digits_in_between);
+    hal::stream_parse_number<std::int64_t> parse_int;
+
+    // Exercise
+    [[maybe_unused]] auto remaining = digits_span | parse_int;
+
+    // Verify
+    expect(that % work_state::finished == parse_int.state());
+    expect(that % std::numeric_limits<std::int64_t>::min() ==
+           parse_int.value());
+  };
+
+  "[parse_number<std::uint32_t, 16>] hex with prefix"_test = []() {
+    // Setup
+    std::string_view digits_in_between = "pos=0x1fA9;";
+    auto digits_span = hal::as_bytes(digits_in_between);
+    hal::stream_parse_number<std::uint32_t, 16> parse_hex;
+
+    // Exercise
+    auto remaining = digits_span | parse_hex;
+
+    // Verify
+    expect(that % work_state::finished == parse_hex.state());
+    expect(that % 0x1FA9 == parse_hex.value());
+    expect(that % digits_span.subspan(digits_in_between.find(';')).data() ==
+           remaining.data());
+  };
+
+  "[parse_number<double>] fixed point number"_test = []() {
+    // Setup
+    std::string_view sentence = "$GPGGA,4807.038,N";
+    auto sentence_span = hal::as_bytes(sentence);
+    hal::stream_parse_number<double> parse_float;
+
+    // Exercise
+    auto remaining = sentence_span | parse_float;
+
+    // Verify
+    expect(that % work_state::finished == parse_float.state());
+    expect(that % 4807.037 < parse_float.value());
+    expect(that % 4807.039 > parse_float.value());
+    expect(that % sentence_span.subspan(sentence.rfind(',')).data() ==
+           remaining.data());
+  };
+
+  "[parse_number<float>] leading decimal point"_test = []() {
+    // Setup
+    hal::stream_parse_number<float> positive;
+    hal::stream_parse_number<float> negative;
+    hal::stream_parse_number<float> separated;
+    hal::stream_parse_number<float> split;
+
+    // Exercise
+    hal::as_bytes(".5,"sv) | positive;
+    hal::as_bytes("-.25,"sv) | negative;
+    // Neither the '-' nor the '.' are directly before the digits
+    hal::as_bytes("-. 5,"sv) | separated;
+    hal::as_bytes("-."sv) | split;
+    hal::as_bytes("75;"sv) | split;
+
+    // Verify
+    expect(that % work_state::finished == positive.state());
+    expect(that % 0.5f == positive.value());
+    expect(that % work_state::finished == negative.state());
+    expect(that % -0.25f == negative.value());
+    expect(that % work_state::finished == separated.state());
+    expect(that % 5.0f == separated.value());
+    expect(that % work_state::finished == split.state());
+    expect(that % -0.75f == split.value());
+  };
+};
+
 // =============================================================================
 //
 //                               |  Find Stream  |
@@ -370,6 +550,92 @@ void find_stream_test()
   };
 };
 
+// =============================================================================
+//
+//                             |  Find Any Stream  |
+//
+// =============================================================================
+namespace {
+constexpr std::array<std::string_view, 4> modem_responses{ "OK",
+                                                           "ERROR",
+                                                           "+CME ERROR",
+                                                           "RING" };
+constexpr hal::find_any_automaton<modem_responses.size(),
+                                  hal::find_any_state_count(modem_responses)>
+  modem_automaton(modem_responses);
+}  // namespace
+
+void find_any_stream_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "[find_any] normal usage"_test = []() {
+    // Setup
+    std::string_view str = "AT+CSQ\r\n+CME ERROR: 10\r\n";
+    auto span = hal::as_bytes(str);
+    hal::stream_find_any finder(modem_automaton);
+
+    // Exercise
+    auto remaining = span | finder;
+
+    // Verify
+    expect(that % work_state::finished == finder.state());
+    expect(that % 2 == finder.pattern().value());
+    expect(that % span.subspan(str.find(':')).data() == remaining.data());
+  };
+
+  "[find_any] pattern split across chunks"_test = []() {
+    // Setup
+    std::array<std::string_view, 2> chunks = { "\r\nRI", "NG\r\n" };
+    auto span0 = hal::as_bytes(chunks[0]);
+    auto span1 = hal::as_bytes(chunks[1]);
+    hal::stream_find_any finder(modem_automaton);
+
+    // Exercise
+    auto remaining0 = span0 | finder;
+    auto state0 = finder.state();
+    auto remaining1 = span1 | finder;
+
+    // Verify
+    expect(that % work_state::in_progress == state0);
+    expect(that % 0 == remaining0.size());
+    expect(that % work_state::finished == finder.state());
+    expect(that % 3 == finder.pattern().value());
+    expect(that % 2 == remaining1.size());
+  };
+
+  "[find_any] overlapping patterns"_test = []() {
+    // Setup
+    std::string_view str = "EERRORR";
+    auto span = hal::as_bytes(str);
+    hal::stream_find_any finder(modem_automaton);
+
+    // Exercise
+    auto remaining = span | finder;
+
+    // Verify
+    expect(that % work_state::finished == finder.state());
+    expect(that % 1 == finder.pattern().value());
+    expect(that % 1 == remaining.size());
+  };
+
+  "[find_any] nothing"_test = []() {
+    // Setup
+    std::string_view str = "O K ERR OR";
+    auto span = hal::as_bytes(str);
+    hal::stream_find_any finder(modem_automaton);
+
+    // Exercise
+    auto remaining = span | finder;
+
+    // Verify
+    expect(that % work_state::in_progress == finder.state());
+    expect(!finder.pattern().has_value());
+    expect(that % 0 == remaining.size());
+  };
+};
+
 // =============================================================================
 //
 //                             |  fill_upto Stream  |
@@ -443,6 +709,76 @@ void fill_upto_stream_test()
   };
 };
 
+// =============================================================================
+//
+//                             |  Pipeline Stream  |
+//
+// =============================================================================
+void pipeline_stream_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "[pipeline] normal usage"_test = []() {
+    // Setup
+    std::string_view str = "HTTP/1.1 200 OK\r\nContent-Length: 1023\r\n";
+    auto span = hal::as_bytes(str);
+    hal::stream_find find_length(hal::as_bytes("Content-Length: "sv));
+    hal::stream_parse<std::uint32_t> parse_length;
+    hal::stream_pipeline pipeline(find_length, parse_length);
+
+    // Exercise
+    auto remaining = span | pipeline;
+
+    // Verify
+    expect(that % work_state::finished == pipeline.state());
+    expect(that % 2 == pipeline.stage());
+    expect(that % 1023 == parse_length.value());
+    expect(that % span.subspan(str.rfind('\r')).data() == remaining.data());
+  };
+
+  "[pipeline] across chunks"_test = []() {
+    // Setup
+    std::array<std::string_view, 3> chunks = { "xxConte",
+                                               "nt-Length: 1",
+                                               "23\r" };
+    hal::stream_find find_length(hal::as_bytes("Content-Length: "sv));
+    hal::stream_parse<std::uint32_t> parse_length;
+    hal::stream_pipeline pipeline(find_length, parse_length);
+
+    // Exercise
+    auto remaining0 = hal::as_bytes(chunks[0]) | pipeline;
+    auto stage0 = pipeline.stage();
+    auto remaining1 = hal::as_bytes(chunks[1]) | pipeline;
+    auto stage1 = pipeline.stage();
+    auto remaining2 = hal::as_bytes(chunks[2]) | pipeline;
+
+    // Verify
+    expect(that % 0 == stage0);
+    expect(that % 1 == stage1);
+    expect(that % 0 == remaining0.size());
+    expect(that % 0 == remaining1.size());
+    expect(that % 1 == remaining2.size());
+    expect(that % work_state::finished == pipeline.state());
+    expect(that % 123 == parse_length.value());
+  };
+
+  "[pipeline] failed stage"_test = []() {
+    // Setup
+    std::string_view str = "ab:999;";
+    hal::stream_skip skip(2);
+    hal::stream_parse_number<std::uint8_t> parse_byte;
+    hal::stream_pipeline pipeline(skip, parse_byte);
+
+    // Exercise
+    [[maybe_unused]] auto remaining = hal::as_bytes(str) | pipeline;
+
+    // Verify
+    expect(that % work_state::failed == pipeline.state());
+    expect(that % 1 == pipeline.stage());
+  };
+};
+
 // =============================================================================
 //
 //                               |  Multi Stream Test  |
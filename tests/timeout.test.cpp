@@ -194,5 +194,108 @@ void timeout_test()
     expect(that % true == hal::failed(always_failed_obj));
     expect(that % false == hal::failed(always_finished_obj));
   };
+
+  "hal::iteration_timeout"_test = []() {
+    // Setup
+    int counts = 0;
+    std::function<result<work_state>()> callback = [&counts]() {
+      counts++;
+      return work_state::in_progress;
+    };
+    iteration_timeout expired(0);
+
+    // Exercise
+    auto result = hal::try_until(callback, iteration_timeout(5));
+    const auto expired_status = expired();
+
+    // Verify
+    expect(!bool{ result });
+    expect(that % 6 == counts);
+    expect(!bool{ expired_status });
+    expect(that % 0 == expired.remaining());
+  };
+
+  "hal::amortize(timeout, interval)"_test = []() {
+    // Setup
+    int checks = 0;
+    auto counting_timeout = [&checks]() mutable -> status {
+      checks++;
+      if (checks >= 3) {
+        return hal::new_error(std::errc::timed_out);
+      }
+      return {};
+    };
+    int counts = 0;
+    std::function<result<work_state>()> callback = [&counts]() {
+      counts++;
+      return work_state::in_progress;
+    };
+    auto every_call = hal::amortize(counting_timeout, 0);
+
+    // Exercise
+    auto result = hal::try_until(callback, hal::amortize(counting_timeout, 4));
+    const auto checks_amortized = checks;
+    const auto calls_amortized = counts;
+    checks = 0;
+    const auto first = every_call();
+    const auto second = every_call();
+    const auto third = every_call();
+    const auto after_expired = every_call();
+
+    // Verify
+    expect(!bool{ result });
+    expect(that % 3 == checks_amortized);
+    expect(that % 12 == calls_amortized);
+    expect(bool{ first });
+    expect(bool{ second });
+    expect(!bool{ third });
+    expect(!bool{ after_expired });
+    expect(that % 3 == checks);
+  };
+
+  "hal::any_of(timeouts...)"_test = []() {
+    // Setup
+    int second_checks = 0;
+    auto second = [&second_checks]() mutable -> status {
+      second_checks++;
+      return {};
+    };
+    auto combined = hal::any_of(iteration_timeout(2), second);
+
+    // Exercise
+    const auto first_check = combined();
+    const auto second_check = combined();
+    const auto third_check = combined();
+
+    // Verify
+    expect(bool{ first_check });
+    expect(bool{ second_check });
+    expect(!bool{ third_check });
+    expect(that % 2 == second_checks);
+  };
+
+  "hal::all_of(timeouts...)"_test = []() {
+    // Setup
+    int counts = 0;
+    std::function<result<work_state>()> callback = [&counts]() {
+      counts++;
+      return work_state::in_progress;
+    };
+    auto combined =
+      hal::all_of(iteration_timeout(2), iteration_timeout(5), never_timeout());
+    auto finite = hal::all_of(iteration_timeout(2), iteration_timeout(5));
+
+    // Exercise
+    for (int check = 0; check < 10; check++) {
+      (void)combined();
+    }
+    const auto never_expires = combined();
+    auto result = hal::try_until(callback, finite);
+
+    // Verify
+    expect(bool{ never_expires });
+    expect(!bool{ result });
+    expect(that % 6 == counts);
+  };
 };
 }  // namespace hal
@@ -0,0 +1,206 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/timer_wheel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+/// One tick per millisecond
+struct manual_clock : public hal::steady_clock
+{
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = m_uptime };
+  }
+
+  std::uint64_t m_uptime = 0;
+};
+}  // namespace
+
+void timer_wheel_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+  using wheel_t = timer_wheel<3, 8>;
+
+  "hal::timer_wheel expires timers in order"_test = []() {
+    // Setup
+    manual_clock clock;
+    wheel_t wheel(clock, 1ms);
+    std::vector<int> fired;
+    wheel_t::timer first([&fired]() { fired.push_back(1); });
+    wheel_t::timer second([&fired]() { fired.push_back(2); });
+    wheel_t::timer third([&fired]() { fired.push_back(3); });
+
+    // Exercise
+    wheel.schedule(third, 100ms);
+    wheel.schedule(first, 5ms);
+    wheel.schedule(second, 20ms);
+    clock.m_uptime = 4;
+    const auto expired_early = wheel.poll();
+    clock.m_uptime = 20;
+    const auto expired_two = wheel.poll();
+    const auto size_after_two = wheel.size();
+    clock.m_uptime = 1000;
+    const auto expired_last = wheel.poll();
+
+    // Verify
+    expect(that % 0 == expired_early);
+    expect(that % 2 == expired_two);
+    expect(that % 1 == size_after_two);
+    expect(that % 1 == expired_last);
+    expect(std::vector<int>{ 1, 2, 3 } == fired);
+    expect(that % !first.active());
+    expect(that % 0 == wheel.size());
+  };
+
+  "hal::timer_wheel cancel and destruction"_test = []() {
+    // Setup
+    manual_clock clock;
+    wheel_t wheel(clock, 1ms);
+    int fired = 0;
+    wheel_t::timer cancelled([&fired]() { fired++; });
+
+    // Exercise
+    wheel.schedule(cancelled, 10ms);
+    {
+      wheel_t::timer destroyed([&fired]() { fired++; });
+      wheel.schedule(destroyed, 10ms);
+    }
+    const auto size_before_cancel = wheel.size();
+    cancelled.cancel();
+    clock.m_uptime = 50;
+    wheel.poll();
+
+    // Verify
+    expect(that % 1 == size_before_cancel);
+    expect(that % 0 == fired);
+    expect(that % 0 == wheel.size());
+  };
+
+  "hal::timer_wheel handler can reschedule itself"_test = []() {
+    // Setup
+    manual_clock clock;
+    wheel_t wheel(clock, 1ms);
+    int fired = 0;
+    std::unique_ptr<wheel_t::timer> periodic;
+    periodic = std::make_unique<wheel_t::timer>([&]() {
+      fired++;
+      wheel.schedule(*periodic, 10ms);
+    });
+
+    // Exercise
+    wheel.schedule(*periodic, 10ms);
+    for (std::uint64_t tick = 1; tick <= 100; tick++) {
+      clock.m_uptime = tick;
+      wheel.poll();
+    }
+
+    // Verify
+    expect(that % 10 == fired);
+    expect(that % periodic->active());
+  };
+
+  "hal::timer_wheel matches a reference model"_test = []() {
+    // Setup
+    // A 3 level, 8 slot wheel covers 512 ticks, so delays up to 2000 ticks
+    // also exercise timers parked beyond the range of the wheel.
+    static constexpr size_t timer_count = 500;
+    manual_clock clock;
+    wheel_t wheel(clock, 1ms);
+    std::mt19937 random(12345);
+    std::vector<std::uint64_t> deadline(timer_count, 0);
+    std::vector<std::uint64_t> fired_at(timer_count, 0);
+    std::vector<std::unique_ptr<wheel_t::timer>> timers;
+    std::vector<std::uint64_t> polled_at;
+    bool fired_twice = false;
+
+    for (size_t index = 0; index < timer_count; index++) {
+      timers.push_back(std::make_unique<wheel_t::timer>([&, index]() {
+        fired_twice = fired_twice || fired_at[index] != 0;
+        fired_at[index] = clock.m_uptime;
+      }));
+    }
+
+    // Exercise
+    for (size_t index = 0; index < timer_count; index++) {
+      clock.m_uptime += random() % 3;
+      const auto delay = random() % 2000;
+      wheel.schedule(*timers[index], std::chrono::milliseconds(delay));
+      deadline[index] = clock.m_uptime + delay;
+      wheel.poll();
+      polled_at.push_back(clock.m_uptime);
+    }
+    // Cancel every seventh timer that has not fired yet
+    for (size_t index = 0; index < timer_count; index += 7) {
+      if (timers[index]->active()) {
+        timers[index]->cancel();
+        deadline[index] = 0;
+      }
+    }
+    while (wheel.size() != 0) {
+      clock.m_uptime += 1 + random() % 20;
+      wheel.poll();
+      polled_at.push_back(clock.m_uptime);
+    }
+
+    // Verify
+    // Each timer must fire on the first poll at or after its deadline
+    bool on_time = true;
+    for (size_t index = 0; index < timer_count; index++) {
+      if (deadline[index] == 0) {
+        continue;
+      }
+      const auto first_poll = *std::lower_bound(
+        polled_at.begin(), polled_at.end(), deadline[index]);
+      on_time = on_time && fired_at[index] == first_poll;
+    }
+    expect(that % !fired_twice);
+    expect(that % on_time);
+  };
+
+  "hal::timer_wheel single level parks long timers"_test = []() {
+    // Setup
+    manual_clock clock;
+    timer_wheel<1, 4> wheel(clock, 1ms);
+    std::uint64_t fired_at = 0;
+    timer_wheel<1, 4>::timer long_timer(
+      [&fired_at, &clock]() { fired_at = clock.m_uptime; });
+
+    // Exercise
+    wheel.schedule(long_timer, 10ms);
+    for (std::uint64_t tick = 1; tick <= 20; tick++) {
+      clock.m_uptime = tick;
+      wheel.poll();
+    }
+
+    // Verify
+    expect(that % 10 == fired_at);
+  };
+}
+}  // namespace hal
@@ -0,0 +1,235 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/virtual_steady_clock.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include <libhal-util/timeout.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+void virtual_steady_clock_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::virtual_steady_clock steps per reading"_test = []() {
+    // Setup
+    virtual_steady_clock clock(1'000.0f, 5);
+    clock.set_step(1ms);
+
+    // Exercise
+    const auto first = clock.uptime().ticks;
+    const auto second = clock.uptime().ticks;
+    hal::delay(clock, 24h);
+
+    // Verify
+    expect(that % 1'000.0f == clock.frequency().operating_frequency);
+    expect(that % 5 == first);
+    expect(that % 6 == second);
+    expect(that % clock.now() >= 7 + 86'400'000ULL);
+    expect(that % clock.now() <= 9 + 86'400'000ULL);
+  };
+
+  "hal::virtual_steady_clock events fire in order"_test = []() {
+    // Setup
+    virtual_steady_clock clock(1'000'000.0f);
+    std::string log;
+    std::array<std::uint64_t, 3> fired_at{};
+    virtual_steady_clock::event late([&]() {
+      log.push_back('c');
+      fired_at[2] = clock.now();
+    });
+    virtual_steady_clock::event early([&]() {
+      log.push_back('a');
+      fired_at[0] = clock.now();
+    });
+    virtual_steady_clock::event chained([&]() {
+      log.push_back('b');
+      fired_at[1] = clock.now();
+    });
+    virtual_steady_clock::event cancelled([&]() { log.push_back('x'); });
+    virtual_steady_clock::event rescheduling([&]() {
+      log.push_back('a');
+      clock.schedule(chained, 5us);
+    });
+
+    // Exercise
+    clock.schedule(late, 100us);
+    clock.schedule(early, 10us);
+    clock.schedule_at(rescheduling, 10);
+    clock.schedule(cancelled, 50us);
+    cancelled.cancel();
+    clock.advance(50us);
+    const auto scheduled_midway = late.scheduled();
+    const auto ran = clock.run_next_event();
+    const auto ran_when_empty = clock.run_next_event();
+
+    // Verify
+    expect(that % "aabc"s == log);
+    expect(that % 10 == fired_at[0]);
+    expect(that % 15 == fired_at[1]);
+    expect(that % 100 == fired_at[2]);
+    expect(that % scheduled_midway);
+    expect(that % ran);
+    expect(that % !ran_when_empty);
+    expect(that % !late.scheduled());
+    expect(that % 100 == clock.now());
+  };
+
+  "hal::virtual_steady_clock skips to events"_test = []() {
+    // Setup
+    virtual_steady_clock clock(1'000'000.0f);
+    bool replied = false;
+    virtual_steady_clock::event reply([&replied]() { replied = true; });
+    auto wait_for_reply = [&replied]() -> result<work_state> {
+      return replied ? work_state::finished : work_state::in_progress;
+    };
+    clock.skip_to_events(true);
+    clock.set_step(1);
+
+    // Exercise
+    clock.schedule(reply, 250ms);
+    auto state = hal::try_until(wait_for_reply, create_timeout(clock, 1s));
+
+    // Verify
+    expect(that % state.has_value());
+    expect(that % 250'000 == clock.now());
+    expect(that % clock.readings() < 5U);
+  };
+
+  "hal::virtual_steady_clock jitter stays monotonic"_test = []() {
+    // Setup
+    virtual_steady_clock clock(1'000.0f, 100);
+    clock.set_step(10);
+    std::array<std::int64_t, 4> offsets{ 3, -8, -500, 0 };
+    size_t next_offset = 0;
+    clock.set_jitter([&]() { return offsets[next_offset++]; });
+
+    // Exercise
+    std::array<std::uint64_t, 4> readings{};
+    for (auto& reading : readings) {
+      reading = clock.uptime().ticks;
+    }
+    clock.set_jitter({});
+    const auto without_jitter = clock.uptime().ticks;
+
+    // Verify
+    expect(that % 103 == readings[0]);
+    expect(that % 103 == readings[1]);
+    expect(that % 103 == readings[2]);
+    expect(that % 130 == readings[3]);
+    expect(that % 140 == without_jitter);
+  };
+
+  "hal::virtual_steady_clock counter overflow"_test = []() {
+    // Setup
+    virtual_steady_clock clock(1'000.0f, 250);
+    clock.set_step(3);
+    int overflows = 0;
+    clock.set_counter_bits(8, [&overflows]() { overflows++; });
+
+    // Exercise
+    std::array<std::uint64_t, 3> readings{};
+    for (auto& reading : readings) {
+      reading = clock.uptime().ticks;
+    }
+    clock.advance(1'000);
+    const auto after_jump = clock.uptime().ticks;
+
+    // Verify
+    expect(that % 250 == readings[0]);
+    expect(that % 253 == readings[1]);
+    expect(that % 0 == readings[2]);
+    expect(that % 235 == after_jump);
+    expect(that % 4 == overflows);
+  };
+
+  "hal::virtual_steady_clock wraps past the 64-bit limit"_test = []() {
+    // Setup
+    constexpr auto start = std::numeric_limits<std::uint64_t>::max() - 15;
+    virtual_steady_clock clock(1'000.0f, start);
+    clock.set_step(10);
+    std::uint64_t fired_at = 0;
+    virtual_steady_clock::event across([&]() { fired_at = clock.now(); });
+    clock.schedule(across, 25ms);
+
+    // Exercise
+    std::array<std::uint64_t, 4> readings{};
+    for (auto& reading : readings) {
+      reading = clock.uptime().ticks;
+    }
+    const auto before_delay = clock.now();
+    hal::delay(clock, 1s);
+
+    // Verify
+    expect(that % start == readings[0]);
+    expect(that % (start + 10) == readings[1]);
+    expect(that % 4 == readings[2]);
+    expect(that % 14 == readings[3]);
+    expect(that % 9 == fired_at);
+    expect(that % 24 == before_delay);
+    expect(that % clock.now() >= before_delay + 1'000);
+  };
+
+  "hal::virtual_steady_clock jitter across the 64-bit limit"_test = []() {
+    // Setup
+    constexpr auto start = std::numeric_limits<std::uint64_t>::max() - 5;
+    virtual_steady_clock clock(1'000.0f, start);
+    std::int64_t offset = 10;
+    clock.set_jitter([&offset]() { return offset; });
+
+    // Exercise
+    const auto wrapped = clock.uptime().ticks;
+    offset = 0;
+    const auto behind = clock.uptime().ticks;
+    clock.advance(20);
+    const auto advanced = clock.uptime().ticks;
+
+    // Verify
+    expect(that % 4 == wrapped);
+    expect(that % 4 == behind);
+    expect(that % 14 == advanced);
+  };
+
+  "hal::virtual_steady_clock counter overflow across the 64-bit limit"_test =
+    []() {
+      // Setup
+      constexpr auto start = std::numeric_limits<std::uint64_t>::max() - 15;
+      virtual_steady_clock clock(1'000.0f, start);
+      clock.set_step(10);
+      int overflows = 0;
+      clock.set_counter_bits(4, [&overflows]() { overflows++; });
+
+      // Exercise
+      std::array<std::uint64_t, 4> readings{};
+      for (auto& reading : readings) {
+        reading = clock.uptime().ticks;
+      }
+
+      // Verify
+      expect(that % 0 == readings[0]);
+      expect(that % 10 == readings[1]);
+      expect(that % 4 == readings[2]);
+      expect(that % 14 == readings[3]);
+      expect(that % 1 == overflows);
+    };
+}
+}  // namespace hal
@@ -0,0 +1,246 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-util/worker_scheduler.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <libhal-util/timeout.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal {
+namespace {
+/// One tick per millisecond, advanced by one tick on every uptime() call
+struct ticking_clock : public hal::steady_clock
+{
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = m_uptime++ };
+  }
+
+  std::uint64_t m_uptime = 0;
+};
+
+/// Worker that finishes after a number of calls and records each call
+auto counting_worker(std::string& p_log, char p_name, int p_calls)
+{
+  return [&p_log, p_name, p_calls, count = 0]() mutable -> result<work_state> {
+    p_log.push_back(p_name);
+    count++;
+    if (count >= p_calls) {
+      return work_state::finished;
+    }
+    return work_state::in_progress;
+  };
+}
+}  // namespace
+
+void worker_scheduler_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::worker_scheduler round robin in priority order"_test = []() {
+    // Setup
+    std::string log;
+    worker_scheduler scheduler;
+    worker_scheduler::task low(counting_worker(log, 'a', 3), 0);
+    worker_scheduler::task high(counting_worker(log, 'b', 1), 2);
+    worker_scheduler::task also_low(counting_worker(log, 'c', 2), 0);
+
+    // Exercise
+    scheduler.add(low);
+    scheduler.add(high);
+    scheduler.add(also_low);
+    const auto size_before = scheduler.size();
+    const auto completed = scheduler.run_until_idle();
+
+    // Verify
+    expect(that % 3 == size_before);
+    expect(that % 3 == completed);
+    expect(that % "bacaca"s == log);
+    expect(that % 0 == scheduler.size());
+    expect(that % !low.active());
+  };
+
+  "hal::worker_scheduler completion callback"_test = []() {
+    // Setup
+    worker_scheduler scheduler;
+    std::string log;
+    int completions = 0;
+    bool failed_reported = false;
+    bool error_reported = false;
+    worker_scheduler::task finished_task(counting_worker(log, 'a', 1));
+    worker_scheduler::task failed_task(
+      []() -> result<work_state> { return work_state::failed; });
+    worker_scheduler::task error_task([]() -> result<work_state> {
+      return hal::new_error(std::errc::io_error);
+    });
+    finished_task.on_complete(
+      [&completions](result<work_state>) { completions++; });
+    failed_task.on_complete([&](result<work_state> p_result) {
+      failed_reported = p_result && hal::failed(p_result.value());
+    });
+    error_task.on_complete(
+      [&](result<work_state> p_result) { error_reported = !p_result; });
+
+    // Exercise
+    scheduler.add(finished_task);
+    scheduler.add(failed_task);
+    scheduler.add(error_task);
+    const auto completed = scheduler.run_once();
+
+    // Verify
+    expect(that % 3 == completed);
+    expect(that % 1 == completions);
+    expect(that % failed_reported);
+    expect(that % error_reported);
+    expect(that % 0 == scheduler.size());
+  };
+
+  "hal::worker_scheduler deadline"_test = []() {
+    // Setup
+    ticking_clock clock;
+    worker_scheduler scheduler;
+    int calls = 0;
+    bool timed_out = false;
+    worker_scheduler::task stuck([&calls]() -> result<work_state> {
+      calls++;
+      return work_state::in_progress;
+    });
+    stuck.set_deadline(clock, 5ms);
+    stuck.on_complete(
+      [&timed_out](result<work_state> p_result) { timed_out = !p_result; });
+
+    // Exercise
+    scheduler.add(stuck);
+    for (int round = 0; round < 20 && stuck.active(); round++) {
+      scheduler.run_once();
+    }
+
+    // Verify
+    expect(that % timed_out);
+    expect(that % !stuck.active());
+    expect(that % calls >= 4);
+    expect(that % calls < 20);
+  };
+
+  "hal::worker_scheduler idle detection"_test = []() {
+    // Setup
+    worker_scheduler scheduler;
+    bool data_ready = false;
+    worker_scheduler::task waiter([&data_ready]() -> result<work_state> {
+      return data_ready ? work_state::finished : work_state::in_progress;
+    });
+
+    // Exercise
+    const auto idle_when_empty = scheduler.idle();
+    scheduler.add(waiter);
+    const auto idle_after_add = scheduler.idle();
+    scheduler.run_once();
+    const auto idle_after_round = scheduler.idle();
+    scheduler.notify();
+    const auto idle_after_notify = scheduler.idle();
+    data_ready = true;
+    scheduler.run_once();
+
+    // Verify
+    expect(that % idle_when_empty);
+    expect(that % !idle_after_add);
+    expect(that % idle_after_round);
+    expect(that % !idle_after_notify);
+    expect(that % scheduler.idle());
+    expect(that % !waiter.active());
+  };
+
+  "hal::worker_scheduler partial progress is not idle"_test = []() {
+    // Setup
+    // Consumes one buffered byte per round and waits for more once drained,
+    // like a read_into worker reading a message that has not fully arrived
+    worker_scheduler scheduler;
+    std::string buffered = "abcd";
+    std::string consumed;
+    worker_scheduler::task reader([&]() -> result<work_state> {
+      if (!buffered.empty()) {
+        consumed.push_back(buffered.front());
+        buffered.erase(0, 1);
+        reader.mark_progress();
+      }
+      return work_state::in_progress;
+    });
+    scheduler.add(reader);
+
+    // Exercise
+    std::array<bool, 3> idle_while_consuming{};
+    for (auto& idle : idle_while_consuming) {
+      scheduler.run_once();
+      idle = scheduler.idle();
+    }
+    const auto completed = scheduler.run_until_idle();
+
+    // Verify
+    for (const auto idle : idle_while_consuming) {
+      expect(that % !idle);
+    }
+    expect(that % 0 == completed);
+    expect(that % "abcd"s == consumed);
+    expect(that % scheduler.idle());
+    expect(that % reader.active());
+  };
+
+  "hal::worker_scheduler tasks removed during a round"_test = []() {
+    // Setup
+    std::string log;
+    worker_scheduler scheduler;
+    auto victim =
+      std::make_unique<worker_scheduler::task>(counting_worker(log, 'b', 10));
+    worker_scheduler::task cancelled(counting_worker(log, 'c', 10));
+    worker_scheduler::task killer([&]() -> result<work_state> {
+      log.push_back('a');
+      victim.reset();
+      cancelled.cancel();
+      return work_state::finished;
+    });
+    worker_scheduler::task restarted(counting_worker(log, 'd', 1));
+    int restarts = 0;
+    restarted.on_complete([&](result<work_state>) {
+      if (++restarts < 2) {
+        scheduler.add(restarted);
+      }
+    });
+
+    // Exercise
+    scheduler.add(killer);
+    scheduler.add(*victim);
+    scheduler.add(cancelled);
+    scheduler.add(restarted);
+    scheduler.run_until_idle();
+
+    // Verify
+    expect(that % "add"s == log.substr(0, 3));
+    expect(that % 2 == restarts);
+    expect(that % 0 == scheduler.size());
+  };
+}
+}  // namespace hal
@@ -0,0 +1,87 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Decodes messages written by hal::log()
+//
+// Usage:
+//
+//     hal_log_decoder <firmware image> [input]
+//
+// The firmware image is the ELF file or raw binary that was flashed to the
+// device. The input is a file or serial device carrying the log stream and
+// defaults to stdin. Serial devices must already be configured, for example:
+//
+//     stty -F /dev/ttyUSB0 115200 raw
+//     hal_log_decoder app.elf /dev/ttyUSB0
+
+#include <libhal-util/log_decoder.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+int main(int p_argc, char** p_argv)
+{
+  if (p_argc < 2 || p_argc > 3) {
+    std::fprintf(stderr, "usage: %s <firmware image> [input]\n", p_argv[0]);
+    return 1;
+  }
+
+  std::ifstream image_file(p_argv[1], std::ios::binary);
+  if (!image_file) {
+    std::fprintf(stderr, "failed to open firmware image '%s'\n", p_argv[1]);
+    return 1;
+  }
+  const std::vector<hal::byte> image(std::istreambuf_iterator<char>(image_file),
+                                     std::istreambuf_iterator<char>{});
+
+  hal::log_decoder decoder;
+  const auto loaded = decoder.load_records(image);
+  std::fprintf(stderr, "loaded %zu log records\n", loaded);
+
+  int input = STDIN_FILENO;
+  if (p_argc == 3) {
+    input = ::open(p_argv[2], O_RDONLY | O_NOCTTY);
+    if (input < 0) {
+      std::fprintf(stderr, "failed to open input '%s'\n", p_argv[2]);
+      return 1;
+    }
+  }
+
+  // read() returns as soon as any bytes arrive, so messages are printed with
+  // as little latency as the device allows.
+  std::array<hal::byte, 4096> buffer{};
+  while (true) {
+    const auto count = ::read(input, buffer.data(), buffer.size());
+    if (count <= 0) {
+      break;
+    }
+    decoder.feed(std::span(buffer.data(), static_cast<size_t>(count)));
+    while (auto message = decoder.next()) {
+      std::printf("%s\n", message->c_str());
+    }
+    std::fflush(stdout);
+  }
+
+  if (input != STDIN_FILENO) {
+    ::close(input);
+  }
+
+  return 0;
+}